@@ -15,6 +15,8 @@
 
 #ifndef DISTRIBUTED_OBJECT_IMPL_H
 #define DISTRIBUTED_OBJECT_IMPL_H
+#include <atomic>
+#include <set>
 #include <string>
 
 #include "distributed_object.h"
@@ -23,6 +25,12 @@
 namespace OHOS::ObjectStore {
 class DistributedObjectImpl : public DistributedObject {
 public:
+    // complex values from this size on are stored as content defined chunks and a manifest of them,
+    // while every online peer assembles manifests; chunks stay until the session is deleted
+    static constexpr size_t CHUNK_THRESHOLD = 64 * 1024;
+    // SIZE_MAX stores every value in one piece, for comparisons; readers take both forms regardless
+    static void SetChunkThreshold(size_t bytes);
+
     DistributedObjectImpl(const std::string &sessionId, FlatObjectStore *flatObjectStore);
     ~DistributedObjectImpl();
     uint32_t PutDouble(const std::string &key, double value) override;
@@ -33,10 +41,32 @@ public:
     uint32_t GetString(const std::string &key, std::string &value) override;
     uint32_t PutComplex(const std::string &key, const std::vector<uint8_t> &value) override;
     uint32_t GetComplex(const std::string &key, std::vector<uint8_t> &value) override;
+    uint32_t PutComplex(
+        const std::string &key, const std::vector<uint8_t> &head, const uint8_t *tail, size_t size) override;
+    uint32_t GetComplex(const std::string &key, std::vector<uint8_t> &value, size_t &offset) override;
     std::string &GetSessionId() override;
     uint32_t GetType(const std::string &key, Type &type) override;
+    uint32_t PutBatch(const std::map<std::string, FieldValue> &fields) override;
+    uint32_t PutBatch(
+        const std::map<std::string, FieldValue> &fields, const std::vector<std::string> &removed) override;
+    uint32_t GetAll(std::map<std::string, FieldValue> &fields) override;
+    uint32_t PutRecord(const std::string &key, const std::vector<uint8_t> &record) override;
+    uint32_t GetRecord(const std::string &key, std::vector<uint8_t> &record) override;
+    uint32_t GetAll(const std::string &prefix, std::map<std::string, FieldValue> &fields) override;
 
 private:
+    static Bytes Encode(const FieldValue &value);
+    static uint32_t Decode(const Bytes &data, FieldValue &value);
+    // SIZE_MAX unless every online peer assembles manifests
+    static size_t ChunkThreshold();
+    // puts the records in one batch with the deletes of removed, large complex ones as chunks
+    uint32_t PutRecords(std::map<std::string, Bytes> &records, const std::vector<std::string> &removed = {});
+    std::set<std::string> StoredChunks(const std::string &fieldKey);
+    // the value of a manifest, chunks come from records or else from the store
+    uint32_t Assemble(const Bytes &manifest, const std::map<std::string, Bytes> *records, Bytes &value);
+
+    static std::atomic<size_t> chunkThreshold_;
+
     std::string sessionId_;
     FlatObjectStore *flatObjectStore_ = nullptr;
 };
@@ -36,12 +36,17 @@ public:
     ~DistributedObjectStoreImpl() override;
     uint32_t Get(const std::string &sessionId, DistributedObject *object) override;
     DistributedObject *CreateObject(const std::string &sessionId) override;
+    DistributedObject *CreateObject(const std::string &sessionId, const ObjectOptions &options) override;
     uint32_t DeleteObject(const std::string &sessionId) override;
     uint32_t Watch(DistributedObject *object, std::shared_ptr<ObjectWatcher> watcher) override;
     uint32_t UnWatch(DistributedObject *object) override;
     uint32_t SetStatusNotifier(std::shared_ptr<StatusNotifier> notifier) override;
     void TriggerSync() override;
     void TriggerRestore(std::function<void()> notifier) override;
+    ObjectStoreStatistics GetStatistics() override;
+    void SetTraceEnabled(bool enabled) override;
+    std::string ExportTrace() override;
+    uint64_t SetMemoryBudget(uint64_t bytes) override;
 
 private:
     DistributedObject *CacheObject(const std::string &sessionId, FlatObjectStore *flatObjectStore);
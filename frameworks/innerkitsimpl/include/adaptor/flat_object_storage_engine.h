@@ -16,9 +16,14 @@
 #ifndef FLAT_OBJECT_STORAGE_ENGINE_H
 #define FLAT_OBJECT_STORAGE_ENGINE_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <map>
+#include <mutex>
 #include <shared_mutex>
+#include <thread>
 #include <vector>
 
 #include "kv_store_delegate_manager.h"
@@ -32,23 +37,117 @@ public:
     uint32_t Open(const std::string &bundleName) override;
     uint32_t Close() override;
     uint32_t DeleteTable(const std::string &key) override;
-    uint32_t CreateTable(const std::string &key) override;
+    uint32_t CreateTable(const std::string &key, const ObjectOptions &options) override;
     uint32_t GetTable(const std::string &key, std::map<std::string, Value> &result) override;
-    uint32_t UpdateItem(const std::string &key, const std::string &itemKey, Value &value) override;
+    uint32_t GetItems(
+        const std::string &key, const std::string &prefix, std::map<std::string, Value> &result) override;
+    uint32_t UpdateItem(const std::string &key, const std::string &itemKey, const Value &value) override;
+    uint32_t UpdateItems(const std::string &key, const std::map<std::string, Value> &data,
+        const std::vector<std::string> &removed) override;
     uint32_t GetItem(const std::string &key, const std::string &itemKey, Value &value) override;
+    uint32_t DeleteItems(const std::string &key, const std::vector<std::string> &itemKeys) override;
     uint32_t RegisterObserver(const std::string &key, std::shared_ptr<TableWatcher> watcher) override;
     uint32_t UnRegisterObserver(const std::string &key) override;
     uint32_t SetStatusNotifier(std::shared_ptr<StatusWatcher> watcher) override;
     uint32_t SyncAllData(const std::string &sessionId,
-        const std::function<void(const std::map<std::string, DistributedDB::DBStatus> &)> &onComplete);
-    bool isOpened_ = false;
+        const std::function<void(const std::map<std::string, DistributedDB::DBStatus> &)> &onComplete) override;
+    uint64_t SetMemoryBudget(uint64_t bytes) override;
+    void GetUsage(std::map<std::string, SessionStatistics> &usage) override;
 
 private:
+    static constexpr const char *MEMORY_DATA_DIR = "/data/log";
+    static constexpr const char *DURABLE_DATA_DIR = "/data/storage/el2/database/distributedobject";
+    // puts of durable tables wait this long for more puts to share their disk write
+    static constexpr std::chrono::milliseconds WRITE_BEHIND_DELAY = std::chrono::milliseconds(20);
+    // a table with this many items buffered is written at once, also the size of one PutBatch or
+    // DeleteBatch, which KvStoreNbDelegate caps at 128 entries
+    static constexpr size_t WRITE_BEHIND_BATCH = 64;
+    // a table used more recently than this is never evicted
+    static constexpr std::chrono::seconds EVICT_MIN_IDLE = std::chrono::seconds(10);
+
+    // keeps usage_ up to date with local and remote changes of one table
+    class UsageObserver : public DistributedDB::KvStoreObserver {
+    public:
+        UsageObserver(FlatObjectStorageEngine &engine, const std::string &key) : engine_(engine), key_(key)
+        {
+        }
+        void OnChange(const DistributedDB::KvStoreChangedData &data) override;
+
+    private:
+        FlatObjectStorageEngine &engine_;
+        std::string key_;
+    };
+    struct Table {
+        ObjectOptions options;
+        std::shared_ptr<UsageObserver> observer;
+        std::chrono::steady_clock::time_point lastUsed;
+        bool spilled = false;  // closed to free memory, opened again on its next use
+    };
+    struct Item {
+        uint64_t size = 0;
+        size_t digest = 0;  // of the value, only to tell quickly that a put changes it
+    };
+    struct Usage {
+        std::map<std::string, Item> items;
+        uint64_t bytes = 0;
+        uint64_t suppressed = 0;
+        bool resident = true;
+        void Set(const std::string &itemKey, const Value &value);
+    };
+
+    // the callers hold operationMutex_
+    uint32_t OpenDelegate(const std::string &key, Table &table);
+    uint32_t CloseDelegate(const std::string &key, Table &table);
+    DistributedDB::KvStoreNbDelegate *GetDelegate(const std::string &key);
+    uint32_t Spill(const std::string &key, Table &table);
+    uint64_t EnforceBudget(const std::string &current);
+    uint32_t SyncLocked(const std::string &sessionId,
+        const std::function<void(const std::map<std::string, DistributedDB::DBStatus> &)> &onComplete);
+    std::function<void(const std::map<std::string, DistributedDB::DBStatus> &)> PullReporter(
+        const std::string &key);
+
+    void SeedUsage(const std::string &key, const std::vector<DistributedDB::Entry> &entries);
+    void OnUsageChanged(const std::string &key, const DistributedDB::KvStoreChangedData &data);
+    void OnWritten(const std::string &key, const std::map<std::string, Value> &data);
+    void SetResident(const std::string &key, bool resident);
+    // the callers hold operationMutex_, true if itemKey holds value already, counted as suppressed
+    bool IsUnchanged(const std::string &key, DistributedDB::KvStoreNbDelegate *delegate, const std::string &itemKey,
+        const Value &value);
+
+    // the callers hold operationMutex_
+    uint32_t Buffer(const std::string &key, std::map<std::string, Value> &pending,
+        const std::map<std::string, Value> &batch);
+    uint32_t Flush(const std::string &key);
+    // the buffered puts, data and the deletes in one transaction
+    uint32_t FlushWithDeletes(const std::string &key, DistributedDB::KvStoreNbDelegate *delegate,
+        const std::map<std::string, Value> &data, const std::vector<std::string> &removed);
+    // the error of the last failed write behind of key, retried first so a recovered table goes on
+    uint32_t RetryFailedFlush(const std::string &key);
+    void ScheduleFlush();
+
+    void RunFlusher();
+    void StopFlusher();
+    void FlushAll();
+
     std::shared_mutex operationMutex_{};
     std::shared_ptr<DistributedDB::KvStoreDelegateManager> storeManager_;
     std::map<std::string, DistributedDB::KvStoreNbDelegate *> delegates_;
+    std::map<std::string, Table> tables_;
     std::map<std::string, std::shared_ptr<TableWatcher>> observerMap_;
     std::shared_ptr<StatusWatcher> statusWatcher_ = nullptr;
+    // durable tables only, the puts not in the database yet
+    std::map<std::string, std::map<std::string, Value>> pending_;
+    // durable tables whose write behind failed, their next write and the close report it
+    std::map<std::string, uint32_t> flushErrors_;
+    std::mutex flushMutex_{};
+    std::condition_variable flushCv_{};
+    std::thread flusher_;
+    bool flushRequested_ = false;
+    bool stopFlusher_ = false;
+    std::atomic<uint64_t> memoryBudget_ { 0 };
+    // leaf lock, the usage observers take it from the threads of the database
+    std::mutex usageMutex_ {};
+    std::map<std::string, Usage> usage_;
 };
 } // namespace OHOS::ObjectStore
 #endif
@@ -16,11 +16,12 @@
 #ifndef FLAT_OBJECT_STORE_H
 #define FLAT_OBJECT_STORE_H
 
+#include <future>
 #include <memory>
 #include <string>
 
 #include "bytes.h"
-#include "flat_object_storage_engine.h"
+#include "object_storage_engine.h"
 
 namespace OHOS::ObjectStore {
 class FlatObjectWatcher : public TableWatcher {
@@ -33,20 +34,37 @@ public:
 
 class FlatObjectStore {
 public:
-    explicit FlatObjectStore(const std::string &bundleName);
+    // opens the storage engine for bundleName in the background, the store owns it from now on
+    FlatObjectStore(const std::string &bundleName, std::shared_ptr<ObjectStorageEngine> storageEngine);
     ~FlatObjectStore();
-    uint32_t CreateObject(const std::string &sessionId);
+    // blocks until the storage engine is open, the status of the open; every operation waits for it
+    uint32_t WaitReady();
+    uint32_t CreateObject(const std::string &sessionId, const ObjectOptions &options = ObjectOptions());
     uint32_t Delete(const std::string &objectId);
     uint32_t Watch(const std::string &objectId, std::shared_ptr<FlatObjectWatcher> watcher);
     uint32_t UnWatch(const std::string &objectId);
-    uint32_t Put(const std::string &sessionId, const std::string &key, std::vector<uint8_t> value);
+    uint32_t Put(const std::string &sessionId, const std::string &key, const std::vector<uint8_t> &value);
     uint32_t Get(std::string &sessionId, const std::string &key, Bytes &value);
+    // all keys and the deletes of removed in one storage batch
+    uint32_t PutBatch(
+        const std::string &sessionId, const std::map<std::string, Bytes> &data, const std::vector<std::string> &removed);
+    // every key of the object from one snapshot read
+    uint32_t GetAll(const std::string &sessionId, std::map<std::string, Bytes> &data);
+    // the keys starting with prefix
+    uint32_t GetAll(const std::string &sessionId, const std::string &prefix, std::map<std::string, Bytes> &data);
+    uint32_t DeleteBatch(const std::string &sessionId, const std::vector<std::string> &keys);
     uint32_t SetStatusNotifier(std::shared_ptr<StatusWatcher> sharedPtr);
     uint32_t SyncAllData(const std::string &sessionId,
         const std::function<void(const std::map<std::string, DistributedDB::DBStatus> &)> &onComplete);
+    uint64_t SetMemoryBudget(uint64_t bytes);
+    // empty while the store is opening, it does not wait
+    void GetUsage(std::map<std::string, SessionStatistics> &usage);
 
 private:
-    std::shared_ptr<FlatObjectStorageEngine> storageEngine_;
+    bool IsReady();
+
+    std::shared_ptr<ObjectStorageEngine> storageEngine_;
+    std::shared_future<uint32_t> ready_;
 };
 } // namespace OHOS::ObjectStore
 
@@ -17,10 +17,15 @@
 #define OBJECT_STORAGE_ENGINE_H
 
 #include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "distributed_object.h"
 #include "kv_store_observer.h"
+#include "objectstore_statistics.h"
 #include "watcher.h"
 
 namespace OHOS::ObjectStore {
@@ -53,13 +58,28 @@ public:
     virtual uint32_t Open(const std::string &bundleName) = 0;
     virtual uint32_t Close() = 0;
     virtual uint32_t DeleteTable(const std::string &key) = 0;
-    virtual uint32_t CreateTable(const std::string &key) = 0;
+    virtual uint32_t CreateTable(const std::string &key, const ObjectOptions &options) = 0;
     virtual uint32_t GetTable(const std::string &key, std::map<std::string, Value> &result) = 0;
-    virtual uint32_t UpdateItem(const std::string &key, const std::string &itemKey, Value &value) = 0;
+    // the items whose key starts with prefix
+    virtual uint32_t GetItems(
+        const std::string &key, const std::string &prefix, std::map<std::string, Value> &result) = 0;
+    virtual uint32_t UpdateItem(const std::string &key, const std::string &itemKey, const Value &value) = 0;
+    // puts data and deletes removed in one write, a reader sees all of it or none
+    virtual uint32_t UpdateItems(const std::string &key, const std::map<std::string, Value> &data,
+        const std::vector<std::string> &removed) = 0;
     virtual uint32_t GetItem(const std::string &key, const std::string &itemKey, Value &value) = 0;
+    // missing items are no error
+    virtual uint32_t DeleteItems(const std::string &key, const std::vector<std::string> &itemKeys) = 0;
     virtual uint32_t RegisterObserver(const std::string &key, std::shared_ptr<TableWatcher> watcher) = 0;
     virtual uint32_t UnRegisterObserver(const std::string &key) = 0;
     virtual uint32_t SetStatusNotifier(std::shared_ptr<StatusWatcher> watcher) = 0;
+    virtual uint32_t SyncAllData(const std::string &sessionId,
+        const std::function<void(const std::map<std::string, DistributedDB::DBStatus> &)> &onComplete) = 0;
+    // the resident bytes left over the budget once the idle tables that can be closed are
+    virtual uint64_t SetMemoryBudget(uint64_t bytes) = 0;
+    // the bytes and fields of every table, evicted ones included
+    virtual void GetUsage(std::map<std::string, SessionStatistics> &usage) = 0;
+    bool isOpened_ = false;
 };
 } // namespace OHOS::ObjectStore
 #endif
\ No newline at end of file
@@ -23,6 +23,8 @@ namespace OHOS::ObjectStore {
 using Bytes = std::vector<uint8_t>;
 static const char *FIELDS_PREFIX = "p_";
 static const int32_t FIELDS_PREFIX_LEN = 2;
+// chunks of large complex values, named after their digest
+static const char *CHUNKS_PREFIX = "c_";
 } // namespace OHOS::ObjectStore
 
 #endif // BYTES_H
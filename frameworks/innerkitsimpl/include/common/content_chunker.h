@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONTENT_CHUNKER_H
+#define CONTENT_CHUNKER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OHOS::ObjectStore {
+// Content defined chunking (FastCDC) of large values. A cut point depends only on the 64 bytes in
+// front of it, so an edit changes the chunks around it and the others keep their bytes and their
+// digest, wherever they moved to. Every device has to cut the same way, the parameters and the gear
+// table are part of the format.
+class ContentChunker {
+public:
+    static constexpr size_t MIN_SIZE = 2 * 1024;
+    static constexpr size_t AVERAGE_SIZE = 8 * 1024;
+    static constexpr size_t MAX_SIZE = 64 * 1024;
+    static constexpr size_t DIGEST_SIZE = 16;
+    using Digest = std::array<uint8_t, DIGEST_SIZE>;
+
+    // the lengths of the chunks of data in order, they add up to size
+    static std::vector<size_t> Split(const uint8_t *data, size_t size);
+    // the first DIGEST_SIZE bytes of the sha-256 of data
+    static Digest Hash(const uint8_t *data, size_t size);
+    static std::string ToHex(const Digest &digest);
+
+private:
+    static size_t NextCut(const uint8_t *data, size_t size);
+};
+} // namespace OHOS::ObjectStore
+#endif // CONTENT_CHUNKER_H
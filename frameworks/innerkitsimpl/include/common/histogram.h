@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "macro.h"
+
+namespace OHOS::ObjectStore {
+struct HistogramSnapshot {
+    static constexpr uint32_t BUCKET_COUNT = 64;
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    // bucket i holds values in [2^(i-1), 2^i), bucket 0 holds zero
+    std::array<uint64_t, BUCKET_COUNT> buckets{};
+
+    uint64_t Percentile(double ratio) const
+    {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t target = static_cast<uint64_t>(ratio * count);
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += buckets[i];
+            if (seen > target) {
+                uint64_t upper = (i == 0) ? 0 : ((i >= BUCKET_COUNT - 1) ? UINT64_MAX : (1ULL << i) - 1);
+                return upper < max ? upper : max;
+            }
+        }
+        return max;
+    }
+
+    uint64_t Average() const
+    {
+        return count == 0 ? 0 : sum / count;
+    }
+
+    std::string ToString() const
+    {
+        return "count:" + std::to_string(count) + " avg:" + std::to_string(Average())
+               + " p50:" + std::to_string(Percentile(0.5)) + " p99:" + std::to_string(Percentile(0.99))
+               + " max:" + std::to_string(max);
+    }
+};
+
+// Lock free log2 histogram, cheap enough to record on every message.
+class Histogram {
+public:
+    Histogram() = default;
+    ~Histogram() = default;
+    DISABLE_COPY_AND_MOVE(Histogram);
+
+    void Record(uint64_t value)
+    {
+        buckets_[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    HistogramSnapshot Snapshot() const
+    {
+        HistogramSnapshot snapshot;
+        for (uint32_t i = 0; i < HistogramSnapshot::BUCKET_COUNT; i++) {
+            snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+            snapshot.count += snapshot.buckets[i];
+        }
+        snapshot.sum = sum_.load(std::memory_order_relaxed);
+        snapshot.max = max_.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    void Reset()
+    {
+        for (auto &bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static uint32_t BucketOf(uint64_t value)
+    {
+        // the bit width of value, one instruction instead of a shift per bit on the record path
+        uint32_t bucket = value == 0 ? 0 : static_cast<uint32_t>(64 - __builtin_clzll(value));
+        return bucket < HistogramSnapshot::BUCKET_COUNT - 1 ? bucket : HistogramSnapshot::BUCKET_COUNT - 1;
+    }
+
+    std::array<std::atomic<uint64_t>, HistogramSnapshot::BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> sum_{ 0 };
+    std::atomic<uint64_t> max_{ 0 };
+};
+} // namespace OHOS::ObjectStore
+#endif // HISTOGRAM_H
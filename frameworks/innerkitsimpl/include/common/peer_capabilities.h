@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PEER_CAPABILITIES_H
+#define PEER_CAPABILITIES_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "macro.h"
+
+namespace OHOS::ObjectStore {
+// What the online peers understand beyond the formats every release reads. Before its first frame to
+// a device the communicator sends a hello carrying the local capabilities and asking for the peer's,
+// a peer that knows the hello answers with its own. An older peer drops the hello as a frame it can
+// not parse and never answers, so it keeps having none. Writers pick a newer format only when every
+// online peer has the capability; with no peer online nothing is known and the old formats are used.
+// A peer coming online later would still be synced what was written before, so every record stored
+// here, written or synced in or restored, marks its format as stored, and the sync frames of a peer
+// lacking a stored format are dropped both ways until its hello shows it has them all. The stored
+// formats are kept until the process ends, deleting the records does not clear them.
+class PeerCapabilities {
+public:
+    enum Capability : uint32_t {
+        BINARY_COMPLEX = 1 << 0,  // decodes typed arrays stored by the binary serializer
+        PATH_FIELDS = 1 << 1,     // reads a JS object stored as one field per path
+        TRACE_HEADER = 1 << 2,    // skips the PropagationTracer header in front of a frame
+        CHUNKED_VALUES = 1 << 3,  // assembles a large complex value from its chunk manifest
+    };
+    static constexpr uint32_t LOCAL = BINARY_COMPLEX | PATH_FIELDS | TRACE_HEADER | CHUNKED_VALUES;
+    static constexpr uint32_t HELLO_MAGIC = 0x4F424843;
+    static constexpr uint32_t HELLO_SIZE = 4 * sizeof(uint32_t);
+    static constexpr uint32_t REPLY_REQUESTED = 1 << 0;
+
+    static PeerCapabilities &GetInstance();
+
+    // an online device starts with no capabilities until its hello arrives
+    void OnOnline(const std::string &deviceId);
+    void OnOffline(const std::string &deviceId);
+    // true when the hello lets a peer sync whose frames were dropped
+    bool OnHello(const std::string &deviceId, uint32_t capabilities);
+    // true once per online period of the device, the caller sends the hello
+    bool TakeHelloTurn(const std::string &deviceId);
+    // the hello did not go out, the next frame tries again
+    void OnHelloFailed(const std::string &deviceId);
+
+    bool Has(const std::string &deviceId, uint32_t capabilities) const;
+    // the capabilities every online peer has, 0 when no peer is online
+    uint32_t GetCommon() const;
+    bool AllHave(uint32_t capabilities) const
+    {
+        return capabilities != 0 && (GetCommon() & capabilities) == capabilities;
+    }
+
+    // a record of a session's store, by the key and value the storage engine keeps
+    void OnStored(const std::string &itemKey, const std::vector<uint8_t> &value);
+    uint32_t GetStored() const;
+    // false while the peer lacks a stored format, the first refusal of an online period is logged
+    bool CanSync(const std::string &deviceId);
+    // the newer formats a record is in, a raw Uint8Array that happens to start like the binary
+    // serializer counts as one, which only keeps older peers out
+    static uint32_t FormatsOf(const std::string &itemKey, const std::vector<uint8_t> &value);
+
+    // most significant byte first: magic, size, capabilities, flags
+    static std::vector<uint8_t> EncodeHello(uint32_t flags);
+    // false when the frame is not a hello
+    static bool DecodeHello(const uint8_t *data, uint32_t size, uint32_t &capabilities, uint32_t &flags);
+
+private:
+    struct Peer {
+        uint32_t capabilities = 0;
+        bool helloSent = false;
+        bool refused = false;
+    };
+    PeerCapabilities() = default;
+    ~PeerCapabilities() = default;
+    DISABLE_COPY_AND_MOVE(PeerCapabilities);
+
+    mutable std::mutex mutex_ {};
+    std::map<std::string, Peer> peers_ {};
+    std::atomic<uint32_t> stored_ { 0 };
+};
+} // namespace OHOS::ObjectStore
+#endif // PEER_CAPABILITIES_H
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PROPAGATION_TRACER_H
+#define PROPAGATION_TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "macro.h"
+
+namespace OHOS::ObjectStore {
+// Optional trace of a write on its way from the local put to the remote JS handlers. A traced put
+// gets an id, the frames sent after it to peers announcing PeerCapabilities::TRACE_HEADER carry that
+// id in a small header, and the receiving device attributes its change notifications to the newest
+// id it received. Every stage is stamped with the wall clock, so the timelines of several devices
+// line up into one. Off by default, a hook of a disabled tracer is one relaxed atomic load.
+class PropagationTracer {
+public:
+    enum Stage : uint32_t {
+        PUT = 0,  // the store was asked to write
+        COMMIT,   // the write is in the local database
+        SYNC,     // a sync of the session was issued
+        SEND,     // a frame was handed to the transport
+        RECEIVE,  // a frame arrived from a peer
+        CHANGE,   // the database reported the change to the watcher
+        DELIVER,  // the JS handlers are called
+        STAGE_COUNT,
+    };
+    static constexpr const char *ENABLE_ENV = "OBJECTSTORE_TRACE";
+    static constexpr size_t CAPACITY = 4096;  // newest events kept
+    // in front of every frame sent while a write is traced, in host byte order
+    struct FrameHeader {
+        uint32_t magic;
+        uint32_t size;
+        uint64_t traceId;
+        int64_t sendTime;  // microseconds of the sender wall clock
+    };
+    static constexpr uint32_t FRAME_MAGIC = 0x4F545243;
+    static constexpr uint32_t HEADER_SIZE = sizeof(FrameHeader);
+
+    static PropagationTracer &GetInstance();
+
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // starts the trace of a local write and records PUT, 0 when tracing is off
+    uint64_t Begin(const std::string &sessionId, const std::string &key);
+    void Record(uint64_t traceId, Stage stage, const std::string &device, const std::string &detail);
+    // the newest local write, the frames sent after it carry it
+    uint64_t GetLocalTrace() const;
+    // the newest trace a peer sent, the change notifications after it belong to it
+    uint64_t GetRemoteTrace() const;
+
+    // frame becomes the header followed by data and SEND is recorded; false when nothing is traced
+    bool Wrap(const std::string &deviceId, const uint8_t *data, uint32_t size, std::vector<uint8_t> &frame);
+    // skips the header of a received frame whether tracing is on or not, and records RECEIVE
+    void Unwrap(const std::string &deviceId, const uint8_t *&data, uint32_t &size);
+
+    // trace of the change notification running on this thread, for the layers above the watcher
+    static uint64_t GetCurrentTrace();
+    static void SetCurrentTrace(uint64_t traceId);
+
+    // chrome trace event json, loads in chrome://tracing and perfetto; pid is derived from localDevice
+    std::string Export(const std::string &localDevice) const;
+    void Clear();
+
+private:
+    struct Event {
+        uint64_t traceId = 0;
+        Stage stage = PUT;
+        int64_t time = 0;
+        int64_t peerTime = 0;  // RECEIVE only, when the peer sent the frame
+        std::string device;
+        std::string detail;
+    };
+
+    PropagationTracer();
+    ~PropagationTracer() = default;
+    DISABLE_COPY_AND_MOVE(PropagationTracer);
+    void Append(Event &&event);
+    static int64_t Now();
+
+    std::atomic<bool> enabled_ { false };
+    const uint64_t idBase_;
+    std::atomic<uint64_t> nextId_ { 1 };
+    std::atomic<uint64_t> localTrace_ { 0 };
+    std::atomic<uint64_t> remoteTrace_ { 0 };
+    mutable std::mutex mutex_ {};
+    std::vector<Event> events_ {};
+    size_t next_ = 0;  // ring position once events_ is full
+};
+} // namespace OHOS::ObjectStore
+#endif // PROPAGATION_TRACER_H
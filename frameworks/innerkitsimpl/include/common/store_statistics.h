@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STORE_STATISTICS_H
+#define STORE_STATISTICS_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+#include "histogram.h"
+#include "macro.h"
+#include "objectstore_statistics.h"
+
+namespace OHOS::ObjectStore {
+// Process wide counters behind DistributedObjectStore::GetStatistics. Recording is relaxed atomics,
+// per peer a shared lock and a lookup, so it stays on in release builds.
+class StoreStatistics {
+public:
+    enum Operation : uint32_t {
+        PUT = 0,
+        GET,
+        CREATE,
+        DESTROY,
+        SESSION_OPEN,
+        OPERATION_COUNT,
+    };
+    enum InitPhase : uint32_t {
+        INIT_PROCESS_LABEL = 0,
+        INIT_COMMUNICATOR,
+        INIT_STORE_MANAGER,
+        INIT_OPEN,
+        INIT_NODE_REGISTER,
+        INIT_READY_WAIT,
+        INIT_PHASE_COUNT,
+    };
+    using Clock = std::chrono::steady_clock;
+
+    // records the time from construction to destruction
+    class Scope {
+    public:
+        explicit Scope(Operation operation) : operation_(operation), start_(Clock::now())
+        {
+        }
+        ~Scope()
+        {
+            GetInstance().Record(operation_, Clock::now() - start_);
+        }
+        DISABLE_COPY_AND_MOVE(Scope);
+
+    private:
+        Operation operation_;
+        Clock::time_point start_;
+    };
+
+    static StoreStatistics &GetInstance()
+    {
+        static StoreStatistics instance;
+        return instance;
+    }
+
+    void Record(Operation operation, Clock::duration cost)
+    {
+        latency_[operation].Record(ToMicroseconds(cost));
+    }
+
+    // ready waits add up, the other phases run once
+    void RecordInit(InitPhase phase, Clock::duration cost)
+    {
+        if (phase == INIT_READY_WAIT) {
+            init_[phase].fetch_add(ToMicroseconds(cost), std::memory_order_relaxed);
+        } else {
+            init_[phase].store(ToMicroseconds(cost), std::memory_order_relaxed);
+        }
+    }
+
+    void RecordSync(const std::string &deviceId, Clock::duration cost)
+    {
+        GetPeer(deviceId).sync.Record(ToMicroseconds(cost));
+    }
+
+    void OnSent(const std::string &deviceId, uint64_t bytes)
+    {
+        GetPeer(deviceId).bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void OnReceived(const std::string &deviceId, uint64_t bytes)
+    {
+        GetPeer(deviceId).bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void OnSessionCreated()
+    {
+        liveSessions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void OnSessionDestroyed()
+    {
+        liveSessions_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void OnNotificationBegin()
+    {
+        pendingNotifications_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void OnNotificationEnd()
+    {
+        pendingNotifications_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void SetMemoryBudget(uint64_t bytes)
+    {
+        memoryBudget_.store(bytes, std::memory_order_relaxed);
+    }
+
+    void OnEvicted()
+    {
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void OnReloaded()
+    {
+        reloads_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void OnWriteSuppressed()
+    {
+        suppressedWrites_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // peers are keyed by the device id of the transport
+    ObjectStoreStatistics Snapshot() const
+    {
+        ObjectStoreStatistics statistics;
+        statistics.put = ToLatency(latency_[PUT].Snapshot());
+        statistics.get = ToLatency(latency_[GET].Snapshot());
+        statistics.create = ToLatency(latency_[CREATE].Snapshot());
+        statistics.destroy = ToLatency(latency_[DESTROY].Snapshot());
+        statistics.sessionOpenWait = ToLatency(latency_[SESSION_OPEN].Snapshot());
+        {
+            std::shared_lock<std::shared_mutex> lock(peerMutex_);
+            for (auto &[deviceId, peer] : peers_) {
+                PeerStatistics &item = statistics.peers[deviceId];
+                item.bytesSent = peer->bytesSent.load(std::memory_order_relaxed);
+                item.bytesReceived = peer->bytesReceived.load(std::memory_order_relaxed);
+                item.sync = ToLatency(peer->sync.Snapshot());
+            }
+        }
+        statistics.pendingNotifications = pendingNotifications_.load(std::memory_order_relaxed);
+        statistics.liveSessions = liveSessions_.load(std::memory_order_relaxed);
+        statistics.init.processLabel = init_[INIT_PROCESS_LABEL].load(std::memory_order_relaxed);
+        statistics.init.communicator = init_[INIT_COMMUNICATOR].load(std::memory_order_relaxed);
+        statistics.init.storeManager = init_[INIT_STORE_MANAGER].load(std::memory_order_relaxed);
+        statistics.init.open = init_[INIT_OPEN].load(std::memory_order_relaxed);
+        statistics.init.nodeRegister = init_[INIT_NODE_REGISTER].load(std::memory_order_relaxed);
+        statistics.init.readyWait = init_[INIT_READY_WAIT].load(std::memory_order_relaxed);
+        statistics.memoryBudget = memoryBudget_.load(std::memory_order_relaxed);
+        statistics.evictions = evictions_.load(std::memory_order_relaxed);
+        statistics.reloads = reloads_.load(std::memory_order_relaxed);
+        statistics.suppressedWrites = suppressedWrites_.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+private:
+    struct Peer {
+        std::atomic<uint64_t> bytesSent { 0 };
+        std::atomic<uint64_t> bytesReceived { 0 };
+        Histogram sync;
+    };
+
+    StoreStatistics() = default;
+    ~StoreStatistics() = default;
+    DISABLE_COPY_AND_MOVE(StoreStatistics);
+
+    static uint64_t ToMicroseconds(Clock::duration cost)
+    {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(cost).count();
+        return us < 0 ? 0 : static_cast<uint64_t>(us);
+    }
+
+    static LatencyStatistics ToLatency(const HistogramSnapshot &snapshot)
+    {
+        return { snapshot.count, snapshot.Average(), snapshot.Percentile(0.5), snapshot.Percentile(0.99),
+            snapshot.max };
+    }
+
+    Peer &GetPeer(const std::string &deviceId)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(peerMutex_);
+            auto it = peers_.find(deviceId);
+            if (it != peers_.end()) {
+                return *it->second;
+            }
+        }
+        // peers are never removed, a device coming back keeps adding to its totals
+        std::unique_lock<std::shared_mutex> lock(peerMutex_);
+        auto &peer = peers_[deviceId];
+        if (peer == nullptr) {
+            peer = std::make_unique<Peer>();
+        }
+        return *peer;
+    }
+
+    Histogram latency_[OPERATION_COUNT];
+    mutable std::shared_mutex peerMutex_ {};
+    std::map<std::string, std::unique_ptr<Peer>> peers_ {};
+    std::atomic<uint64_t> liveSessions_ { 0 };
+    std::atomic<uint64_t> pendingNotifications_ { 0 };
+    std::atomic<uint64_t> init_[INIT_PHASE_COUNT] = {};
+    std::atomic<uint64_t> memoryBudget_ { 0 };
+    std::atomic<uint64_t> evictions_ { 0 };
+    std::atomic<uint64_t> reloads_ { 0 };
+    std::atomic<uint64_t> suppressedWrites_ { 0 };
+};
+} // namespace OHOS::ObjectStore
+#endif // STORE_STATISTICS_H
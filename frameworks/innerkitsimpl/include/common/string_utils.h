@@ -33,30 +33,20 @@ public:
     ~StringUtils() = delete;
     static std::vector<uint8_t> StrToBytes(const std::string &src)
     {
-        std::vector<uint8_t> dst;
-        dst.resize(src.size());
-        dst.assign(src.begin(), src.end());
-        return dst;
+        return std::vector<uint8_t>(src.begin(), src.end());
     }
 
-    static std::string BytesToStr(const std::vector<uint8_t> src)
+    static std::string BytesToStr(const std::vector<uint8_t> &src)
     {
-        std::string result;
-        Bytes rstStr(src.begin(), src.end());
-        result.assign(reinterpret_cast<char *>(rstStr.data()), rstStr.size());
-        return result;
+        return std::string(reinterpret_cast<const char *>(src.data()), src.size());
     }
-    static uint32_t BytesToStrWithType(Bytes input, std::string &str)
+    static uint32_t BytesToStrWithType(const Bytes &input, std::string &str)
     {
-        uint32_t len = input.end() - input.begin();
-        if (len <= sizeof(Type)) {
+        if (input.size() < sizeof(Type)) {
             LOG_ERROR("StringUtils:BytesToStrWithType get input len err.");
             return ERR_DATA_LEN;
         }
-        std::vector<uint8_t>::const_iterator first = input.begin() + sizeof(Type);
-        std::vector<uint8_t>::const_iterator end = input.end();
-        Bytes rstStr(first, end);
-        str.assign(reinterpret_cast<char *>(rstStr.data()), rstStr.size());
+        str.assign(reinterpret_cast<const char *>(input.data()) + sizeof(Type), input.size() - sizeof(Type));
         return SUCCESS;
     }
 };
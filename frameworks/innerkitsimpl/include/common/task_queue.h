@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TASK_QUEUE_H
+#define TASK_QUEUE_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "macro.h"
+
+namespace OHOS::ObjectStore {
+// Serial executor: tasks posted to one queue run in order on a single worker thread,
+// so independent queues never block each other.
+class TaskQueue {
+public:
+    using Task = std::function<void()>;
+
+    TaskQueue() : context_(std::make_shared<Context>())
+    {
+    }
+
+    ~TaskQueue()
+    {
+        Stop();
+    }
+
+    DISABLE_COPY_AND_MOVE(TaskQueue);
+
+    // discarded runs instead of task when the queue stops before task ran, so that a caller owed an
+    // answer gets one
+    bool Post(Task task, Task discarded = nullptr)
+    {
+        std::lock_guard<std::mutex> lock(context_->mutex);
+        if (context_->stopped) {
+            return false;
+        }
+        if (!worker_.joinable()) {
+            worker_ = std::thread(Run, context_);
+        }
+        context_->tasks.push({ std::move(task), std::move(discarded) });
+        context_->cv.notify_one();
+        return true;
+    }
+
+    size_t Size() const
+    {
+        std::lock_guard<std::mutex> lock(context_->mutex);
+        return context_->tasks.size();
+    }
+
+    // discard pending tasks and wait for the running one to finish, unless called from the worker itself;
+    // the discarded callbacks of the pending tasks run on the caller after that
+    void Stop()
+    {
+        std::thread worker;
+        std::queue<Entry> pending;
+        {
+            std::lock_guard<std::mutex> lock(context_->mutex);
+            context_->stopped = true;
+            pending.swap(context_->tasks);
+            context_->cv.notify_all();
+            worker = std::move(worker_);
+        }
+        if (worker.joinable()) {
+            if (worker.get_id() == std::this_thread::get_id()) {
+                worker.detach();
+            } else {
+                worker.join();
+            }
+        }
+        for (; !pending.empty(); pending.pop()) {
+            if (pending.front().discarded) {
+                pending.front().discarded();
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        Task task;
+        Task discarded;
+    };
+    struct Context {
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        std::queue<Entry> tasks;
+        bool stopped = false;
+    };
+
+    static void Run(std::shared_ptr<Context> context)
+    {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(context->mutex);
+                context->cv.wait(lock, [&context]() { return context->stopped || !context->tasks.empty(); });
+                if (context->stopped) {
+                    return;
+                }
+                task = std::move(context->tasks.front().task);
+                context->tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::shared_ptr<Context> context_;
+    std::thread worker_;
+};
+} // namespace OHOS::ObjectStore
+#endif // TASK_QUEUE_H
@@ -34,6 +34,8 @@ public:
     std::vector<DeviceInfo> GetDeviceList() const;
 
     std::string GetUdidByNodeId(const std::string &nodeId) const;
+
+    std::string ToNodeID(const std::string &deviceId) const;
     // get local device node information;
     DeviceInfo GetLocalBasicInfo() const;
     // get all remote connected device's node information;
@@ -64,6 +64,7 @@ enum class Status {
     KEY_NOT_FOUND = APP_DISTRIBUTEDDATAMGR_ERR_OFFSET + 7,
     REPEATED_REGISTER = APP_DISTRIBUTEDDATAMGR_ERR_OFFSET + 14,
     CREATE_SESSION_ERROR = APP_DISTRIBUTEDDATAMGR_ERR_OFFSET + 15,
+    TIME_OUT = APP_DISTRIBUTEDDATAMGR_ERR_OFFSET + 16,
 };
 } // namespace ObjectStore
 } // namespace OHOS
@@ -68,8 +68,17 @@ public:
     // user should use this method to get instance of CommunicationProvider;
     KVSTORE_API static CommunicationProvider &GetInstance();
 
+    // replace the transport of this process, e.g. by a simulated network, before the first store opens
+    KVSTORE_API static void SetInstance(CommunicationProvider *provider);
+
     // check peer device pipeInfo Process
     KVSTORE_API virtual bool IsSameStartedOnPeer(const PipeInfo &pipeInfo, const DeviceId &peer) const = 0;
+
+    // convert a device id of GetDeviceList to the id reported to applications
+    KVSTORE_API virtual std::string ToNodeID(const std::string &deviceId) const
+    {
+        return deviceId;
+    }
 };
 } // namespace ObjectStore
 } // namespace OHOS
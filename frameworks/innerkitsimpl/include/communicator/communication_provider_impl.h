@@ -60,6 +60,8 @@ public:
 
     bool IsSameStartedOnPeer(const PipeInfo &pipeInfo, const DeviceId &peer) const override;
 
+    std::string ToNodeID(const std::string &deviceId) const override;
+
 protected:
     virtual Status Initialize();
 
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DISTRIBUTEDDATAFWK_SRC_LINK_PROFILE_H
+#define DISTRIBUTEDDATAFWK_SRC_LINK_PROFILE_H
+
+#include <chrono>
+#include <map>
+#include <shared_mutex>
+#include <string>
+
+#include "app_types.h"
+
+namespace OHOS {
+namespace ObjectStore {
+struct LinkProfile {
+    std::string deviceType;
+    uint32_t baseMtu = 0;     // the largest frame the device type accepts
+    uint32_t mtu = 0;         // the frame size currently handed to DistributedDB
+    double throughput = 0;    // bytes per second, moving average of transfers of at least THROUGHPUT_SAMPLE_MIN
+    double rttUs = 0;         // session open round trip, moving average
+    double lossRate = 0;      // failed sends ratio, moving average
+    uint64_t sendCount = 0;
+    uint64_t failCount = 0;
+};
+
+// Per-peer link profile fed by device events and real transfers, so that the MTU handed out
+// to DistributedDB follows the link instead of a device-list lookup on every frame.
+class LinkProfileManager {
+public:
+    static constexpr uint32_t MTU_SIZE = 4096 * 1024;       // the max transmission unit size(4M - 80B)
+    static constexpr uint32_t MTU_SIZE_WATCH = 81920;       // the max transmission unit size(80K)
+    static constexpr uint32_t MTU_FLOOR_DIVISOR = 4;        // never shrink a frame below a quarter of baseMtu
+    // smaller frames cost mostly per frame overhead, their rate says nothing about the link
+    static constexpr uint32_t THROUGHPUT_SAMPLE_MIN = 64 * 1024;
+
+    static LinkProfileManager &GetInstance();
+
+    // a device came online, start over with a fresh profile
+    void OnDeviceOnline(const DeviceInfo &info);
+    // a device was seen in a device list, only create the profile if it is missing
+    void OnDeviceFound(const DeviceInfo &info);
+    void OnDeviceOffline(const std::string &deviceId);
+    void OnSessionOpened(const std::string &deviceId, std::chrono::microseconds rtt);
+    // a frame went through SendBytes, a failure of a frame above the floor shrinks the MTU
+    void OnSendComplete(const std::string &deviceId, uint32_t bytes, std::chrono::microseconds cost, bool success);
+    // no session to the device, counts as a loss but says nothing about the frame size
+    void OnLinkFailed(const std::string &deviceId);
+
+    // return false when nothing is known about the device yet
+    bool GetMtuSize(const std::string &deviceId, uint32_t &mtu) const;
+    bool GetProfile(const std::string &deviceId, LinkProfile &profile) const;
+
+    static bool IsWatch(const std::string &deviceType);
+
+private:
+    LinkProfileManager() = default;
+    ~LinkProfileManager() = default;
+    static LinkProfile NewProfile(const DeviceInfo &info);
+    static void AdjustMtu(LinkProfile &profile, uint32_t bytes, bool success);
+
+    mutable std::shared_mutex mutex_ {};
+    std::map<std::string, LinkProfile> profiles_ {};
+};
+} // namespace ObjectStore
+} // namespace OHOS
+#endif // DISTRIBUTEDDATAFWK_SRC_LINK_PROFILE_H
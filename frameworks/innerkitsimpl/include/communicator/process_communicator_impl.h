@@ -51,6 +51,7 @@ public:
 private:
     void OnMessage(const DeviceInfo &info, const uint8_t *ptr, const int size, const PipeInfo &pipeInfo) const override;
     void OnDeviceChanged(const DeviceInfo &info, const DeviceChangeType &type) const override;
+    void SendHello(const std::string &deviceId, uint32_t flags) const;
 
     std::string thisProcessLabel_;
     OnDeviceChange onDeviceChangeHandler_;
@@ -59,9 +60,6 @@ private:
     mutable std::mutex onDataReceiveMutex_;
 
     static constexpr uint32_t MTU_SIZE = 4096 * 1024;        // the max transmission unit size(4M - 80B)
-    static constexpr uint32_t MTU_SIZE_WATCH = 81920; // the max transmission unit size(80K)
-    static constexpr const char *SMART_WATCH_TYPE = "SMART_WATCH";
-    static constexpr const char *CHILDREN_WATCH_TYPE = "CHILDREN_WATCH";
 };
 } // namespace ObjectStore
 } // namespace OHOS
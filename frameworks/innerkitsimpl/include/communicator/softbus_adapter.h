@@ -15,18 +15,24 @@
 
 #ifndef DISTRIBUTEDDATAFWK_SRC_SOFTBUS_ADAPTER_H
 #define DISTRIBUTEDDATAFWK_SRC_SOFTBUS_ADAPTER_H
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <thread>
 #include <tuple>
 
 #include "app_data_change_listener.h"
 #include "app_device_status_change_listener.h"
 #include "app_types.h"
+#include "histogram.h"
 #include "session.h"
 #include "softbus_bus_center.h"
+#include "task_queue.h"
 namespace OHOS {
 namespace ObjectStore {
 template <typename T>
@@ -52,6 +58,18 @@ public:
         return data;
     }
 
+    // wait at most timeout, invalid is returned when nobody sets the value in time
+    T GetValue(std::chrono::milliseconds timeout, const T &invalid)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cv_.wait_for(lock, timeout, [this]() { return isSet_; })) {
+            return invalid;
+        }
+        T data = data_;
+        cv_.notify_one();
+        return data;
+    }
+
     void Clear()
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -68,6 +86,12 @@ private:
 
 class SoftBusAdapter {
 public:
+    using SendCallback = std::function<void(Status status)>;
+    static constexpr std::chrono::milliseconds SEND_TIMEOUT = std::chrono::milliseconds(5000);
+    static constexpr size_t MAX_SEND_QUEUE_DEPTH = 1024;
+    // an event meeting the opposite event of its device still pending is held this long, so a flapping link
+    // settles into its net state; any other event is delivered at once
+    static constexpr std::chrono::milliseconds DEVICE_EVENT_WINDOW = std::chrono::milliseconds(100);
     SoftBusAdapter();
     ~SoftBusAdapter();
     static std::shared_ptr<SoftBusAdapter> GetInstance();
@@ -77,6 +101,7 @@ public:
     Status StartWatchDeviceChange(const AppDeviceStatusChangeListener *observer, const PipeInfo &pipeInfo);
     // stop DeviceChangeListener to watch device change;
     Status StopWatchDeviceChange(const AppDeviceStatusChangeListener *observer, const PipeInfo &pipeInfo);
+    // queue a device event, listeners are called in order from a single dispatcher thread
     void NotifyAll(const DeviceInfo &deviceInfo, const DeviceChangeType &type);
     DeviceInfo GetLocalDevice();
     std::vector<DeviceInfo> GetDeviceList() const;
@@ -93,10 +118,26 @@ public:
     // stop DataChangeListener to watch data change;
     Status StopWatchDataChange(const AppDataChangeListener *observer, const PipeInfo &pipeInfo);
 
-    // Send data to other device, function will be called back after sent to notify send result.
+    // Queue data for the device and return at once, a dead peer never blocks the caller. A frame that fails
+    // is reported by the next SendData to the same device, which returns the error instead of queueing.
     Status SendData(
         const PipeInfo &pipeInfo, const DeviceId &deviceId, const uint8_t *ptr, int size, const MessageInfo &info);
 
+    // Queue data for the device and return at once. Each device owns a send queue so a dead peer only delays
+    // itself. callback is invoked exactly once, with TIME_OUT when the data could not be sent before timeout
+    // or the queue was dropped with the data still in it.
+    Status SendDataAsync(const PipeInfo &pipeInfo, const DeviceId &deviceId, std::vector<uint8_t> data,
+        const MessageInfo &info, const SendCallback &callback, std::chrono::milliseconds timeout = SEND_TIMEOUT);
+
+    // pending sends of a device seen at enqueue time
+    HistogramSnapshot GetSendQueueDepth() const;
+
+    // microseconds from enqueue until the data is handed to softbus or dropped
+    HistogramSnapshot GetSendWaitTime() const;
+
+    // microseconds from the first event of a device burst until its listeners are called
+    HistogramSnapshot GetDeviceEventLatency() const;
+
     bool IsSameStartedOnPeer(const struct PipeInfo &pipeInfo, const struct DeviceId &peer);
 
     void SetMessageTransFlag(const PipeInfo &pipeInfo, bool flag);
@@ -115,13 +156,37 @@ public:
 
     std::string ToNodeID(const std::string &nodeId) const;
 
-    int32_t GetSessionStatus(int32_t sessionId);
+    int32_t GetSessionStatus(int32_t sessionId, std::chrono::milliseconds timeout);
 
     void OnSessionOpen(int32_t sessionId, int32_t status);
 
     void OnSessionClose(int32_t sessionId);
 
 private:
+    struct DeviceEvent {
+        DeviceInfo deviceInfo;
+        DeviceChangeType type = DeviceChangeType::DEVICE_OFFLINE;
+        std::chrono::steady_clock::time_point since;
+        std::chrono::steady_clock::time_point due;
+        uint32_t merged = 0;
+    };
+    void DispatchDeviceEvents();
+    void DeliverDeviceEvent(const DeviceEvent &event);
+    struct DataListenerEntry {
+        const AppDataChangeListener *observer = nullptr;
+        std::shared_ptr<TaskQueue> queue;
+    };
+    using DataListeners = std::map<std::string, DataListenerEntry>;
+    std::shared_ptr<const DataListeners> GetDataListeners() const;
+    void DispatchData(const std::string &pipeId, const AppDataChangeListener *observer, const std::string &deviceId,
+        const std::vector<uint8_t> &data) const;
+    Status DoSend(const PipeInfo &pipeInfo, const DeviceId &deviceId, const std::vector<uint8_t> &data,
+        const MessageInfo &info, std::chrono::steady_clock::time_point deadline);
+    std::shared_ptr<TaskQueue> GetSendQueue(const std::string &deviceId);
+    void DropSendQueue(const std::string &deviceId);
+    void OnSendFailed(const std::string &deviceId, Status status);
+    // the error of the last failed frame to the device, SUCCESS when there is none
+    Status TakeSendError(const std::string &deviceId);
     std::shared_ptr<BlockData<int32_t>> GetSemaphore (int32_t sessinId);
     mutable std::mutex networkMutex_{};
     mutable std::map<std::string, std::string> networkId2Udid_{};
@@ -129,8 +194,9 @@ private:
     static std::shared_ptr<SoftBusAdapter> instance_;
     std::mutex deviceChangeMutex_;
     std::set<const AppDeviceStatusChangeListener *> listeners_{};
+    // writers serialize on dataChangeMutex_ and publish a new snapshot, readers never lock
     std::mutex dataChangeMutex_{};
-    std::map<std::string, const AppDataChangeListener *> dataChangeListeners_{};
+    std::shared_ptr<const DataListeners> dataChangeListeners_ = std::make_shared<const DataListeners>();
     std::mutex busSessionMutex_{};
     std::map<std::string, bool> busSessionMap_{};
     bool flag_ = true; // only for br flag
@@ -138,6 +204,19 @@ private:
     ISessionListener sessionListener_{};
     std::mutex statusMutex_ {};
     std::map<int32_t, std::shared_ptr<BlockData<int32_t>>> sessionsStatus_;
+    std::mutex sendQueueMutex_ {};
+    std::map<std::string, std::shared_ptr<TaskQueue>> sendQueues_ {};
+    std::map<std::string, Status> sendErrors_ {};
+    Histogram sendQueueDepth_;
+    Histogram sendWaitTime_;
+    std::mutex eventMutex_ {};
+    std::condition_variable eventCv_ {};
+    std::deque<std::string> eventOrder_ {};
+    std::map<std::string, DeviceEvent> pendingEvents_ {};
+    std::map<std::string, DeviceChangeType> deliveredStates_ {}; // only touched by the dispatcher
+    bool eventStopped_ = false;
+    std::thread eventDispatcher_;
+    Histogram eventLatency_;
 };
 } // namespace ObjectStore
 } // namespace OHOS
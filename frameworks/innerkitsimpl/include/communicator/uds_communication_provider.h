@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DISTRIBUTEDDATAFWK_UDS_COMMUNICATION_PROVIDER_H
+#define DISTRIBUTEDDATAFWK_UDS_COMMUNICATION_PROVIDER_H
+
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "communication_provider.h"
+#include "nocopyable.h"
+
+namespace OHOS {
+namespace ObjectStore {
+// CommunicationProvider over unix domain sockets, for processes sharing objects on one host.
+// Every started pipe listens on <socketDir>/<deviceId>@<pipeId>; a device is online while it
+// owns at least one socket in the directory. Only built with objectstore_uds_transport, for tests
+// and benchmarks. The directory must belong to the user and be closed to others, peers must run
+// as the same user and a sender id is only accepted from the process listening on that id's socket.
+class UdsCommunicationProvider : public CommunicationProvider {
+public:
+    static constexpr const char *SOCKET_DIR_ENV = "OBJECTSTORE_UDS_DIR";
+    static constexpr const char *DEVICE_ID_ENV = "OBJECTSTORE_UDS_DEVICE_ID";
+    static constexpr const char *DEVICE_TYPE = "UDS";
+
+    // returns nullptr when the uds transport is not configured through SOCKET_DIR_ENV or the directory
+    // is not private to the user
+    static CommunicationProvider *Init();
+
+    ~UdsCommunicationProvider() override;
+
+    Status StartWatchDeviceChange(const AppDeviceStatusChangeListener *observer, const PipeInfo &pipeInfo) override;
+    Status StopWatchDeviceChange(const AppDeviceStatusChangeListener *observer, const PipeInfo &pipeInfo) override;
+    Status StartWatchDataChange(const AppDataChangeListener *observer, const PipeInfo &pipeInfo) override;
+    Status StopWatchDataChange(const AppDataChangeListener *observer, const PipeInfo &pipeInfo) override;
+    Status SendData(const PipeInfo &pipeInfo, const DeviceId &deviceId, const uint8_t *ptr, int size,
+        const MessageInfo &info) override;
+    std::vector<DeviceInfo> GetDeviceList() const override;
+    DeviceInfo GetLocalDevice() const override;
+    Status Start(const PipeInfo &pipeInfo) override;
+    Status Stop(const PipeInfo &pipeInfo) override;
+    bool IsSameStartedOnPeer(const PipeInfo &pipeInfo, const DeviceId &peer) const override;
+
+private:
+    struct Pipe {
+        int listenFd = -1;
+        int wakeFd[2] = { -1, -1 };
+        std::thread worker;
+    };
+    struct Connection {
+        ~Connection();
+        std::mutex mutex;
+        int fd = -1;
+    };
+    struct Peer {
+        pid_t pid = 0;
+        std::string deviceId; // empty until the first frame proves who sends
+    };
+    struct ListenerSlot {
+        std::mutex mutex;
+        const AppDataChangeListener *observer = nullptr;
+    };
+
+    DISALLOW_COPY_AND_MOVE(UdsCommunicationProvider);
+    UdsCommunicationProvider(const std::string &socketDir, const std::string &deviceId);
+    std::string SocketPath(const std::string &deviceId, const std::string &pipeId) const;
+    std::shared_ptr<ListenerSlot> GetListenerSlot(const std::string &pipeId);
+    void ReceiveLoop(const std::string &pipeId, std::shared_ptr<Pipe> pipe);
+    bool ReceiveFrame(int fd, const std::string &pipeId, Peer &peer);
+    bool VerifySender(const std::string &sender, const std::string &pipeId, pid_t pid) const;
+    Status WriteFrame(const std::shared_ptr<Connection> &connection, const std::string &path, const uint8_t *ptr,
+        uint32_t size);
+    void DiscoveryLoop();
+    std::set<std::string> ScanDevices() const;
+    void NotifyDeviceChange(const std::string &deviceId, DeviceChangeType type);
+
+    const std::string socketDir_;
+    const std::string localDeviceId_;
+    std::mutex pipeMutex_ {};
+    std::map<std::string, std::shared_ptr<Pipe>> pipes_ {};
+    std::mutex listenerMutex_ {};
+    std::map<std::string, std::shared_ptr<ListenerSlot>> dataListeners_ {};
+    std::mutex connectionMutex_ {};
+    std::map<std::string, std::shared_ptr<Connection>> connections_ {};
+    std::mutex deviceChangeMutex_ {};
+    std::set<const AppDeviceStatusChangeListener *> deviceListeners_ {};
+    mutable std::mutex deviceMutex_ {};
+    std::set<std::string> onlineDevices_ {};
+    std::mutex discoveryMutex_ {};
+    std::condition_variable discoveryCv_ {};
+    bool stopped_ = false;
+    std::thread discovery_;
+};
+} // namespace ObjectStore
+} // namespace OHOS
+#endif // DISTRIBUTEDDATAFWK_UDS_COMMUNICATION_PROVIDER_H
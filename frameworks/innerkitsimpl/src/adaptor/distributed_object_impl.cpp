@@ -15,10 +15,129 @@
 
 #include "distributed_object_impl.h"
 
+#include "content_chunker.h"
+#include "field_codec.h"
 #include "objectstore_errors.h"
+#include "peer_capabilities.h"
 #include "string_utils.h"
 
 namespace OHOS::ObjectStore {
+namespace {
+// type byte of a manifest: count, then size and digest of every chunk in order
+constexpr uint8_t CHUNKED_TAG = 0x80 | TYPE_COMPLEX;
+constexpr size_t MANIFEST_HEADER = sizeof(uint8_t) + sizeof(uint32_t);
+constexpr size_t MANIFEST_ENTRY = sizeof(uint32_t) + ContentChunker::DIGEST_SIZE;
+
+void AppendUint32(Bytes &data, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        data.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+uint32_t ReadUint32(const uint8_t *data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+        (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
+
+bool IsManifest(const Bytes &data)
+{
+    return !data.empty() && data[0] == CHUNKED_TAG;
+}
+
+// chunk keys and sizes in order, false for a damaged manifest
+bool ParseManifest(const Bytes &data, std::vector<std::pair<std::string, uint32_t>> &chunks)
+{
+    if (data.size() < MANIFEST_HEADER) {
+        return false;
+    }
+    uint32_t count = ReadUint32(data.data() + sizeof(uint8_t));
+    if ((data.size() - MANIFEST_HEADER) / MANIFEST_ENTRY != count
+        || (data.size() - MANIFEST_HEADER) % MANIFEST_ENTRY != 0) {
+        return false;
+    }
+    chunks.clear();
+    chunks.reserve(count);
+    const uint8_t *entry = data.data() + MANIFEST_HEADER;
+    for (uint32_t i = 0; i < count; i++, entry += MANIFEST_ENTRY) {
+        ContentChunker::Digest digest;
+        std::copy(entry + sizeof(uint32_t), entry + MANIFEST_ENTRY, digest.begin());
+        chunks.emplace_back(CHUNKS_PREFIX + ContentChunker::ToHex(digest), ReadUint32(entry));
+    }
+    return true;
+}
+
+// the manifest of payload, chunks not in previous are added to batch
+Bytes Chunk(const uint8_t *payload, size_t size, const std::set<std::string> &previous,
+    std::map<std::string, Bytes> &batch)
+{
+    std::vector<size_t> lengths = ContentChunker::Split(payload, size);
+    Bytes manifest;
+    manifest.reserve(MANIFEST_HEADER + lengths.size() * MANIFEST_ENTRY);
+    manifest.push_back(CHUNKED_TAG);
+    AppendUint32(manifest, static_cast<uint32_t>(lengths.size()));
+    size_t offset = 0;
+    for (size_t length : lengths) {
+        ContentChunker::Digest digest = ContentChunker::Hash(payload + offset, length);
+        std::string chunkKey = CHUNKS_PREFIX + ContentChunker::ToHex(digest);
+        AppendUint32(manifest, static_cast<uint32_t>(length));
+        manifest.insert(manifest.end(), digest.begin(), digest.end());
+        // a chunk the field had already is not written, so it is not synced again
+        if (previous.count(chunkKey) == 0 && batch.count(chunkKey) == 0) {
+            batch.emplace(std::move(chunkKey), Bytes(payload + offset, payload + offset + length));
+        }
+        offset += length;
+    }
+    return manifest;
+}
+
+// FieldValue holds its alternatives in Type order, the codecs have to agree
+template <size_t I = 0>
+constexpr bool CodecsFollowTypes()
+{
+    if constexpr (I < std::variant_size_v<FieldValue>) {
+        return FieldCodec<std::variant_alternative_t<I, FieldValue>>::TYPE == I && CodecsFollowTypes<I + 1>();
+    }
+    return true;
+}
+static_assert(CodecsFollowTypes(), "FieldValue alternatives and their codecs disagree on the type");
+
+template <size_t I = 0>
+uint32_t DecodeAlternative(const Bytes &data, FieldValue &value)
+{
+    if constexpr (I < std::variant_size_v<FieldValue>) {
+        using T = std::variant_alternative_t<I, FieldValue>;
+        if (data[0] != FieldCodec<T>::TYPE) {
+            return DecodeAlternative<I + 1>(data, value);
+        }
+        T field;
+        uint32_t status = DecodeField(data, field);
+        value = std::move(field);
+        return status;
+    } else {
+        LOG_ERROR("DistributedObjectImpl::Decode unknown type %{public}d", data[0]);
+        return ERR_DATA_LEN;
+    }
+}
+} // namespace
+
+std::atomic<size_t> DistributedObjectImpl::chunkThreshold_ { DistributedObjectImpl::CHUNK_THRESHOLD };
+
+void DistributedObjectImpl::SetChunkThreshold(size_t bytes)
+{
+    chunkThreshold_.store(bytes, std::memory_order_relaxed);
+}
+
+size_t DistributedObjectImpl::ChunkThreshold()
+{
+    // a peer without the capability would read the manifest as the value
+    if (!PeerCapabilities::GetInstance().AllHave(PeerCapabilities::CHUNKED_VALUES)) {
+        return SIZE_MAX;
+    }
+    return chunkThreshold_.load(std::memory_order_relaxed);
+}
+
 DistributedObjectImpl::~DistributedObjectImpl()
 {
 }
@@ -51,13 +170,21 @@ uint32_t GetNum(Bytes &data, uint32_t offset, void *val, uint32_t valLen)
     return SUCCESS;
 }
 
+// paths of nested fields outgrow the small string buffer, reuse one per thread for the prefixed key
+static const std::string &FieldKey(const std::string &key)
+{
+    static thread_local std::string fieldKey;
+    fieldKey.assign(FIELDS_PREFIX).append(key);
+    return fieldKey;
+}
+
 uint32_t DistributedObjectImpl::PutDouble(const std::string &key, double value)
 {
     Bytes data;
     Type type = Type::TYPE_DOUBLE;
     PutNum(&type, 0, sizeof(type), data);
     PutNum(&value, sizeof(type), sizeof(value), data);
-    uint32_t status = flatObjectStore_->Put(sessionId_, FIELDS_PREFIX + key, data);
+    uint32_t status = flatObjectStore_->Put(sessionId_, FieldKey(key), data);
     if (status != SUCCESS) {
         LOG_ERROR("DistributedObjectImpl::PutDouble setField err %{public}d", status);
     }
@@ -70,7 +197,7 @@ uint32_t DistributedObjectImpl::PutBoolean(const std::string &key, bool value)
     Type type = Type::TYPE_BOOLEAN;
     PutNum(&type, 0, sizeof(type), data);
     PutNum(&value, sizeof(type), sizeof(value), data);
-    uint32_t status = flatObjectStore_->Put(sessionId_, FIELDS_PREFIX + key, data);
+    uint32_t status = flatObjectStore_->Put(sessionId_, FieldKey(key), data);
     if (status != SUCCESS) {
         LOG_ERROR("DistributedObjectImpl::PutBoolean setField err %{public}d", status);
     }
@@ -81,10 +208,10 @@ uint32_t DistributedObjectImpl::PutString(const std::string &key, const std::str
 {
     Bytes data;
     Type type = Type::TYPE_STRING;
+    data.reserve(sizeof(type) + value.size());
     PutNum(&type, 0, sizeof(type), data);
-    Bytes dst = StringUtils::StrToBytes(value);
-    data.insert(data.end(), dst.begin(), dst.end());
-    uint32_t status = flatObjectStore_->Put(sessionId_, FIELDS_PREFIX + key, data);
+    data.insert(data.end(), value.begin(), value.end());
+    uint32_t status = flatObjectStore_->Put(sessionId_, FieldKey(key), data);
     if (status != SUCCESS) {
         LOG_ERROR("DistributedObjectImpl::PutString setField err %{public}d", status);
     }
@@ -94,8 +221,7 @@ uint32_t DistributedObjectImpl::PutString(const std::string &key, const std::str
 uint32_t DistributedObjectImpl::GetDouble(const std::string &key, double &value)
 {
     Bytes data;
-    Bytes keyBytes = StringUtils::StrToBytes(key);
-    uint32_t status = flatObjectStore_->Get(sessionId_, FIELDS_PREFIX + key, data);
+    uint32_t status = flatObjectStore_->Get(sessionId_, FieldKey(key), data);
     if (status != SUCCESS) {
         LOG_ERROR("DistributedObjectImpl:GetDouble field not exist. %{public}d %{public}s", status, key.c_str());
         return status;
@@ -110,8 +236,7 @@ uint32_t DistributedObjectImpl::GetDouble(const std::string &key, double &value)
 uint32_t DistributedObjectImpl::GetBoolean(const std::string &key, bool &value)
 {
     Bytes data;
-    Bytes keyBytes = StringUtils::StrToBytes(key);
-    uint32_t status = flatObjectStore_->Get(sessionId_, FIELDS_PREFIX + key, data);
+    uint32_t status = flatObjectStore_->Get(sessionId_, FieldKey(key), data);
     if (status != SUCCESS) {
         LOG_ERROR("DistributedObjectImpl:GetBoolean field not exist. %{public}d %{public}s", status, key.c_str());
         return status;
@@ -127,7 +252,7 @@ uint32_t DistributedObjectImpl::GetBoolean(const std::string &key, bool &value)
 uint32_t DistributedObjectImpl::GetString(const std::string &key, std::string &value)
 {
     Bytes data;
-    uint32_t status = flatObjectStore_->Get(sessionId_, FIELDS_PREFIX + key, data);
+    uint32_t status = flatObjectStore_->Get(sessionId_, FieldKey(key), data);
     if (status != SUCCESS) {
         LOG_ERROR("DistributedObjectImpl:GetString field not exist. %{public}d %{public}s", status, key.c_str());
         return status;
@@ -142,7 +267,7 @@ uint32_t DistributedObjectImpl::GetString(const std::string &key, std::string &v
 uint32_t DistributedObjectImpl::GetType(const std::string &key, Type &type)
 {
     Bytes data;
-    uint32_t status = flatObjectStore_->Get(sessionId_, FIELDS_PREFIX + key, data);
+    uint32_t status = flatObjectStore_->Get(sessionId_, FieldKey(key), data);
     if (status != SUCCESS) {
         LOG_ERROR("DistributedObjectImpl:GetString field not exist. %{public}d %{public}s", status, key.c_str());
         return status;
@@ -152,6 +277,9 @@ uint32_t DistributedObjectImpl::GetType(const std::string &key, Type &type)
         LOG_ERROR("DistributedObjectImpl::GetBoolean getNum err. %{public}d", status);
         return status;
     }
+    if (IsManifest(data)) {
+        type = TYPE_COMPLEX;
+    }
     return SUCCESS;
 }
 std::string &DistributedObjectImpl::GetSessionId()
@@ -165,23 +293,250 @@ DistributedObjectImpl::DistributedObjectImpl(const std::string &sessionId, FlatO
 }
 uint32_t DistributedObjectImpl::PutComplex(const std::string &key, const std::vector<uint8_t> &value)
 {
+    return PutComplex(key, value, nullptr, 0);
+}
+uint32_t DistributedObjectImpl::GetComplex(const std::string &key, std::vector<uint8_t> &value)
+{
+    size_t offset = 0;
+    uint32_t status = GetComplex(key, value, offset);
+    if (status != SUCCESS) {
+        return status;
+    }
+    // hand back what PutComplex was given, without the type header
+    value.erase(value.begin(), value.begin() + offset);
+    return status;
+}
+
+uint32_t DistributedObjectImpl::PutComplex(
+    const std::string &key, const std::vector<uint8_t> &head, const uint8_t *tail, size_t size)
+{
+    // the only copy of a large value, from the caller straight into the record handed to the store
     Bytes data;
     Type type = Type::TYPE_COMPLEX;
+    data.reserve(sizeof(type) + head.size() + size);
     PutNum(&type, 0, sizeof(type), data);
-    data.insert(data.end(), value.begin(), value.end());
-    uint32_t status = flatObjectStore_->Put(sessionId_, FIELDS_PREFIX + key, data);
+    data.insert(data.end(), head.begin(), head.end());
+    if (size > 0) {
+        data.insert(data.end(), tail, tail + size);
+    }
+    if (head.size() + size >= ChunkThreshold()) {
+        std::map<std::string, Bytes> records;
+        records.emplace(FieldKey(key), std::move(data));
+        return PutRecords(records);
+    }
+    uint32_t status = flatObjectStore_->Put(sessionId_, FieldKey(key), data);
     if (status != SUCCESS) {
-        LOG_ERROR("DistributedObjectImpl::PutBoolean setField err %{public}d", status);
+        LOG_ERROR("DistributedObjectImpl::PutComplex setField err %{public}d", status);
     }
     return status;
 }
-uint32_t DistributedObjectImpl::GetComplex(const std::string &key, std::vector<uint8_t> &value)
+
+uint32_t DistributedObjectImpl::GetComplex(const std::string &key, std::vector<uint8_t> &value, size_t &offset)
 {
-    uint32_t status = flatObjectStore_->Get(sessionId_, FIELDS_PREFIX + key, value);
+    uint32_t status = flatObjectStore_->Get(sessionId_, FieldKey(key), value);
     if (status != SUCCESS) {
-        LOG_ERROR("DistributedObjectImpl:GetString field not exist. %{public}d %{public}s", status, key.c_str());
+        LOG_ERROR("DistributedObjectImpl:GetComplex field not exist. %{public}d %{public}s", status, key.c_str());
         return status;
     }
+    if (value.size() < sizeof(Type)) {
+        LOG_ERROR("DistributedObjectImpl:GetComplex data too short %{public}zu", value.size());
+        return ERR_DATA_LEN;
+    }
+    if (IsManifest(value)) {
+        Bytes payload;
+        status = Assemble(value, nullptr, payload);
+        if (status != SUCCESS) {
+            return status;
+        }
+        value = std::move(payload);
+        offset = 0;
+        return SUCCESS;
+    }
+    offset = sizeof(Type);
     return status;
 }
+
+Bytes DistributedObjectImpl::Encode(const FieldValue &value)
+{
+    Bytes data;
+    std::visit([&data](const auto &field) { EncodeField(field, data); }, value);
+    return data;
+}
+
+uint32_t DistributedObjectImpl::Decode(const Bytes &data, FieldValue &value)
+{
+    if (data.empty()) {
+        return ERR_DATA_LEN;
+    }
+    return DecodeAlternative(data, value);
+}
+
+uint32_t DistributedObjectImpl::PutRecord(const std::string &key, const std::vector<uint8_t> &record)
+{
+    // a manifest is only ever written by PutRecords, with the chunks it lists
+    if (record.empty() || IsManifest(record)) {
+        LOG_ERROR("DistributedObjectImpl::PutRecord bad record %{public}s", key.c_str());
+        return ERR_DATA_LEN;
+    }
+    if (record[0] == TYPE_COMPLEX && record.size() - sizeof(Type) >= ChunkThreshold()) {
+        std::map<std::string, Bytes> records;
+        records.emplace(FieldKey(key), record);
+        return PutRecords(records);
+    }
+    uint32_t status = flatObjectStore_->Put(sessionId_, FieldKey(key), record);
+    if (status != SUCCESS) {
+        LOG_ERROR("DistributedObjectImpl::PutRecord setField err %{public}d", status);
+    }
+    return status;
+}
+
+uint32_t DistributedObjectImpl::GetRecord(const std::string &key, std::vector<uint8_t> &record)
+{
+    uint32_t status = flatObjectStore_->Get(sessionId_, FieldKey(key), record);
+    if (status != SUCCESS) {
+        LOG_ERROR("DistributedObjectImpl:GetRecord field not exist. %{public}d %{public}s", status, key.c_str());
+        return status;
+    }
+    if (IsManifest(record)) {
+        Bytes payload;
+        status = Assemble(record, nullptr, payload);
+        if (status != SUCCESS) {
+            return status;
+        }
+        record.clear();
+        record.reserve(sizeof(Type) + payload.size());
+        record.push_back(TYPE_COMPLEX);
+        record.insert(record.end(), payload.begin(), payload.end());
+    }
+    return SUCCESS;
+}
+
+uint32_t DistributedObjectImpl::PutBatch(const std::map<std::string, FieldValue> &fields)
+{
+    return PutBatch(fields, {});
+}
+
+uint32_t DistributedObjectImpl::PutBatch(
+    const std::map<std::string, FieldValue> &fields, const std::vector<std::string> &removed)
+{
+    std::map<std::string, Bytes> data;
+    for (auto &[key, value] : fields) {
+        data.emplace(FieldKey(key), Encode(value));
+    }
+    std::vector<std::string> fieldKeys;
+    fieldKeys.reserve(removed.size());
+    for (auto &key : removed) {
+        fieldKeys.push_back(FieldKey(key));
+    }
+    return PutRecords(data, fieldKeys);
+}
+
+uint32_t DistributedObjectImpl::PutRecords(
+    std::map<std::string, Bytes> &records, const std::vector<std::string> &removed)
+{
+    size_t threshold = ChunkThreshold();
+    std::map<std::string, Bytes> batch;
+    for (auto &[fieldKey, record] : records) {
+        if (record.empty() || record[0] != TYPE_COMPLEX || record.size() - sizeof(Type) < threshold) {
+            batch.insert_or_assign(fieldKey, std::move(record));
+            continue;
+        }
+        // the new chunks and the manifest naming them are one write, a chunk once written is never
+        // deleted, so the previous chunks are there for any manifest a peer is still syncing
+        batch.insert_or_assign(fieldKey,
+            Chunk(record.data() + sizeof(Type), record.size() - sizeof(Type), StoredChunks(fieldKey), batch));
+    }
+    uint32_t status = flatObjectStore_->PutBatch(sessionId_, batch, removed);
+    if (status != SUCCESS) {
+        LOG_ERROR("DistributedObjectImpl::PutBatch err %{public}d", status);
+    }
+    return status;
+}
+
+std::set<std::string> DistributedObjectImpl::StoredChunks(const std::string &fieldKey)
+{
+    std::set<std::string> chunkKeys;
+    Bytes data;
+    std::vector<std::pair<std::string, uint32_t>> chunks;
+    if (flatObjectStore_->Get(sessionId_, fieldKey, data) == SUCCESS && IsManifest(data)
+        && ParseManifest(data, chunks)) {
+        for (auto &chunk : chunks) {
+            chunkKeys.insert(chunk.first);
+        }
+    }
+    return chunkKeys;
+}
+
+uint32_t DistributedObjectImpl::Assemble(
+    const Bytes &manifest, const std::map<std::string, Bytes> *records, Bytes &value)
+{
+    std::vector<std::pair<std::string, uint32_t>> chunks;
+    if (!ParseManifest(manifest, chunks)) {
+        LOG_ERROR("DistributedObjectImpl::Assemble bad manifest %{public}zu", manifest.size());
+        return ERR_DATA_LEN;
+    }
+    size_t total = 0;
+    for (auto &chunk : chunks) {
+        total += chunk.second;
+    }
+    value.clear();
+    value.reserve(total);
+    Bytes loaded;
+    for (auto &[chunkKey, size] : chunks) {
+        const Bytes *chunk = nullptr;
+        if (records != nullptr) {
+            auto record = records->find(chunkKey);
+            chunk = record == records->end() ? nullptr : &record->second;
+        } else if (flatObjectStore_->Get(sessionId_, chunkKey, loaded) == SUCCESS) {
+            chunk = &loaded;
+        }
+        // a peer may still be sending it
+        if (chunk == nullptr || chunk->size() != size) {
+            LOG_ERROR("DistributedObjectImpl::Assemble chunk %{public}s missing", chunkKey.c_str());
+            return ERR_DATA_LEN;
+        }
+        value.insert(value.end(), chunk->begin(), chunk->end());
+    }
+    return SUCCESS;
+}
+
+uint32_t DistributedObjectImpl::GetAll(std::map<std::string, FieldValue> &fields)
+{
+    return GetAll("", fields);
+}
+
+uint32_t DistributedObjectImpl::GetAll(const std::string &prefix, std::map<std::string, FieldValue> &fields)
+{
+    std::map<std::string, Bytes> data;
+    // the whole table brings the chunks along, a prefix read loads the chunks of its fields only
+    bool whole = prefix.empty();
+    uint32_t status = whole ? flatObjectStore_->GetAll(sessionId_, data)
+                            : flatObjectStore_->GetAll(sessionId_, FIELDS_PREFIX + prefix, data);
+    if (status != SUCCESS) {
+        LOG_ERROR("DistributedObjectImpl::GetAll err %{public}d", status);
+        return status;
+    }
+    fields.clear();
+    for (auto &[key, value] : data) {
+        if (key.compare(0, FIELDS_PREFIX_LEN, FIELDS_PREFIX) != 0) {
+            continue;
+        }
+        if (IsManifest(value)) {
+            Bytes payload;
+            if (Assemble(value, whole ? &data : nullptr, payload) != SUCCESS) {
+                LOG_ERROR("DistributedObjectImpl::GetAll bad field %{public}s", key.c_str());
+                continue;
+            }
+            fields.emplace(key.substr(FIELDS_PREFIX_LEN), std::move(payload));
+            continue;
+        }
+        FieldValue field;
+        if (Decode(value, field) != SUCCESS) {
+            LOG_ERROR("DistributedObjectImpl::GetAll bad field %{public}s", key.c_str());
+            continue;
+        }
+        fields.emplace(key.substr(FIELDS_PREFIX_LEN), std::move(field));
+    }
+    return SUCCESS;
+}
 } // namespace OHOS::ObjectStore
\ No newline at end of file
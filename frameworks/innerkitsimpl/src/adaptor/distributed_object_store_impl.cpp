@@ -15,10 +15,13 @@
 
 #include <thread>
 
+#include "communication_provider.h"
 #include "distributed_object_impl.h"
 #include "distributed_objectstore_impl.h"
+#include "flat_object_storage_engine.h"
 #include "objectstore_errors.h"
-#include "softbus_adapter.h"
+#include "propagation_tracer.h"
+#include "store_statistics.h"
 #include "string_utils.h"
 
 namespace OHOS::ObjectStore {
@@ -45,12 +48,17 @@ DistributedObject *DistributedObjectStoreImpl::CacheObject(
 }
 
 DistributedObject *DistributedObjectStoreImpl::CreateObject(const std::string &sessionId)
+{
+    return CreateObject(sessionId, ObjectOptions());
+}
+
+DistributedObject *DistributedObjectStoreImpl::CreateObject(const std::string &sessionId, const ObjectOptions &options)
 {
     if (flatObjectStore_ == nullptr) {
         LOG_ERROR("DistributedObjectStoreImpl::CreateObject store not opened!");
         return nullptr;
     }
-    uint32_t status = flatObjectStore_->CreateObject(sessionId);
+    uint32_t status = flatObjectStore_->CreateObject(sessionId, options);
     if (status != SUCCESS) {
         LOG_ERROR("DistributedObjectStoreImpl::CreateObject CreateTable err %{public}d", status);
         return nullptr;
@@ -161,7 +169,7 @@ void DistributedObjectStoreImpl::TriggerRestore(std::function<void()> notifier)
                                     result = SYNC_FAIL;
                                     LOG_ERROR("%{public}s pull data fail %{public}d in device %{public}s",
                                         item->GetSessionId().c_str(), device.second,
-                                        SoftBusAdapter::GetInstance()->ToNodeID(device.first).c_str());
+                                        CommunicationProvider::GetInstance().ToNodeID(device.first).c_str());
                                 }
                             }
                             LOG_INFO("%{public}s pull data success", item->GetSessionId().c_str());
@@ -198,6 +206,52 @@ void DistributedObjectStoreImpl::TriggerRestore(std::function<void()> notifier)
     th.detach();
     return;
 }
+ObjectStoreStatistics DistributedObjectStoreImpl::GetStatistics()
+{
+    ObjectStoreStatistics statistics = StoreStatistics::GetInstance().Snapshot();
+    // applications know peers by network id, the same as in status notifications
+    std::map<std::string, PeerStatistics> peers;
+    for (auto &[deviceId, peer] : statistics.peers) {
+        PeerStatistics &item = peers[CommunicationProvider::GetInstance().ToNodeID(deviceId)];
+        item.bytesSent += peer.bytesSent;
+        item.bytesReceived += peer.bytesReceived;
+        item.sync = peer.sync;
+    }
+    statistics.peers.swap(peers);
+    if (flatObjectStore_ != nullptr) {
+        flatObjectStore_->GetUsage(statistics.sessions);
+    }
+    for (auto &item : statistics.sessions) {
+        if (item.second.resident) {
+            statistics.residentBytes += item.second.bytes;
+        }
+    }
+    if (statistics.memoryBudget != 0 && statistics.residentBytes > statistics.memoryBudget) {
+        statistics.budgetOverrun = statistics.residentBytes - statistics.memoryBudget;
+    }
+    return statistics;
+}
+
+void DistributedObjectStoreImpl::SetTraceEnabled(bool enabled)
+{
+    LOG_INFO("trace %{public}s", enabled ? "on" : "off");
+    PropagationTracer::GetInstance().SetEnabled(enabled);
+}
+
+std::string DistributedObjectStoreImpl::ExportTrace()
+{
+    return PropagationTracer::GetInstance().Export(CommunicationProvider::GetInstance().GetLocalDevice().deviceId);
+}
+
+uint64_t DistributedObjectStoreImpl::SetMemoryBudget(uint64_t bytes)
+{
+    if (flatObjectStore_ == nullptr) {
+        LOG_ERROR("DistributedObjectStoreImpl::SetMemoryBudget store not opened!");
+        return 0;
+    }
+    return flatObjectStore_->SetMemoryBudget(bytes);
+}
+
 uint32_t DistributedObjectStoreImpl::SetStatusNotifier(std::shared_ptr<StatusNotifier> notifier)
 {
     if (flatObjectStore_ == nullptr) {
@@ -231,7 +285,8 @@ DistributedObjectStore *DistributedObjectStore::GetInstance(const std::string &b
         std::lock_guard<std::mutex> lock(instLock_);
         if (instPtr == nullptr && !bundleName.empty()) {
             LOG_INFO("new objectstore %{public}s", bundleName.c_str());
-            FlatObjectStore *flatObjectStore = new (std::nothrow) FlatObjectStore(bundleName);
+            FlatObjectStore *flatObjectStore =
+                new (std::nothrow) FlatObjectStore(bundleName, std::make_shared<FlatObjectStorageEngine>());
             if (flatObjectStore == nullptr) {
                 LOG_ERROR("no memory for FlatObjectStore malloc!");
                 return nullptr;
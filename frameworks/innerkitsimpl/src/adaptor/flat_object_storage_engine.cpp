@@ -14,17 +14,96 @@
  */
 #include "flat_object_storage_engine.h"
 
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <set>
+#include <string_view>
+
+#include "communication_provider.h"
 #include "logger.h"
 #include "objectstore_errors.h"
+#include "peer_capabilities.h"
 #include "process_communicator_impl.h"
+#include "propagation_tracer.h"
 #include "securec.h"
-#include "softbus_adapter.h"
+#include "store_statistics.h"
 #include "string_utils.h"
 #include "types_export.h"
 
 namespace OHOS::ObjectStore {
+namespace {
+bool CreateDataDir(const std::string &key, const std::string &dir)
+{
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if (error) {
+        LOG_ERROR("FlatObjectStorageEngine %{public}s no data dir %{public}s", key.c_str(), error.message().c_str());
+        return false;
+    }
+    return true;
+}
+
+DistributedDB::DBStatus PutInBatches(DistributedDB::KvStoreNbDelegate *delegate,
+    const std::vector<DistributedDB::Entry> &entries, size_t batchSize)
+{
+    for (size_t i = 0; i < entries.size(); i += batchSize) {
+        std::vector<DistributedDB::Entry> batch(
+            entries.begin() + i, entries.begin() + std::min(entries.size(), i + batchSize));
+        auto status = delegate->PutBatch(batch);
+        if (status != DistributedDB::DBStatus::OK) {
+            return status;
+        }
+    }
+    return DistributedDB::DBStatus::OK;
+}
+
+DistributedDB::DBStatus DeleteInBatches(
+    DistributedDB::KvStoreNbDelegate *delegate, const std::vector<Key> &keys, size_t batchSize)
+{
+    for (size_t i = 0; i < keys.size(); i += batchSize) {
+        std::vector<Key> batch(keys.begin() + i, keys.begin() + std::min(keys.size(), i + batchSize));
+        auto status = delegate->DeleteBatch(batch);
+        // none of the batch was stored, nothing to delete
+        if (status != DistributedDB::DBStatus::OK && status != DistributedDB::DBStatus::NOT_FOUND) {
+            return status;
+        }
+    }
+    return DistributedDB::DBStatus::OK;
+}
+
+// PutBatch and DeleteBatch take a bounded number of entries, the transaction keeps the batches
+// of the callers whole: peers and readers see all of it or none
+DistributedDB::DBStatus WriteInTransaction(DistributedDB::KvStoreNbDelegate *delegate,
+    const std::vector<DistributedDB::Entry> &entries, const std::vector<Key> &keys, size_t batchSize)
+{
+    auto status = delegate->StartTransaction();
+    if (status != DistributedDB::DBStatus::OK) {
+        return status;
+    }
+    status = PutInBatches(delegate, entries, batchSize);
+    status = status == DistributedDB::DBStatus::OK ? DeleteInBatches(delegate, keys, batchSize) : status;
+    status = status == DistributedDB::DBStatus::OK ? delegate->Commit() : status;
+    if (status != DistributedDB::DBStatus::OK) {
+        delegate->Rollback();
+    }
+    return status;
+}
+
+size_t ValueDigest(const Value &value)
+{
+    return std::hash<std::string_view>()(
+        std::string_view(reinterpret_cast<const char *>(value.data()), value.size()));
+}
+} // namespace
+
 FlatObjectStorageEngine::~FlatObjectStorageEngine()
 {
+    if (isOpened_) {
+        // the puts still buffered would die with an engine nobody closed
+        FlushAll();
+    }
+    StopFlusher();
     if (!isOpened_) {
         return;
     }
@@ -38,23 +117,37 @@ uint32_t FlatObjectStorageEngine::Open(const std::string &bundleName)
         LOG_INFO("FlatObjectDatabase: No need to reopen it");
         return SUCCESS;
     }
+    auto &statistics = StoreStatistics::GetInstance();
+    auto start = StoreStatistics::Clock::now();
     auto status = DistributedDB::KvStoreDelegateManager::SetProcessLabel("objectstoreDB", bundleName);
     if (status != DistributedDB::DBStatus::OK) {
         LOG_ERROR("delegate SetProcessLabel failed: %{public}d.", static_cast<int>(status));
         return ERR_DB_SET_PROCESS;
     }
+    auto phaseEnd = StoreStatistics::Clock::now();
+    statistics.RecordInit(StoreStatistics::INIT_PROCESS_LABEL, phaseEnd - start);
 
+    start = phaseEnd;
     auto communicator = std::make_shared<ProcessCommunicatorImpl>();
     auto commStatus = DistributedDB::KvStoreDelegateManager::SetProcessCommunicator(communicator);
     if (commStatus != DistributedDB::DBStatus::OK) {
         LOG_ERROR("set distributed db communicator failed.");
         return ERR_DB_SET_PROCESS;
     }
+    phaseEnd = StoreStatistics::Clock::now();
+    statistics.RecordInit(StoreStatistics::INIT_COMMUNICATOR, phaseEnd - start);
+
+    start = phaseEnd;
     storeManager_ = std::make_shared<DistributedDB::KvStoreDelegateManager>(bundleName, "default");
     if (storeManager_ == nullptr) {
         LOG_ERROR("FlatObjectStorageEngine::make shared fail");
         return ERR_NOMEM;
     }
+    statistics.RecordInit(StoreStatistics::INIT_STORE_MANAGER, StoreStatistics::Clock::now() - start);
+    {
+        std::lock_guard<std::mutex> lock(flushMutex_);
+        stopFlusher_ = false;
+    }
     isOpened_ = true;
     LOG_INFO("FlatObjectDatabase::Open Succeed");
     return SUCCESS;
@@ -66,122 +159,182 @@ uint32_t FlatObjectStorageEngine::Close()
         LOG_INFO("FlatObjectStorageEngine::Close has been closed!");
         return SUCCESS;
     }
+    StopFlusher();
     std::unique_lock<std::shared_mutex> lock(operationMutex_);
+    uint32_t result = SUCCESS;
+    for (auto &item : pending_) {
+        uint32_t status = Flush(item.first);
+        if (status != SUCCESS) {
+            LOG_ERROR("%{public}s closed with %{public}zu puts lost", item.first.c_str(), item.second.size());
+            result = status;
+        }
+    }
     storeManager_ = nullptr;
     isOpened_ = false;
-    return SUCCESS;
+    return result;
 }
 
-uint32_t FlatObjectStorageEngine::CreateTable(const std::string &key)
+uint32_t FlatObjectStorageEngine::CreateTable(const std::string &key, const ObjectOptions &options)
 {
     if (!isOpened_) {
         return ERR_DB_NOT_INIT;
     }
-    {
-        std::unique_lock<std::shared_mutex> lock(operationMutex_);
-        if (delegates_.count(key) != 0) {
-            LOG_ERROR("FlatObjectStorageEngine::CreateTable %{public}s already created", key.c_str());
-            return ERR_EXIST;
-        }
+    // the config is of the manager, not of the store, so the lock is held until the store is open
+    std::unique_lock<std::shared_mutex> lock(operationMutex_);
+    if (tables_.count(key) != 0) {
+        LOG_ERROR("FlatObjectStorageEngine::CreateTable %{public}s already created", key.c_str());
+        return ERR_EXIST;
     }
-
-    DistributedDB::KvStoreConfig config;
-    config.dataDir = "/data/log";
-    storeManager_->SetKvStoreConfig(config);
-    DistributedDB::KvStoreNbDelegate *kvStore = nullptr;
-    DistributedDB::DBStatus status;
-    DistributedDB::KvStoreNbDelegate::Option option = { true, true,
-        false }; // createIfNecessary, isMemoryDb, isEncryptedDb
-    LOG_INFO("start create table");
-    storeManager_->GetKvStore(key, option,
-        [&status, &kvStore](DistributedDB::DBStatus dbStatus, DistributedDB::KvStoreNbDelegate *kvStoreNbDelegate) {
-            status = dbStatus;
-            kvStore = kvStoreNbDelegate;
-            LOG_INFO("create table result %{public}d", status);
-        });
-    bool autoSync = true;
-    DistributedDB::PragmaData data = static_cast<DistributedDB::PragmaData>(&autoSync);
-    LOG_INFO("start Pragma");
-    status = kvStore->Pragma(DistributedDB::AUTO_SYNC, data);
-    if (status != DistributedDB::DBStatus::OK) {
-        LOG_ERROR("FlatObjectStorageEngine::CreateTable %{public}s getkvstore fail[%{public}d]", key.c_str(), status);
-        return ERR_DB_GETKV_FAIL;
+    Table table;
+    table.options = options;
+    uint32_t result = OpenDelegate(key, table);
+    if (result != SUCCESS) {
+        return result;
     }
     LOG_INFO("create table %{public}s success", key.c_str());
-    {
-        std::unique_lock<std::shared_mutex> lock(operationMutex_);
-        delegates_.insert_or_assign(key, kvStore);
+    table.lastUsed = std::chrono::steady_clock::now();
+    tables_.insert_or_assign(key, std::move(table));
+    if (options.durable) {
+        pending_[key].clear();
     }
-
-    auto onComplete = [key, this](const std::map<std::string, DistributedDB::DBStatus> &devices) {
-        LOG_INFO("complete");
-        for (auto item : devices) {
-            LOG_INFO("%{public}s pull data result %{public}d in device %{public}s", key.c_str(), item.second,
-                SoftBusAdapter::GetInstance()->ToNodeID(item.first).c_str());
-        }
-        if (statusWatcher_ != nullptr) {
-            for (auto item : devices) {
-                statusWatcher_->OnChanged(key, SoftBusAdapter::GetInstance()->ToNodeID(item.first),
-                    item.second == DistributedDB::OK ? "online" : "offline");
-            }
-        }
-    };
-    SyncAllData(key, onComplete);
+    EnforceBudget(key);
+    SyncLocked(key, PullReporter(key));
     return SUCCESS;
 }
 
 uint32_t FlatObjectStorageEngine::GetTable(const std::string &key, std::map<std::string, Value> &result)
+{
+    return GetItems(key, "", result);
+}
+
+uint32_t FlatObjectStorageEngine::GetItems(
+    const std::string &key, const std::string &prefix, std::map<std::string, Value> &result)
 {
     if (!isOpened_) {
         LOG_ERROR("not opened %{public}s", key.c_str());
         return ERR_DB_NOT_INIT;
     }
     std::unique_lock<std::shared_mutex> lock(operationMutex_);
-    if (delegates_.count(key) == 0) {
+    auto delegate = GetDelegate(key);
+    if (delegate == nullptr) {
         LOG_INFO("FlatObjectStorageEngine::GetTable %{public}s not exist", key.c_str());
         return ERR_DB_NOT_EXIST;
     }
     result.clear();
-    DistributedDB::KvStoreResultSet *resultSet = nullptr;
-    Key emptyKey;
+    std::vector<DistributedDB::Entry> entries;
     LOG_INFO("start GetEntries");
-    DistributedDB::DBStatus status = delegates_.at(key)->GetEntries(emptyKey, resultSet);
-    if (status != DistributedDB::DBStatus::OK) {
+    DistributedDB::DBStatus status = delegate->GetEntries(StringUtils::StrToBytes(prefix), entries);
+    // nothing in the database yet, the buffered puts may still match
+    if (status != DistributedDB::DBStatus::OK && status != DistributedDB::DBStatus::NOT_FOUND) {
         LOG_INFO("FlatObjectStorageEngine::GetTable %{public}s GetEntries fail", key.c_str());
         return ERR_DB_GET_FAIL;
     }
-    LOG_INFO("end GetEntries");
-    while (resultSet->IsAfterLast()) {
-        DistributedDB::Entry entry;
-        status = resultSet->GetEntry(entry);
-        if (status != DistributedDB::DBStatus::OK) {
-            LOG_INFO("FlatObjectStorageEngine::GetTable  GetEntry fail");
-            return ERR_DB_ENTRY_FAIL;
+    LOG_INFO("end GetEntries %{public}zu", entries.size());
+    for (auto &entry : entries) {
+        result.insert_or_assign(StringUtils::BytesToStr(entry.key), std::move(entry.value));
+    }
+    auto pending = pending_.find(key);
+    if (pending != pending_.end()) {
+        for (auto it = pending->second.lower_bound(prefix);
+             it != pending->second.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            result.insert_or_assign(it->first, it->second);
         }
-        result.insert_or_assign(StringUtils::BytesToStr(entry.key), entry.value);
-        resultSet->MoveToNext();
     }
     return SUCCESS;
 }
 
-uint32_t FlatObjectStorageEngine::UpdateItem(const std::string &key, const std::string &itemKey, Value &value)
+uint32_t FlatObjectStorageEngine::UpdateItem(const std::string &key, const std::string &itemKey, const Value &value)
 {
     if (!isOpened_) {
         return ERR_DB_NOT_INIT;
     }
     std::unique_lock<std::shared_mutex> lock(operationMutex_);
-    if (delegates_.count(key) == 0) {
+    auto delegate = GetDelegate(key);
+    if (delegate == nullptr) {
         LOG_INFO("FlatObjectStorageEngine::GetTable %{public}s not exist", key.c_str());
         return ERR_DB_NOT_EXIST;
     }
-    auto delegate = delegates_.at(key);
+    uint32_t flushed = RetryFailedFlush(key);
+    if (flushed != SUCCESS) {
+        return flushed;
+    }
+    // a put of what is stored already would still commit, sync and wake the watchers of every peer
+    if (IsUnchanged(key, delegate, itemKey, value)) {
+        return SUCCESS;
+    }
     LOG_INFO("start Put");
+    uint64_t traceId = PropagationTracer::GetInstance().Begin(key, itemKey);
+    OnWritten(key, { { itemKey, value } });
+    auto pending = pending_.find(key);
+    if (pending != pending_.end()) {
+        return Buffer(key, pending->second, { { itemKey, value } });
+    }
     auto status = delegate->Put(StringUtils::StrToBytes(itemKey), value);
     if (status != DistributedDB::DBStatus::OK) {
         LOG_ERROR("%{public}s PutBatch fail[%{public}d]", key.c_str(), status);
         return ERR_CLOSE_STORAGE;
     }
+    PropagationTracer::GetInstance().Record(traceId, PropagationTracer::COMMIT, "", key);
     LOG_INFO("put success");
+    EnforceBudget(key);
+    return SUCCESS;
+}
+
+uint32_t FlatObjectStorageEngine::UpdateItems(
+    const std::string &key, const std::map<std::string, Value> &data, const std::vector<std::string> &removed)
+{
+    if (!isOpened_) {
+        return ERR_DB_NOT_INIT;
+    }
+    if (data.empty() && removed.empty()) {
+        return SUCCESS;
+    }
+    std::unique_lock<std::shared_mutex> lock(operationMutex_);
+    auto delegate = GetDelegate(key);
+    if (delegate == nullptr) {
+        LOG_INFO("FlatObjectStorageEngine::UpdateItems %{public}s not exist", key.c_str());
+        return ERR_DB_NOT_EXIST;
+    }
+    uint32_t flushed = RetryFailedFlush(key);
+    if (flushed != SUCCESS) {
+        return flushed;
+    }
+    std::map<std::string, Value> changed;
+    std::vector<DistributedDB::Entry> entries;
+    entries.reserve(data.size());
+    for (auto &[itemKey, value] : data) {
+        if (!IsUnchanged(key, delegate, itemKey, value)) {
+            changed.emplace(itemKey, value);
+            entries.push_back({ StringUtils::StrToBytes(itemKey), value });
+        }
+    }
+    if (changed.empty() && removed.empty()) {
+        return SUCCESS;
+    }
+    LOG_INFO("start PutBatch %{public}zu, delete %{public}zu", entries.size(), removed.size());
+    // the batch is one trace, named after its first item
+    uint64_t traceId =
+        PropagationTracer::GetInstance().Begin(key, changed.empty() ? removed.front() : changed.begin()->first);
+    OnWritten(key, changed);
+    auto pending = pending_.find(key);
+    if (!removed.empty()) {
+        // a delete is not buffered, the puts go with it so that no peer sees one without the other
+        uint32_t result = FlushWithDeletes(key, delegate, changed, removed);
+        if (result != SUCCESS) {
+            return result;
+        }
+    } else if (pending != pending_.end()) {
+        return Buffer(key, pending->second, changed);
+    } else {
+        auto status = WriteInTransaction(delegate, entries, {}, WRITE_BEHIND_BATCH);
+        if (status != DistributedDB::DBStatus::OK) {
+            LOG_ERROR("%{public}s PutBatch fail[%{public}d]", key.c_str(), status);
+            return ERR_CLOSE_STORAGE;
+        }
+    }
+    PropagationTracer::GetInstance().Record(traceId, PropagationTracer::COMMIT, "", key);
+    LOG_INFO("put batch success");
+    EnforceBudget(key);
     return SUCCESS;
 }
 
@@ -191,19 +344,30 @@ uint32_t FlatObjectStorageEngine::DeleteTable(const std::string &key)
         return ERR_DB_NOT_INIT;
     }
     std::unique_lock<std::shared_mutex> lock(operationMutex_);
-    if (delegates_.count(key) == 0) {
+    auto table = tables_.find(key);
+    if (table == tables_.end()) {
         LOG_INFO("FlatObjectStorageEngine::GetTable %{public}s not exist", key.c_str());
         return ERR_DB_NOT_EXIST;
     }
     LOG_INFO("start DeleteTable %{public}s", key.c_str());
-    auto status = storeManager_->CloseKvStore(delegates_.at(key));
-    if (status != DistributedDB::DBStatus::OK) {
-        LOG_ERROR(
-            "FlatObjectStorageEngine::CloseKvStore %{public}s CloseKvStore fail[%{public}d]", key.c_str(), status);
-        return ERR_CLOSE_STORAGE;
+    if (pending_.count(key) != 0) {
+        uint32_t flushed = Flush(key);
+        if (flushed != SUCCESS) {
+            // the table stays open with its puts buffered, a retry of the delete flushes them again
+            return flushed;
+        }
+        pending_.erase(key);
+        flushErrors_.erase(key);
+    }
+    // an evicted table is closed already
+    uint32_t result = CloseDelegate(key, table->second);
+    if (result != SUCCESS) {
+        return result;
     }
     LOG_INFO("DeleteTable success");
-    delegates_.erase(key);
+    tables_.erase(table);
+    std::lock_guard<std::mutex> usageLock(usageMutex_);
+    usage_.erase(key);
     return SUCCESS;
 }
 
@@ -213,12 +377,21 @@ uint32_t FlatObjectStorageEngine::GetItem(const std::string &key, const std::str
         return ERR_DB_NOT_INIT;
     }
     std::unique_lock<std::shared_mutex> lock(operationMutex_);
-    if (delegates_.count(key) == 0) {
+    auto delegate = GetDelegate(key);
+    if (delegate == nullptr) {
         LOG_ERROR("FlatObjectStorageEngine::GetItem %{public}s not exist", key.c_str());
         return ERR_DB_NOT_EXIST;
     }
     LOG_INFO("start Get %{public}s", key.c_str());
-    DistributedDB::DBStatus status = delegates_.at(key)->Get(StringUtils::StrToBytes(itemKey), value);
+    auto pending = pending_.find(key);
+    if (pending != pending_.end()) {
+        auto item = pending->second.find(itemKey);
+        if (item != pending->second.end()) {
+            value = item->second;
+            return SUCCESS;
+        }
+    }
+    DistributedDB::DBStatus status = delegate->Get(StringUtils::StrToBytes(itemKey), value);
     if (status != DistributedDB::DBStatus::OK) {
         LOG_ERROR("FlatObjectStorageEngine::GetItem %{public}s item fail %{public}d", itemKey.c_str(), status);
         return status;
@@ -227,6 +400,42 @@ uint32_t FlatObjectStorageEngine::GetItem(const std::string &key, const std::str
     return SUCCESS;
 }
 
+uint32_t FlatObjectStorageEngine::DeleteItems(const std::string &key, const std::vector<std::string> &itemKeys)
+{
+    if (!isOpened_) {
+        return ERR_DB_NOT_INIT;
+    }
+    if (itemKeys.empty()) {
+        return SUCCESS;
+    }
+    std::unique_lock<std::shared_mutex> lock(operationMutex_);
+    auto delegate = GetDelegate(key);
+    if (delegate == nullptr) {
+        LOG_ERROR("FlatObjectStorageEngine::DeleteItems %{public}s not exist", key.c_str());
+        return ERR_DB_NOT_EXIST;
+    }
+    uint32_t flushed = RetryFailedFlush(key);
+    if (flushed != SUCCESS) {
+        return flushed;
+    }
+    std::vector<Key> keys;
+    keys.reserve(itemKeys.size());
+    auto pending = pending_.find(key);
+    for (auto &itemKey : itemKeys) {
+        if (pending != pending_.end()) {
+            pending->second.erase(itemKey);
+        }
+        keys.push_back(StringUtils::StrToBytes(itemKey));
+    }
+    LOG_INFO("start DeleteBatch %{public}zu", keys.size());
+    auto status = WriteInTransaction(delegate, {}, keys, WRITE_BEHIND_BATCH);
+    if (status != DistributedDB::DBStatus::OK) {
+        LOG_ERROR("%{public}s DeleteBatch fail[%{public}d]", key.c_str(), status);
+        return ERR_CLOSE_STORAGE;
+    }
+    return SUCCESS;
+}
+
 uint32_t FlatObjectStorageEngine::RegisterObserver(const std::string &key, std::shared_ptr<TableWatcher> watcher)
 {
     if (!isOpened_) {
@@ -234,7 +443,8 @@ uint32_t FlatObjectStorageEngine::RegisterObserver(const std::string &key, std::
         return ERR_DB_NOT_INIT;
     }
     std::unique_lock<std::shared_mutex> lock(operationMutex_);
-    if (delegates_.count(key) == 0) {
+    auto delegate = GetDelegate(key);
+    if (delegate == nullptr) {
         LOG_INFO("FlatObjectStorageEngine::RegisterObserver %{public}s not exist", key.c_str());
         return ERR_DB_NOT_EXIST;
     }
@@ -242,7 +452,6 @@ uint32_t FlatObjectStorageEngine::RegisterObserver(const std::string &key, std::
         LOG_INFO("FlatObjectStorageEngine::RegisterObserver observer already exist.");
         return SUCCESS;
     }
-    auto delegate = delegates_.at(key);
     std::vector<uint8_t> tmpKey;
     LOG_INFO("start RegisterObserver %{public}s", key.c_str());
     DistributedDB::DBStatus status =
@@ -263,7 +472,7 @@ uint32_t FlatObjectStorageEngine::UnRegisterObserver(const std::string &key)
         return ERR_DB_NOT_INIT;
     }
     std::unique_lock<std::shared_mutex> lock(operationMutex_);
-    if (delegates_.count(key) == 0) {
+    if (tables_.count(key) == 0) {
         LOG_INFO("FlatObjectStorageEngine::RegisterObserver %{public}s not exist", key.c_str());
         return ERR_DB_NOT_EXIST;
     }
@@ -272,7 +481,11 @@ uint32_t FlatObjectStorageEngine::UnRegisterObserver(const std::string &key)
         LOG_ERROR("FlatObjectStorageEngine::UnRegisterObserver observer not exist.");
         return ERR_NO_OBSERVER;
     }
-    auto delegate = delegates_.at(key);
+    // watched tables are never evicted, so this does not open one
+    auto delegate = GetDelegate(key);
+    if (delegate == nullptr) {
+        return ERR_DB_NOT_EXIST;
+    }
     std::shared_ptr<TableWatcher> watcher = iter->second;
     LOG_INFO("start UnRegisterObserver %{public}s", key.c_str());
     DistributedDB::DBStatus status = delegate->UnRegisterObserver(watcher.get());
@@ -299,21 +512,29 @@ uint32_t FlatObjectStorageEngine::SetStatusNotifier(std::shared_ptr<StatusWatche
             return;
         }
         if (onlineStatus) {
+            {
+                std::unique_lock<std::shared_mutex> lock(operationMutex_);
+                auto table = tables_.find(storeId);
+                // an evicted table pulls when it is opened again
+                if (table != tables_.end() && table->second.spilled) {
+                    return;
+                }
+            }
             auto onComplete = [this, storeId](const std::map<std::string, DistributedDB::DBStatus> &devices) {
                 for (auto item : devices) {
                     LOG_INFO("%{public}s pull data result %{public}d in device %{public}s", storeId.c_str(),
-                        item.second, SoftBusAdapter::GetInstance()->ToNodeID(item.first).c_str());
+                        item.second, CommunicationProvider::GetInstance().ToNodeID(item.first).c_str());
                 }
                 if (statusWatcher_ != nullptr) {
                     for (auto item : devices) {
-                        statusWatcher_->OnChanged(storeId, SoftBusAdapter::GetInstance()->ToNodeID(item.first),
+                        statusWatcher_->OnChanged(storeId, CommunicationProvider::GetInstance().ToNodeID(item.first),
                             item.second == DistributedDB::OK ? "online" : "offline");
                     }
                 }
             };
             SyncAllData(storeId, onComplete);
         } else {
-            statusWatcher_->OnChanged(storeId, SoftBusAdapter::GetInstance()->ToNodeID(deviceId), "offline");
+            statusWatcher_->OnChanged(storeId, CommunicationProvider::GetInstance().ToNodeID(deviceId), "offline");
         }
     };
     storeManager_->SetStoreStatusNotifier(databaseStatusNotifyCallback);
@@ -327,13 +548,19 @@ uint32_t FlatObjectStorageEngine::SyncAllData(const std::string &sessionId,
 {
     LOG_INFO("start");
     std::unique_lock<std::shared_mutex> lock(operationMutex_);
-    if (delegates_.count(sessionId) == 0) {
+    return SyncLocked(sessionId, onComplete);
+}
+
+uint32_t FlatObjectStorageEngine::SyncLocked(const std::string &sessionId,
+    const std::function<void(const std::map<std::string, DistributedDB::DBStatus> &)> &onComplete)
+{
+    DistributedDB::KvStoreNbDelegate *kvstore = GetDelegate(sessionId);
+    if (kvstore == nullptr) {
         LOG_ERROR("FlatObjectStorageEngine::SyncAllData %{public}s already deleted", sessionId.c_str());
         return ERR_DB_NOT_EXIST;
     }
-    std::vector<DeviceInfo> devices = SoftBusAdapter::GetInstance()->GetDeviceList();
+    std::vector<DeviceInfo> devices = CommunicationProvider::GetInstance().GetDeviceList();
     std::vector<std::string> deviceIds;
-    DistributedDB::KvStoreNbDelegate *kvstore = delegates_.at(sessionId);
     for (auto item : devices) {
         deviceIds.push_back(item.deviceId);
     }
@@ -342,7 +569,19 @@ uint32_t FlatObjectStorageEngine::SyncAllData(const std::string &sessionId,
         return ERR_SINGLE_DEVICE;
     }
     LOG_INFO("start sync %{public}s", sessionId.c_str());
-    DistributedDB::DBStatus status = kvstore->Sync(deviceIds, DistributedDB::SyncMode::SYNC_MODE_PULL_ONLY, onComplete);
+    PropagationTracer::GetInstance().Record(
+        PropagationTracer::GetInstance().GetLocalTrace(), PropagationTracer::SYNC, "", sessionId);
+    auto start = StoreStatistics::Clock::now();
+    auto onSynced = [start, onComplete](const std::map<std::string, DistributedDB::DBStatus> &devices) {
+        auto cost = StoreStatistics::Clock::now() - start;
+        for (auto &item : devices) {
+            StoreStatistics::GetInstance().RecordSync(item.first, cost);
+        }
+        if (onComplete) {
+            onComplete(devices);
+        }
+    };
+    DistributedDB::DBStatus status = kvstore->Sync(deviceIds, DistributedDB::SyncMode::SYNC_MODE_PULL_ONLY, onSynced);
     if (status != DistributedDB::DBStatus::OK) {
         LOG_ERROR("FlatObjectStorageEngine::UnRegisterObserver unRegister err %{public}d", status);
         return ERR_UNRIGSTER;
@@ -351,30 +590,463 @@ uint32_t FlatObjectStorageEngine::SyncAllData(const std::string &sessionId,
     return SUCCESS;
 }
 
-void Watcher::OnChange(const DistributedDB::KvStoreChangedData &data)
+// a batch is buffered whole and flushed in one transaction, it never lands half
+uint32_t FlatObjectStorageEngine::Buffer(const std::string &key, std::map<std::string, Value> &pending,
+    const std::map<std::string, Value> &batch)
+{
+    for (auto &[itemKey, value] : batch) {
+        pending.insert_or_assign(itemKey, value);
+    }
+    if (pending.size() >= WRITE_BEHIND_BATCH) {
+        return Flush(key);
+    }
+    ScheduleFlush();
+    return SUCCESS;
+}
+
+uint32_t FlatObjectStorageEngine::Flush(const std::string &key)
+{
+    auto &pending = pending_.at(key);
+    if (pending.empty()) {
+        flushErrors_.erase(key);
+        return SUCCESS;
+    }
+    std::vector<DistributedDB::Entry> entries;
+    entries.reserve(pending.size());
+    for (auto &[itemKey, value] : pending) {
+        entries.push_back({ StringUtils::StrToBytes(itemKey), value });
+    }
+    auto status = WriteInTransaction(delegates_.at(key), entries, {}, WRITE_BEHIND_BATCH);
+    if (status != DistributedDB::DBStatus::OK) {
+        // everything stays buffered for the next flush
+        LOG_ERROR("%{public}s write behind fail[%{public}d]", key.c_str(), status);
+        flushErrors_[key] = ERR_CLOSE_STORAGE;
+        return ERR_CLOSE_STORAGE;
+    }
+    pending.clear();
+    flushErrors_.erase(key);
+    PropagationTracer::GetInstance().Record(
+        PropagationTracer::GetInstance().GetLocalTrace(), PropagationTracer::COMMIT, "", key);
+    return SUCCESS;
+}
+
+uint32_t FlatObjectStorageEngine::FlushWithDeletes(const std::string &key,
+    DistributedDB::KvStoreNbDelegate *delegate, const std::map<std::string, Value> &data,
+    const std::vector<std::string> &removed)
+{
+    std::set<std::string> deleted(removed.begin(), removed.end());
+    std::vector<DistributedDB::Entry> entries;
+    auto pending = pending_.find(key);
+    if (pending != pending_.end()) {
+        for (auto &[itemKey, value] : pending->second) {
+            if (data.count(itemKey) == 0 && deleted.count(itemKey) == 0) {
+                entries.push_back({ StringUtils::StrToBytes(itemKey), value });
+            }
+        }
+    }
+    for (auto &[itemKey, value] : data) {
+        entries.push_back({ StringUtils::StrToBytes(itemKey), value });
+    }
+    std::vector<Key> keys;
+    keys.reserve(deleted.size());
+    for (auto &itemKey : deleted) {
+        keys.push_back(StringUtils::StrToBytes(itemKey));
+    }
+    auto status = WriteInTransaction(delegate, entries, keys, WRITE_BEHIND_BATCH);
+    if (status != DistributedDB::DBStatus::OK) {
+        // the buffered puts stay for the next flush, the batch is the caller's to retry
+        LOG_ERROR("%{public}s PutBatch with deletes fail[%{public}d]", key.c_str(), status);
+        return ERR_CLOSE_STORAGE;
+    }
+    if (pending != pending_.end()) {
+        pending->second.clear();
+        flushErrors_.erase(key);
+    }
+    return SUCCESS;
+}
+
+uint32_t FlatObjectStorageEngine::RetryFailedFlush(const std::string &key)
+{
+    if (flushErrors_.count(key) == 0 || Flush(key) == SUCCESS) {
+        return SUCCESS;
+    }
+    return flushErrors_.at(key);
+}
+
+void FlatObjectStorageEngine::ScheduleFlush()
+{
+    std::lock_guard<std::mutex> lock(flushMutex_);
+    if (stopFlusher_) {
+        return;
+    }
+    if (!flusher_.joinable()) {
+        flusher_ = std::thread([this]() { RunFlusher(); });
+    }
+    flushRequested_ = true;
+    flushCv_.notify_one();
+}
+
+void FlatObjectStorageEngine::RunFlusher()
+{
+    std::unique_lock<std::mutex> lock(flushMutex_);
+    while (!stopFlusher_) {
+        flushCv_.wait(lock, [this]() { return flushRequested_ || stopFlusher_; });
+        // puts coming in meanwhile go into the same batch
+        flushCv_.wait_for(lock, WRITE_BEHIND_DELAY, [this]() { return stopFlusher_; });
+        flushRequested_ = false;
+        lock.unlock();
+        FlushAll();
+        lock.lock();
+    }
+}
+
+void FlatObjectStorageEngine::StopFlusher()
+{
+    {
+        std::lock_guard<std::mutex> lock(flushMutex_);
+        stopFlusher_ = true;
+        flushCv_.notify_one();
+    }
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+}
+
+void FlatObjectStorageEngine::FlushAll()
+{
+    std::unique_lock<std::shared_mutex> lock(operationMutex_);
+    // a failure is kept in flushErrors_ for the next write of the table
+    for (auto &item : pending_) {
+        Flush(item.first);
+    }
+}
+
+std::function<void(const std::map<std::string, DistributedDB::DBStatus> &)> FlatObjectStorageEngine::PullReporter(
+    const std::string &key)
+{
+    return [key, this](const std::map<std::string, DistributedDB::DBStatus> &devices) {
+        LOG_INFO("complete");
+        for (auto item : devices) {
+            LOG_INFO("%{public}s pull data result %{public}d in device %{public}s", key.c_str(), item.second,
+                CommunicationProvider::GetInstance().ToNodeID(item.first).c_str());
+        }
+        if (statusWatcher_ != nullptr) {
+            for (auto item : devices) {
+                statusWatcher_->OnChanged(key, CommunicationProvider::GetInstance().ToNodeID(item.first),
+                    item.second == DistributedDB::OK ? "online" : "offline");
+            }
+        }
+    };
+}
+
+uint32_t FlatObjectStorageEngine::OpenDelegate(const std::string &key, Table &table)
 {
-    std::vector<std::string> changedData;
-    std::string tmp;
-    for (DistributedDB::Entry item : data.GetEntriesInserted()) {
-        tmp = StringUtils::BytesToStr(item.key);
-        LOG_INFO("inserted %{public}s", tmp.c_str());
-        // property key start with p_, 2 is p_ size
-        if (tmp.compare(0, FIELDS_PREFIX_LEN, FIELDS_PREFIX) == 0) {
-            changedData.push_back(tmp.substr(FIELDS_PREFIX_LEN));
+    const ObjectOptions &options = table.options;
+    DistributedDB::KvStoreConfig config;
+    config.dataDir = MEMORY_DATA_DIR;
+    if (options.durable) {
+        config.dataDir = options.dataDir.empty() ? DURABLE_DATA_DIR : options.dataDir;
+        if (!CreateDataDir(key, config.dataDir)) {
+            return ERR_DB_GETKV_FAIL;
         }
     }
-    for (DistributedDB::Entry item : data.GetEntriesUpdated()) {
-        tmp = StringUtils::BytesToStr(item.key);
-        LOG_INFO("updated %{public}s", tmp.c_str());
-        // property key start with p_, 2 is p_ size
-        if (tmp.compare(0, FIELDS_PREFIX_LEN, FIELDS_PREFIX) == 0) {
-            changedData.push_back(tmp.substr(FIELDS_PREFIX_LEN));
+    DistributedDB::KvStoreNbDelegate *kvStore = nullptr;
+    DistributedDB::DBStatus status = DistributedDB::DBStatus::DB_ERROR;
+    DistributedDB::KvStoreNbDelegate::Option option = { true, !options.durable,
+        false }; // createIfNecessary, isMemoryDb, isEncryptedDb
+    LOG_INFO("start create table durable:%{public}d", options.durable);
+    auto start = std::chrono::steady_clock::now();
+    storeManager_->SetKvStoreConfig(config);
+    storeManager_->GetKvStore(key, option,
+        [&status, &kvStore](DistributedDB::DBStatus dbStatus, DistributedDB::KvStoreNbDelegate *kvStoreNbDelegate) {
+            status = dbStatus;
+            kvStore = kvStoreNbDelegate;
+            LOG_INFO("create table result %{public}d", status);
+        });
+    if (status != DistributedDB::DBStatus::OK || kvStore == nullptr) {
+        LOG_ERROR("FlatObjectStorageEngine::CreateTable %{public}s getkvstore fail[%{public}d]", key.c_str(), status);
+        return ERR_DB_GETKV_FAIL;
+    }
+    // a durable store is ready with the state of the last run, the sync after it only brings the difference
+    LOG_INFO("open table %{public}s durable:%{public}d in %{public}lld us", key.c_str(), options.durable,
+        static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    bool autoSync = true;
+    DistributedDB::PragmaData data = static_cast<DistributedDB::PragmaData>(&autoSync);
+    LOG_INFO("start Pragma");
+    status = kvStore->Pragma(DistributedDB::AUTO_SYNC, data);
+    if (status != DistributedDB::DBStatus::OK) {
+        LOG_ERROR("FlatObjectStorageEngine::CreateTable %{public}s getkvstore fail[%{public}d]", key.c_str(), status);
+        storeManager_->CloseKvStore(kvStore);
+        return ERR_DB_GETKV_FAIL;
+    }
+    table.observer = std::make_shared<UsageObserver>(*this, key);
+    Key emptyKey;
+    status = kvStore->RegisterObserver(emptyKey,
+        DistributedDB::ObserverMode::OBSERVER_CHANGES_NATIVE | DistributedDB::ObserverMode::OBSERVER_CHANGES_FOREIGN,
+        table.observer.get());
+    if (status != DistributedDB::DBStatus::OK) {
+        // the table works, it is only missing from the budget
+        LOG_WARN("FlatObjectStorageEngine::CreateTable %{public}s usage not counted[%{public}d]", key.c_str(), status);
+        table.observer = nullptr;
+    }
+    std::vector<DistributedDB::Entry> entries;
+    if (options.durable) {
+        kvStore->GetEntries(emptyKey, entries);
+    }
+    SeedUsage(key, entries);
+    delegates_.insert_or_assign(key, kvStore);
+    return SUCCESS;
+}
+
+uint32_t FlatObjectStorageEngine::CloseDelegate(const std::string &key, Table &table)
+{
+    auto delegate = delegates_.find(key);
+    if (delegate == delegates_.end()) {
+        return SUCCESS;
+    }
+    if (table.observer != nullptr) {
+        delegate->second->UnRegisterObserver(table.observer.get());
+        table.observer = nullptr;
+    }
+    auto status = storeManager_->CloseKvStore(delegate->second);
+    if (status != DistributedDB::DBStatus::OK) {
+        LOG_ERROR(
+            "FlatObjectStorageEngine::CloseKvStore %{public}s CloseKvStore fail[%{public}d]", key.c_str(), status);
+        return ERR_CLOSE_STORAGE;
+    }
+    delegates_.erase(delegate);
+    return SUCCESS;
+}
+
+DistributedDB::KvStoreNbDelegate *FlatObjectStorageEngine::GetDelegate(const std::string &key)
+{
+    auto table = tables_.find(key);
+    if (table == tables_.end()) {
+        return nullptr;
+    }
+    table->second.lastUsed = std::chrono::steady_clock::now();
+    if (table->second.spilled) {
+        LOG_INFO("reload evicted table %{public}s", key.c_str());
+        if (OpenDelegate(key, table->second) != SUCCESS) {
+            return nullptr;
+        }
+        table->second.spilled = false;
+        StoreStatistics::GetInstance().OnReloaded();
+        // the peers went on writing while it was closed
+        SyncLocked(key, PullReporter(key));
+        EnforceBudget(key);
+    }
+    auto delegate = delegates_.find(key);
+    return delegate == delegates_.end() ? nullptr : delegate->second;
+}
+
+uint64_t FlatObjectStorageEngine::EnforceBudget(const std::string &current)
+{
+    uint64_t budget = memoryBudget_.load(std::memory_order_relaxed);
+    if (budget == 0) {
+        return 0;
+    }
+    uint64_t resident = 0;
+    std::map<std::string, uint64_t> sizes;
+    {
+        std::lock_guard<std::mutex> lock(usageMutex_);
+        for (auto &[key, usage] : usage_) {
+            if (usage.resident) {
+                resident += usage.bytes;
+                sizes[key] = usage.bytes;
+            }
+        }
+    }
+    if (resident <= budget) {
+        return 0;
+    }
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::pair<std::chrono::steady_clock::time_point, std::string>> idle;
+    for (auto &[key, table] : tables_) {
+        // only a durable table is on disk already, a memory table closed would lose its data
+        if (key == current || !table.options.durable || table.spilled || observerMap_.count(key) != 0
+            || now - table.lastUsed < EVICT_MIN_IDLE) {
+            continue;
+        }
+        idle.emplace_back(table.lastUsed, key);
+    }
+    // the longest idle first
+    std::sort(idle.begin(), idle.end());
+    for (auto &item : idle) {
+        if (resident <= budget) {
+            break;
+        }
+        if (Spill(item.second, tables_.at(item.second)) == SUCCESS) {
+            resident -= sizes[item.second];
+        }
+    }
+    if (resident <= budget) {
+        return 0;
+    }
+    // memory tables and tables in use have nowhere else to go, the caller learns by how much it is over
+    LOG_WARN("%{public}llu bytes resident over a budget of %{public}llu, the rest can not be evicted",
+        static_cast<unsigned long long>(resident), static_cast<unsigned long long>(budget));
+    return resident - budget;
+}
+
+uint32_t FlatObjectStorageEngine::Spill(const std::string &key, Table &table)
+{
+    // the data is on disk already, only the buffered puts have to get there
+    uint32_t result = pending_.count(key) != 0 ? Flush(key) : SUCCESS;
+    if (result == SUCCESS) {
+        result = CloseDelegate(key, table);
+    }
+    if (result != SUCCESS) {
+        LOG_ERROR("evict table %{public}s fail %{public}u", key.c_str(), result);
+        return result;
+    }
+    table.spilled = true;
+    SetResident(key, false);
+    StoreStatistics::GetInstance().OnEvicted();
+    LOG_INFO("evicted table %{public}s", key.c_str());
+    return SUCCESS;
+}
+
+uint64_t FlatObjectStorageEngine::SetMemoryBudget(uint64_t bytes)
+{
+    LOG_INFO("memory budget %{public}llu", static_cast<unsigned long long>(bytes));
+    memoryBudget_.store(bytes, std::memory_order_relaxed);
+    StoreStatistics::GetInstance().SetMemoryBudget(bytes);
+    if (!isOpened_) {
+        return 0;
+    }
+    std::unique_lock<std::shared_mutex> lock(operationMutex_);
+    return EnforceBudget("");
+}
+
+void FlatObjectStorageEngine::GetUsage(std::map<std::string, SessionStatistics> &usage)
+{
+    usage.clear();
+    std::lock_guard<std::mutex> lock(usageMutex_);
+    for (auto &[key, item] : usage_) {
+        SessionStatistics &session = usage[key];
+        session.bytes = item.bytes;
+        session.fields = item.items.size();
+        session.suppressedWrites = item.suppressed;
+        session.resident = item.resident;
+    }
+}
+
+void FlatObjectStorageEngine::SeedUsage(const std::string &key, const std::vector<DistributedDB::Entry> &entries)
+{
+    Usage usage;
+    for (auto &entry : entries) {
+        usage.Set(StringUtils::BytesToStr(entry.key), entry.value);
+    }
+    std::lock_guard<std::mutex> lock(usageMutex_);
+    auto old = usage_.find(key);
+    if (old != usage_.end()) {
+        usage.suppressed = old->second.suppressed;
+    }
+    usage_.insert_or_assign(key, std::move(usage));
+}
+
+// every record stored, restored or synced in passes here
+void FlatObjectStorageEngine::Usage::Set(const std::string &itemKey, const Value &value)
+{
+    PeerCapabilities::GetInstance().OnStored(itemKey, value);
+    uint64_t size = itemKey.size() + value.size();
+    Item &item = items[itemKey];
+    bytes = bytes - item.size + size;
+    item.size = size;
+    item.digest = ValueDigest(value);
+}
+
+// ahead of the observer, which for durable tables waits for the write behind
+void FlatObjectStorageEngine::OnWritten(const std::string &key, const std::map<std::string, Value> &data)
+{
+    std::lock_guard<std::mutex> lock(usageMutex_);
+    auto usage = usage_.find(key);
+    if (usage == usage_.end()) {
+        return;
+    }
+    for (auto &[itemKey, value] : data) {
+        usage->second.Set(itemKey, value);
+    }
+}
+
+bool FlatObjectStorageEngine::IsUnchanged(const std::string &key, DistributedDB::KvStoreNbDelegate *delegate,
+    const std::string &itemKey, const Value &value)
+{
+    {
+        std::lock_guard<std::mutex> lock(usageMutex_);
+        auto usage = usage_.find(key);
+        if (usage == usage_.end()) {
+            return false;
+        }
+        auto item = usage->second.items.find(itemKey);
+        if (item == usage->second.items.end() || item->second.size != itemKey.size() + value.size() ||
+            item->second.digest != ValueDigest(value)) {
+            return false;
+        }
+    }
+    // the digest may be behind a remote change the observer has not reported yet, or collide; only
+    // the stored bytes decide, which costs a read on a match instead of a commit and a sync
+    const Value *stored = nullptr;
+    auto pending = pending_.find(key);
+    if (pending != pending_.end()) {
+        auto item = pending->second.find(itemKey);
+        stored = item == pending->second.end() ? nullptr : &item->second;
+    }
+    Value read;
+    if (stored == nullptr && delegate->Get(StringUtils::StrToBytes(itemKey), read) == DistributedDB::DBStatus::OK) {
+        stored = &read;
+    }
+    if (stored == nullptr || *stored != value) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(usageMutex_);
+        auto usage = usage_.find(key);
+        if (usage != usage_.end()) {
+            usage->second.suppressed++;
+        }
+    }
+    StoreStatistics::GetInstance().OnWriteSuppressed();
+    LOG_DEBUG("put of %{public}s suppressed, unchanged", itemKey.c_str());
+    return true;
+}
+
+void FlatObjectStorageEngine::SetResident(const std::string &key, bool resident)
+{
+    std::lock_guard<std::mutex> lock(usageMutex_);
+    auto usage = usage_.find(key);
+    if (usage != usage_.end()) {
+        usage->second.resident = resident;
+    }
+}
+
+void FlatObjectStorageEngine::OnUsageChanged(const std::string &key, const DistributedDB::KvStoreChangedData &data)
+{
+    std::lock_guard<std::mutex> lock(usageMutex_);
+    auto usage = usage_.find(key);
+    if (usage == usage_.end()) {
+        return;
+    }
+    Usage &table = usage->second;
+    for (auto &entry : data.GetEntriesInserted()) {
+        table.Set(StringUtils::BytesToStr(entry.key), entry.value);
+    }
+    for (auto &entry : data.GetEntriesUpdated()) {
+        table.Set(StringUtils::BytesToStr(entry.key), entry.value);
+    }
+    for (auto &entry : data.GetEntriesDeleted()) {
+        auto item = table.items.find(StringUtils::BytesToStr(entry.key));
+        if (item != table.items.end()) {
+            table.bytes -= item->second.size;
+            table.items.erase(item);
         }
     }
-    this->OnChanged(sessionId_, changedData);
 }
 
-Watcher::Watcher(const std::string &sessionId) : sessionId_(sessionId)
+void FlatObjectStorageEngine::UsageObserver::OnChange(const DistributedDB::KvStoreChangedData &data)
 {
+    engine_.OnUsageChanged(key_, data);
 }
 } // namespace OHOS::ObjectStore
@@ -18,56 +18,87 @@
 #include "distributed_objectstore_impl.h"
 #include "logger.h"
 #include "objectstore_errors.h"
+#include "store_statistics.h"
 
 namespace OHOS::ObjectStore {
-FlatObjectStore::FlatObjectStore(const std::string &bundleName)
+FlatObjectStore::FlatObjectStore(const std::string &bundleName, std::shared_ptr<ObjectStorageEngine> storageEngine)
+    : storageEngine_(std::move(storageEngine))
 {
-    storageEngine_ = std::make_shared<FlatObjectStorageEngine>();
-    uint32_t status = storageEngine_->Open(bundleName);
-    if (status != SUCCESS) {
-        LOG_ERROR("FlatObjectStore: Failed to open, error: open storage engine failure %{public}d", status);
-    }
+    // the open sets up DistributedDB and the transport, the caller of GetInstance does not wait for it
+    auto start = StoreStatistics::Clock::now();
+    ready_ = std::async(std::launch::async, [engine = storageEngine_, bundleName, start]() {
+        uint32_t status = engine->Open(bundleName);
+        StoreStatistics::GetInstance().RecordInit(StoreStatistics::INIT_OPEN, StoreStatistics::Clock::now() - start);
+        if (status != SUCCESS) {
+            LOG_ERROR("FlatObjectStore: Failed to open, error: open storage engine failure %{public}d", status);
+        }
+        return status;
+    }).share();
 }
 
 FlatObjectStore::~FlatObjectStore()
 {
+    WaitReady();
     if (storageEngine_ != nullptr) {
-        storageEngine_->Close();
+        uint32_t status = storageEngine_->Close();
+        if (status != SUCCESS) {
+            LOG_ERROR("FlatObjectStore: close storage engine failure %{public}d", status);
+        }
         storageEngine_ = nullptr;
     }
 }
 
-uint32_t FlatObjectStore::CreateObject(const std::string &sessionId)
+uint32_t FlatObjectStore::WaitReady()
 {
-    if (!storageEngine_->isOpened_) {
+    if (ready_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        auto start = StoreStatistics::Clock::now();
+        ready_.wait();
+        StoreStatistics::GetInstance().RecordInit(
+            StoreStatistics::INIT_READY_WAIT, StoreStatistics::Clock::now() - start);
+    }
+    return ready_.get();
+}
+
+bool FlatObjectStore::IsReady()
+{
+    return WaitReady() == SUCCESS && storageEngine_->isOpened_;
+}
+
+uint32_t FlatObjectStore::CreateObject(const std::string &sessionId, const ObjectOptions &options)
+{
+    if (!IsReady()) {
         LOG_ERROR("FlatObjectStore::DB has not inited");
         return ERR_DB_NOT_INIT;
     }
-    uint32_t status = storageEngine_->CreateTable(sessionId);
+    StoreStatistics::Scope scope(StoreStatistics::CREATE);
+    uint32_t status = storageEngine_->CreateTable(sessionId, options);
     if (status != SUCCESS) {
         LOG_ERROR("FlatObjectStore::CreateObject createTable err %{public}d", status);
         return status;
     }
+    StoreStatistics::GetInstance().OnSessionCreated();
     return SUCCESS;
 }
 
 uint32_t FlatObjectStore::Delete(const std::string &sessionId)
 {
-    if (!storageEngine_->isOpened_) {
+    if (!IsReady()) {
         LOG_ERROR("FlatObjectStore::DB has not inited");
         return ERR_DB_NOT_INIT;
     }
+    StoreStatistics::Scope scope(StoreStatistics::DESTROY);
     uint32_t status = storageEngine_->DeleteTable(sessionId);
     if (status != SUCCESS) {
         LOG_ERROR("FlatObjectStore: Failed to delete object %{public}d", status);
         return status;
     }
+    StoreStatistics::GetInstance().OnSessionDestroyed();
     return SUCCESS;
 }
 
 uint32_t FlatObjectStore::Watch(const std::string &sessionId, std::shared_ptr<FlatObjectWatcher> watcher)
 {
-    if (!storageEngine_->isOpened_) {
+    if (!IsReady()) {
         LOG_ERROR("FlatObjectStore::DB has not inited");
         return ERR_DB_NOT_INIT;
     }
@@ -80,7 +111,7 @@ uint32_t FlatObjectStore::Watch(const std::string &sessionId, std::shared_ptr<Fl
 
 uint32_t FlatObjectStore::UnWatch(const std::string &sessionId)
 {
-    if (!storageEngine_->isOpened_) {
+    if (!IsReady()) {
         LOG_ERROR("FlatObjectStore::DB has not inited");
         return ERR_DB_NOT_INIT;
     }
@@ -91,26 +122,69 @@ uint32_t FlatObjectStore::UnWatch(const std::string &sessionId)
     return status;
 }
 
-uint32_t FlatObjectStore::Put(const std::string &sessionId, const std::string &key, std::vector<uint8_t> value)
+uint32_t FlatObjectStore::Put(const std::string &sessionId, const std::string &key, const std::vector<uint8_t> &value)
 {
-    if (!storageEngine_->isOpened_) {
+    if (!IsReady()) {
         LOG_ERROR("FlatObjectStore::DB has not inited");
         return ERR_DB_NOT_INIT;
     }
+    StoreStatistics::Scope scope(StoreStatistics::PUT);
     return storageEngine_->UpdateItem(sessionId, key, value);
 }
 
 uint32_t FlatObjectStore::Get(std::string &sessionId, const std::string &key, Bytes &value)
 {
-    if (!storageEngine_->isOpened_) {
+    if (!IsReady()) {
         LOG_ERROR("FlatObjectStore::DB has not inited");
         return ERR_DB_NOT_INIT;
     }
+    StoreStatistics::Scope scope(StoreStatistics::GET);
     return storageEngine_->GetItem(sessionId, key, value);
 }
+uint32_t FlatObjectStore::PutBatch(
+    const std::string &sessionId, const std::map<std::string, Bytes> &data, const std::vector<std::string> &removed)
+{
+    if (!IsReady()) {
+        LOG_ERROR("FlatObjectStore::DB has not inited");
+        return ERR_DB_NOT_INIT;
+    }
+    StoreStatistics::Scope scope(StoreStatistics::PUT);
+    return storageEngine_->UpdateItems(sessionId, data, removed);
+}
+
+uint32_t FlatObjectStore::GetAll(const std::string &sessionId, std::map<std::string, Bytes> &data)
+{
+    if (!IsReady()) {
+        LOG_ERROR("FlatObjectStore::DB has not inited");
+        return ERR_DB_NOT_INIT;
+    }
+    StoreStatistics::Scope scope(StoreStatistics::GET);
+    return storageEngine_->GetTable(sessionId, data);
+}
+
+uint32_t FlatObjectStore::GetAll(
+    const std::string &sessionId, const std::string &prefix, std::map<std::string, Bytes> &data)
+{
+    if (!IsReady()) {
+        LOG_ERROR("FlatObjectStore::DB has not inited");
+        return ERR_DB_NOT_INIT;
+    }
+    StoreStatistics::Scope scope(StoreStatistics::GET);
+    return storageEngine_->GetItems(sessionId, prefix, data);
+}
+
+uint32_t FlatObjectStore::DeleteBatch(const std::string &sessionId, const std::vector<std::string> &keys)
+{
+    if (!IsReady()) {
+        LOG_ERROR("FlatObjectStore::DB has not inited");
+        return ERR_DB_NOT_INIT;
+    }
+    return storageEngine_->DeleteItems(sessionId, keys);
+}
+
 uint32_t FlatObjectStore::SetStatusNotifier(std::shared_ptr<StatusWatcher> notifier)
 {
-    if (!storageEngine_->isOpened_) {
+    if (!IsReady()) {
         LOG_ERROR("FlatObjectStore::DB has not inited");
         return ERR_DB_NOT_INIT;
     }
@@ -119,10 +193,28 @@ uint32_t FlatObjectStore::SetStatusNotifier(std::shared_ptr<StatusWatcher> notif
 uint32_t FlatObjectStore::SyncAllData(const std::string &sessionId,
     const std::function<void(const std::map<std::string, DistributedDB::DBStatus> &)> &onComplete)
 {
-    if (!storageEngine_->isOpened_) {
+    if (!IsReady()) {
         LOG_ERROR("FlatObjectStore::DB has not inited");
         return ERR_DB_NOT_INIT;
     }
     return storageEngine_->SyncAllData(sessionId, onComplete);
 }
+
+uint64_t FlatObjectStore::SetMemoryBudget(uint64_t bytes)
+{
+    if (!IsReady()) {
+        LOG_ERROR("FlatObjectStore::DB has not inited");
+        return 0;
+    }
+    return storageEngine_->SetMemoryBudget(bytes);
+}
+
+void FlatObjectStore::GetUsage(std::map<std::string, SessionStatistics> &usage)
+{
+    if (ready_.wait_for(std::chrono::seconds(0)) != std::future_status::ready || !IsReady()) {
+        usage.clear();
+        return;
+    }
+    storageEngine_->GetUsage(usage);
+}
 } // namespace OHOS::ObjectStore
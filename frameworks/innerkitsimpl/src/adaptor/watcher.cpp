@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watcher.h"
+
+#include "propagation_tracer.h"
+#include "store_statistics.h"
+#include "string_utils.h"
+
+namespace OHOS::ObjectStore {
+void Watcher::OnChange(const DistributedDB::KvStoreChangedData &data)
+{
+    StoreStatistics::GetInstance().OnNotificationBegin();
+    std::vector<std::string> changedData;
+    std::string tmp;
+    for (DistributedDB::Entry item : data.GetEntriesInserted()) {
+        tmp = StringUtils::BytesToStr(item.key);
+        LOG_INFO("inserted %{public}s", tmp.c_str());
+        // property key start with p_, 2 is p_ size
+        if (tmp.compare(0, FIELDS_PREFIX_LEN, FIELDS_PREFIX) == 0) {
+            changedData.push_back(tmp.substr(FIELDS_PREFIX_LEN));
+        }
+    }
+    for (DistributedDB::Entry item : data.GetEntriesUpdated()) {
+        tmp = StringUtils::BytesToStr(item.key);
+        LOG_INFO("updated %{public}s", tmp.c_str());
+        // property key start with p_, 2 is p_ size
+        if (tmp.compare(0, FIELDS_PREFIX_LEN, FIELDS_PREFIX) == 0) {
+            changedData.push_back(tmp.substr(FIELDS_PREFIX_LEN));
+        }
+    }
+    PropagationTracer &tracer = PropagationTracer::GetInstance();
+    uint64_t traceId = tracer.IsEnabled() ? tracer.GetRemoteTrace() : 0;
+    if (traceId != 0) {
+        tracer.Record(traceId, PropagationTracer::CHANGE, "", sessionId_ + " " + std::to_string(changedData.size()));
+    }
+    PropagationTracer::SetCurrentTrace(traceId);
+    this->OnChanged(sessionId_, changedData);
+    PropagationTracer::SetCurrentTrace(0);
+    StoreStatistics::GetInstance().OnNotificationEnd();
+}
+
+Watcher::Watcher(const std::string &sessionId) : sessionId_(sessionId)
+{
+}
+} // namespace OHOS::ObjectStore
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "content_chunker.h"
+
+#include <algorithm>
+
+namespace OHOS::ObjectStore {
+namespace {
+constexpr uint64_t GEAR_SEED = 0x6F626A6563747374;
+constexpr int HASH_BITS = 64;
+// normalized chunking: cuts are harder to hit before the average size and easier after it
+constexpr int SMALL_MASK_BITS = 15;
+constexpr int LARGE_MASK_BITS = 11;
+// the gear hash moves one bit per byte, its top bits depend on the last 64 bytes
+constexpr uint64_t MASK_SMALL = ((1ULL << SMALL_MASK_BITS) - 1) << (HASH_BITS - SMALL_MASK_BITS);
+constexpr uint64_t MASK_LARGE = ((1ULL << LARGE_MASK_BITS) - 1) << (HASH_BITS - LARGE_MASK_BITS);
+
+constexpr size_t SHA256_BLOCK = 64;
+constexpr size_t SHA256_WORDS = 64;
+constexpr uint32_t SHA256_K[SHA256_WORDS] = { 0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+    0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc,
+    0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1,
+    0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
+    0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814,
+    0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2 };
+
+struct GearTable {
+    uint64_t values[256];
+    GearTable()
+    {
+        // splitmix64, fixed so that every device cuts at the same points
+        uint64_t state = GEAR_SEED;
+        for (auto &value : values) {
+            state += 0x9E3779B97F4A7C15ULL;
+            uint64_t mixed = state;
+            mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+            value = mixed ^ (mixed >> 31);
+        }
+    }
+};
+
+const GearTable &Gear()
+{
+    static const GearTable table;
+    return table;
+}
+
+inline uint32_t Rotr(uint32_t value, int bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+void Sha256Block(uint32_t state[8], const uint8_t *block)
+{
+    uint32_t w[SHA256_WORDS];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (static_cast<uint32_t>(block[4 * i]) << 24) | (static_cast<uint32_t>(block[4 * i + 1]) << 16) |
+            (static_cast<uint32_t>(block[4 * i + 2]) << 8) | static_cast<uint32_t>(block[4 * i + 3]);
+    }
+    for (size_t i = 16; i < SHA256_WORDS; i++) {
+        uint32_t s0 = Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (size_t i = 0; i < SHA256_WORDS; i++) {
+        uint32_t t1 = h + (Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+        uint32_t t2 = (Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+} // namespace
+
+size_t ContentChunker::NextCut(const uint8_t *data, size_t size)
+{
+    if (size <= MIN_SIZE) {
+        return size;
+    }
+    const uint64_t *gear = Gear().values;
+    size_t end = std::min(size, MAX_SIZE);
+    size_t normal = std::min(end, AVERAGE_SIZE);
+    uint64_t hash = 0;
+    size_t i = MIN_SIZE;
+    for (; i < normal; i++) {
+        hash = (hash << 1) + gear[data[i]];
+        if ((hash & MASK_SMALL) == 0) {
+            return i + 1;
+        }
+    }
+    for (; i < end; i++) {
+        hash = (hash << 1) + gear[data[i]];
+        if ((hash & MASK_LARGE) == 0) {
+            return i + 1;
+        }
+    }
+    return end;
+}
+
+std::vector<size_t> ContentChunker::Split(const uint8_t *data, size_t size)
+{
+    std::vector<size_t> chunks;
+    chunks.reserve(size / AVERAGE_SIZE + 1);
+    size_t offset = 0;
+    while (offset < size) {
+        size_t length = NextCut(data + offset, size - offset);
+        chunks.push_back(length);
+        offset += length;
+    }
+    return chunks;
+}
+
+ContentChunker::Digest ContentChunker::Hash(const uint8_t *data, size_t size)
+{
+    uint32_t state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab,
+        0x5be0cd19 };
+    size_t full = size - size % SHA256_BLOCK;
+    for (size_t offset = 0; offset < full; offset += SHA256_BLOCK) {
+        Sha256Block(state, data + offset);
+    }
+    // the rest, the 0x80 end mark and the length in bits fill one or two more blocks
+    uint8_t tail[2 * SHA256_BLOCK] = { 0 };
+    size_t rest = size - full;
+    std::copy(data + full, data + size, tail);
+    tail[rest] = 0x80;
+    size_t tailSize = rest + 1 + sizeof(uint64_t) <= SHA256_BLOCK ? SHA256_BLOCK : 2 * SHA256_BLOCK;
+    uint64_t bits = static_cast<uint64_t>(size) * 8;
+    for (size_t i = 0; i < sizeof(bits); i++) {
+        tail[tailSize - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+    for (size_t offset = 0; offset < tailSize; offset += SHA256_BLOCK) {
+        Sha256Block(state, tail + offset);
+    }
+    Digest digest;
+    for (size_t i = 0; i < DIGEST_SIZE; i++) {
+        digest[i] = static_cast<uint8_t>(state[i / 4] >> (24 - 8 * (i % 4)));
+    }
+    return digest;
+}
+
+std::string ContentChunker::ToHex(const Digest &digest)
+{
+    static constexpr char HEX[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(2 * DIGEST_SIZE);
+    for (uint8_t byte : digest) {
+        hex += HEX[byte >> 4];
+        hex += HEX[byte & 0x0F];
+    }
+    return hex;
+}
+} // namespace OHOS::ObjectStore
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "peer_capabilities.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "bytes.h"
+#include "distributed_object.h"
+#include "logger.h"
+
+namespace OHOS::ObjectStore {
+namespace {
+constexpr int BITS_PER_BYTE = 8;
+// JSSerializer::MAGIC and VERSION in front of a binary complex value
+constexpr uint8_t SERIALIZER_MAGIC = 0xC5;
+constexpr uint8_t SERIALIZER_VERSION = 1;
+// the node of an array or object stored path by path, as the JS layer writes it
+const std::string ARRAY_NODE = "[ARRAY]";
+const std::string OBJECT_NODE = "[OBJECT]";
+
+bool StartsWith(const std::vector<uint8_t> &value, size_t offset, const std::string &prefix)
+{
+    return value.size() >= offset + prefix.size() && std::equal(prefix.begin(), prefix.end(), value.begin() + offset);
+}
+
+void PutUint32(std::vector<uint8_t> &out, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= BITS_PER_BYTE) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+uint32_t GetUint32(const uint8_t *data)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < sizeof(value); i++) {
+        value = (value << BITS_PER_BYTE) | data[i];
+    }
+    return value;
+}
+} // namespace
+
+PeerCapabilities &PeerCapabilities::GetInstance()
+{
+    static PeerCapabilities instance;
+    return instance;
+}
+
+void PeerCapabilities::OnOnline(const std::string &deviceId)
+{
+    if (deviceId.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    peers_.emplace(deviceId, Peer());
+}
+
+void PeerCapabilities::OnOffline(const std::string &deviceId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // the device may come back with another release
+    peers_.erase(deviceId);
+}
+
+bool PeerCapabilities::OnHello(const std::string &deviceId, uint32_t capabilities)
+{
+    if (deviceId.empty()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &peer = peers_[deviceId];
+    if (peer.capabilities != capabilities) {
+        LOG_INFO("peer capabilities 0x%{public}x -> 0x%{public}x", peer.capabilities, capabilities);
+    }
+    peer.capabilities = capabilities;
+    uint32_t stored = stored_.load(std::memory_order_relaxed);
+    if (!peer.refused || (capabilities & stored) != stored) {
+        return false;
+    }
+    peer.refused = false;
+    return true;
+}
+
+bool PeerCapabilities::TakeHelloTurn(const std::string &deviceId)
+{
+    if (deviceId.empty()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &peer = peers_[deviceId];
+    if (peer.helloSent) {
+        return false;
+    }
+    peer.helloSent = true;
+    return true;
+}
+
+void PeerCapabilities::OnHelloFailed(const std::string &deviceId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(deviceId);
+    if (it != peers_.end()) {
+        it->second.helloSent = false;
+    }
+}
+
+bool PeerCapabilities::Has(const std::string &deviceId, uint32_t capabilities) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(deviceId);
+    return it != peers_.end() && (it->second.capabilities & capabilities) == capabilities;
+}
+
+uint32_t PeerCapabilities::GetCommon() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (peers_.empty()) {
+        return 0;
+    }
+    uint32_t common = LOCAL;
+    for (auto &item : peers_) {
+        common &= item.second.capabilities;
+    }
+    return common;
+}
+
+void PeerCapabilities::OnStored(const std::string &itemKey, const std::vector<uint8_t> &value)
+{
+    uint32_t formats = FormatsOf(itemKey, value);
+    if (formats == 0 || (stored_.load(std::memory_order_relaxed) & formats) == formats) {
+        return;
+    }
+    uint32_t before = stored_.fetch_or(formats);
+    if ((before | formats) != before) {
+        LOG_INFO("stored formats 0x%{public}x -> 0x%{public}x", before, before | formats);
+    }
+}
+
+uint32_t PeerCapabilities::GetStored() const
+{
+    return stored_.load(std::memory_order_relaxed);
+}
+
+bool PeerCapabilities::CanSync(const std::string &deviceId)
+{
+    uint32_t stored = stored_.load(std::memory_order_relaxed);
+    if (stored == 0) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &peer = peers_[deviceId];
+    if ((peer.capabilities & stored) == stored) {
+        return true;
+    }
+    if (!peer.refused) {
+        LOG_WARN("no sync with a peer of capabilities 0x%{public}x, stored formats 0x%{public}x", peer.capabilities,
+            stored);
+        peer.refused = true;
+    }
+    return false;
+}
+
+uint32_t PeerCapabilities::FormatsOf(const std::string &itemKey, const std::vector<uint8_t> &value)
+{
+    // a chunk only exists with the manifest of a chunked value
+    if (itemKey.compare(0, std::strlen(CHUNKS_PREFIX), CHUNKS_PREFIX) == 0) {
+        return CHUNKED_VALUES;
+    }
+    if (value.empty()) {
+        return 0;
+    }
+    if (value[0] == TYPE_STRING && (StartsWith(value, sizeof(Type), ARRAY_NODE)
+        || StartsWith(value, sizeof(Type), OBJECT_NODE))) {
+        return PATH_FIELDS;
+    }
+    if (value[0] == TYPE_COMPLEX && value.size() > sizeof(Type) + 1 && value[sizeof(Type)] == SERIALIZER_MAGIC
+        && value[sizeof(Type) + 1] == SERIALIZER_VERSION) {
+        return BINARY_COMPLEX;
+    }
+    return 0;
+}
+
+std::vector<uint8_t> PeerCapabilities::EncodeHello(uint32_t flags)
+{
+    std::vector<uint8_t> frame;
+    frame.reserve(HELLO_SIZE);
+    PutUint32(frame, HELLO_MAGIC);
+    PutUint32(frame, HELLO_SIZE);
+    PutUint32(frame, LOCAL);
+    PutUint32(frame, flags);
+    return frame;
+}
+
+bool PeerCapabilities::DecodeHello(const uint8_t *data, uint32_t size, uint32_t &capabilities, uint32_t &flags)
+{
+    if (data == nullptr || size != HELLO_SIZE || GetUint32(data) != HELLO_MAGIC
+        || GetUint32(data + sizeof(uint32_t)) != HELLO_SIZE) {
+        return false;
+    }
+    capabilities = GetUint32(data + 2 * sizeof(uint32_t));
+    flags = GetUint32(data + 3 * sizeof(uint32_t));
+    return true;
+}
+} // namespace OHOS::ObjectStore
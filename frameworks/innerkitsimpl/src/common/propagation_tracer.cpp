@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "propagation_tracer.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+
+#include "logger.h"
+
+namespace OHOS::ObjectStore {
+namespace {
+constexpr const char *STAGE_NAMES[PropagationTracer::STAGE_COUNT] = { "put", "commit", "sync", "send", "receive",
+    "change", "deliver" };
+constexpr int ID_BASE_SHIFT = 32;
+constexpr uint32_t PID_MASK = 0x7FFFFFFF;
+thread_local uint64_t t_currentTrace = 0;
+
+void AppendEscaped(std::string &out, const std::string &text)
+{
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+}
+} // namespace
+
+PropagationTracer &PropagationTracer::GetInstance()
+{
+    static PropagationTracer instance;
+    return instance;
+}
+
+PropagationTracer::PropagationTracer()
+    : idBase_(static_cast<uint64_t>(std::random_device()()) << ID_BASE_SHIFT)
+{
+    const char *enable = getenv(ENABLE_ENV);
+    if (enable != nullptr && strcmp(enable, "1") == 0) {
+        LOG_INFO("propagation trace on by %{public}s", ENABLE_ENV);
+        enabled_.store(true);
+    }
+}
+
+int64_t PropagationTracer::Now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void PropagationTracer::SetEnabled(bool enabled)
+{
+    enabled_.store(enabled);
+    if (!enabled) {
+        // stale ids must not tag the frames of a later session
+        localTrace_.store(0);
+        remoteTrace_.store(0);
+    }
+}
+
+uint64_t PropagationTracer::Begin(const std::string &sessionId, const std::string &key)
+{
+    if (!IsEnabled()) {
+        return 0;
+    }
+    // ids of different devices differ in the random high half
+    uint64_t traceId = idBase_ | (nextId_.fetch_add(1, std::memory_order_relaxed) & UINT32_MAX);
+    localTrace_.store(traceId, std::memory_order_relaxed);
+    Record(traceId, PUT, "", sessionId + "/" + key);
+    return traceId;
+}
+
+void PropagationTracer::Record(uint64_t traceId, Stage stage, const std::string &device, const std::string &detail)
+{
+    if (traceId == 0 || !IsEnabled()) {
+        return;
+    }
+    Event event;
+    event.traceId = traceId;
+    event.stage = stage;
+    event.time = Now();
+    event.device = device;
+    event.detail = detail;
+    Append(std::move(event));
+}
+
+uint64_t PropagationTracer::GetLocalTrace() const
+{
+    return localTrace_.load(std::memory_order_relaxed);
+}
+
+uint64_t PropagationTracer::GetRemoteTrace() const
+{
+    return remoteTrace_.load(std::memory_order_relaxed);
+}
+
+bool PropagationTracer::Wrap(const std::string &deviceId, const uint8_t *data, uint32_t size,
+    std::vector<uint8_t> &frame)
+{
+    uint64_t traceId = IsEnabled() ? GetLocalTrace() : 0;
+    if (traceId == 0) {
+        return false;
+    }
+    FrameHeader header = { FRAME_MAGIC, HEADER_SIZE, traceId, Now() };
+    frame.resize(HEADER_SIZE + size);
+    memcpy(frame.data(), &header, HEADER_SIZE);
+    memcpy(frame.data() + HEADER_SIZE, data, size);
+    Event event;
+    event.traceId = traceId;
+    event.stage = SEND;
+    event.time = header.sendTime;
+    event.device = deviceId;
+    event.detail = std::to_string(size);
+    Append(std::move(event));
+    return true;
+}
+
+void PropagationTracer::Unwrap(const std::string &deviceId, const uint8_t *&data, uint32_t &size)
+{
+    FrameHeader header;
+    if (data == nullptr || size < HEADER_SIZE) {
+        return;
+    }
+    memcpy(&header, data, HEADER_SIZE);
+    if (header.magic != FRAME_MAGIC || header.size != HEADER_SIZE) {
+        return;
+    }
+    data += HEADER_SIZE;
+    size -= HEADER_SIZE;
+    if (!IsEnabled() || header.traceId == 0) {
+        return;
+    }
+    remoteTrace_.store(header.traceId, std::memory_order_relaxed);
+    Event event;
+    event.traceId = header.traceId;
+    event.stage = RECEIVE;
+    event.time = Now();
+    event.peerTime = header.sendTime;
+    event.device = deviceId;
+    event.detail = std::to_string(size);
+    Append(std::move(event));
+}
+
+uint64_t PropagationTracer::GetCurrentTrace()
+{
+    return t_currentTrace;
+}
+
+void PropagationTracer::SetCurrentTrace(uint64_t traceId)
+{
+    t_currentTrace = traceId;
+}
+
+void PropagationTracer::Append(Event &&event)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (events_.size() < CAPACITY) {
+        events_.push_back(std::move(event));
+        return;
+    }
+    events_[next_] = std::move(event);
+    next_ = (next_ + 1) % CAPACITY;
+}
+
+void PropagationTracer::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.clear();
+    next_ = 0;
+}
+
+std::string PropagationTracer::Export(const std::string &localDevice) const
+{
+    uint32_t pid = static_cast<uint32_t>(std::hash<std::string>()(localDevice)) & PID_MASK;
+    std::string out = "{\"traceEvents\":[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + std::to_string(pid)
+                      + ",\"tid\":0,\"args\":{\"name\":\"";
+    AppendEscaped(out, localDevice);
+    out += "\"}}";
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < events_.size(); i++) {
+        // oldest first
+        const Event &event = events_[(next_ + i) % events_.size()];
+        char head[160];
+        // one track per stage, the trace id ties the stages of a write together
+        snprintf(head, sizeof(head),
+            ",{\"name\":\"%s\",\"cat\":\"objectstore\",\"ph\":\"i\",\"s\":\"p\",\"ts\":%" PRId64
+            ",\"pid\":%u,\"tid\":%u,\"args\":{\"trace\":\"%016" PRIx64 "\"",
+            STAGE_NAMES[event.stage], event.time, pid, static_cast<uint32_t>(event.stage), event.traceId);
+        out += head;
+        if (event.stage == RECEIVE) {
+            out += ",\"sendTime\":" + std::to_string(event.peerTime);
+        }
+        out += ",\"device\":\"";
+        AppendEscaped(out, event.device);
+        out += "\",\"detail\":\"";
+        AppendEscaped(out, event.detail);
+        out += "\"}}";
+    }
+    out += "]}";
+    return out;
+}
+} // namespace OHOS::ObjectStore
@@ -69,5 +69,10 @@ std::string AppDeviceHandler::GetUdidByNodeId(const std::string &nodeId) const
 {
     return softbusAdapter_->GetUdidByNodeId(nodeId);
 }
+
+std::string AppDeviceHandler::ToNodeID(const std::string &deviceId) const
+{
+    return softbusAdapter_->ToNodeID(deviceId);
+}
 } // namespace ObjectStore
 } // namespace OHOS
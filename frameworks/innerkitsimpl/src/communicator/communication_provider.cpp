@@ -15,12 +15,36 @@
 
 #include "communication_provider.h"
 
+#include <atomic>
+
 #include "ark_communication_provider.h"
+#ifdef OBJECTSTORE_UDS_TRANSPORT
+#include "uds_communication_provider.h"
+#endif
 
 namespace OHOS {
 namespace ObjectStore {
+namespace {
+std::atomic<CommunicationProvider *> g_instance { nullptr };
+} // namespace
+
+void CommunicationProvider::SetInstance(CommunicationProvider *provider)
+{
+    g_instance.store(provider);
+}
+
 CommunicationProvider &CommunicationProvider::GetInstance()
 {
+    CommunicationProvider *instance = g_instance.load();
+    if (instance != nullptr) {
+        return *instance;
+    }
+#ifdef OBJECTSTORE_UDS_TRANSPORT
+    CommunicationProvider *uds = UdsCommunicationProvider::Init();
+    if (uds != nullptr) {
+        return *uds;
+    }
+#endif
     return ArkCommunicationProvider::Init();
 }
 } // namespace ObjectStore
@@ -88,5 +88,10 @@ bool CommunicationProviderImpl::IsSameStartedOnPeer(const PipeInfo &pipeInfo, co
 {
     return appPipeMgr_.IsSameStartedOnPeer(pipeInfo, peer);
 }
+
+std::string CommunicationProviderImpl::ToNodeID(const std::string &deviceId) const
+{
+    return appDeviceHandler_.ToNodeID(deviceId);
+}
 } // namespace ObjectStore
 } // namespace OHOS
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "link_profile.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "logger.h"
+
+namespace OHOS {
+namespace ObjectStore {
+namespace {
+constexpr double SMOOTH_FACTOR = 0.125;             // weight of the newest sample, same as TCP srtt
+constexpr double FRAME_TIME_BUDGET_SECONDS = 1.0;  // a single frame should not occupy the link longer
+constexpr uint32_t MTU_GROW_STEPS = 16;
+constexpr uint32_t TYPE_WATCH_ID = 0x6D;
+constexpr const char *SMART_WATCH_TYPE = "SMART_WATCH";
+constexpr const char *CHILDREN_WATCH_TYPE = "CHILDREN_WATCH";
+
+double Smooth(double average, double sample, bool first)
+{
+    return first ? sample : average + SMOOTH_FACTOR * (sample - average);
+}
+} // namespace
+
+LinkProfileManager &LinkProfileManager::GetInstance()
+{
+    static LinkProfileManager instance;
+    return instance;
+}
+
+bool LinkProfileManager::IsWatch(const std::string &deviceType)
+{
+    // softbus reports the numeric device type id, older callers used the type name
+    return deviceType == std::to_string(TYPE_WATCH_ID) || deviceType == SMART_WATCH_TYPE
+           || deviceType == CHILDREN_WATCH_TYPE;
+}
+
+LinkProfile LinkProfileManager::NewProfile(const DeviceInfo &info)
+{
+    LinkProfile profile;
+    profile.deviceType = info.deviceType;
+    profile.baseMtu = IsWatch(info.deviceType) ? MTU_SIZE_WATCH : MTU_SIZE;
+    profile.mtu = profile.baseMtu;
+    return profile;
+}
+
+void LinkProfileManager::OnDeviceOnline(const DeviceInfo &info)
+{
+    if (info.deviceId.empty()) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    profiles_[info.deviceId] = NewProfile(info);
+    LOG_DEBUG("link profile of type %{public}s, mtu:%{public}u", info.deviceType.c_str(),
+        profiles_[info.deviceId].mtu);
+}
+
+void LinkProfileManager::OnDeviceFound(const DeviceInfo &info)
+{
+    if (info.deviceId.empty()) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = profiles_.find(info.deviceId);
+    if (it == profiles_.end()) {
+        profiles_.emplace(info.deviceId, NewProfile(info));
+    } else if (it->second.deviceType.empty() && !info.deviceType.empty()) {
+        it->second.deviceType = info.deviceType;
+        it->second.baseMtu = IsWatch(info.deviceType) ? MTU_SIZE_WATCH : MTU_SIZE;
+        it->second.mtu = std::min(it->second.mtu, it->second.baseMtu);
+    }
+}
+
+void LinkProfileManager::OnDeviceOffline(const std::string &deviceId)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    profiles_.erase(deviceId);
+}
+
+void LinkProfileManager::OnSessionOpened(const std::string &deviceId, std::chrono::microseconds rtt)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = profiles_.find(deviceId);
+    if (it == profiles_.end()) {
+        return;
+    }
+    it->second.rttUs = Smooth(it->second.rttUs, static_cast<double>(rtt.count()), it->second.rttUs == 0);
+}
+
+void LinkProfileManager::OnSendComplete(
+    const std::string &deviceId, uint32_t bytes, std::chrono::microseconds cost, bool success)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = profiles_.find(deviceId);
+    if (it == profiles_.end()) {
+        return;
+    }
+    auto &profile = it->second;
+    bool first = profile.sendCount == 0;
+    profile.sendCount++;
+    profile.lossRate = Smooth(profile.lossRate, success ? 0.0 : 1.0, first);
+    if (!success) {
+        profile.failCount++;
+    } else if (bytes >= THROUGHPUT_SAMPLE_MIN && cost.count() > 0) {
+        double sample = bytes * 1e6 / cost.count();
+        profile.throughput = Smooth(profile.throughput, sample, profile.throughput == 0);
+    }
+    AdjustMtu(profile, bytes, success);
+}
+
+void LinkProfileManager::OnLinkFailed(const std::string &deviceId)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = profiles_.find(deviceId);
+    if (it == profiles_.end()) {
+        return;
+    }
+    auto &profile = it->second;
+    bool first = profile.sendCount == 0;
+    profile.sendCount++;
+    profile.failCount++;
+    profile.lossRate = Smooth(profile.lossRate, 1.0, first);
+}
+
+void LinkProfileManager::AdjustMtu(LinkProfile &profile, uint32_t bytes, bool success)
+{
+    uint32_t floor = profile.baseMtu / MTU_FLOOR_DIVISOR;
+    uint32_t mtu = profile.mtu;
+    if (!success) {
+        // a big frame that failed is the first suspect, halve like a congestion window,
+        // a frame already at the floor failed for another reason
+        if (bytes > floor) {
+            mtu = std::max(floor, std::min(mtu, bytes) / 2);
+        }
+    } else if (mtu < profile.baseMtu) {
+        mtu = std::min(profile.baseMtu, mtu + profile.baseMtu / MTU_GROW_STEPS);
+    }
+    if (profile.throughput > 0) {
+        double budget = profile.throughput * FRAME_TIME_BUDGET_SECONDS;
+        if (budget < mtu) {
+            mtu = std::max(floor, static_cast<uint32_t>(budget));
+        }
+    }
+    if (mtu != profile.mtu) {
+        LOG_DEBUG("mtu %{public}u -> %{public}u, loss:%{public}f", profile.mtu, mtu, profile.lossRate);
+        profile.mtu = mtu;
+    }
+}
+
+bool LinkProfileManager::GetMtuSize(const std::string &deviceId, uint32_t &mtu) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = profiles_.find(deviceId);
+    if (it == profiles_.end()) {
+        return false;
+    }
+    mtu = it->second.mtu;
+    return true;
+}
+
+bool LinkProfileManager::GetProfile(const std::string &deviceId, LinkProfile &profile) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = profiles_.find(deviceId);
+    if (it == profiles_.end()) {
+        return false;
+    }
+    profile = it->second;
+    return true;
+}
+} // namespace ObjectStore
+} // namespace OHOS
@@ -17,6 +17,11 @@
 
 #include <logger.h>
 
+#include "link_profile.h"
+#include "peer_capabilities.h"
+#include "propagation_tracer.h"
+#include "store_statistics.h"
+
 namespace OHOS {
 namespace ObjectStore {
 using namespace DistributedDB;
@@ -107,32 +112,68 @@ DBStatus ProcessCommunicatorImpl::SendData(const DeviceInfos &dstDevInfo, const
     PipeInfo pi = { thisProcessLabel_ };
     DeviceId destination;
     destination.deviceId = dstDevInfo.identifier;
+    auto &capabilities = PeerCapabilities::GetInstance();
+    if (capabilities.TakeHelloTurn(dstDevInfo.identifier)) {
+        SendHello(dstDevInfo.identifier, PeerCapabilities::REPLY_REQUESTED);
+    }
+    // the peer would store what it can not read, its hello reports it online again once it can
+    if (!capabilities.CanSync(dstDevInfo.identifier)) {
+        return DBStatus::DB_ERROR;
+    }
+    std::vector<uint8_t> frame;
+    // an older peer would hand the header to DistributedDB as part of the frame
+    if (capabilities.Has(dstDevInfo.identifier, PeerCapabilities::TRACE_HEADER)
+        && PropagationTracer::GetInstance().Wrap(dstDevInfo.identifier, data, length, frame)) {
+        data = frame.data();
+        length = static_cast<uint32_t>(frame.size());
+    }
+    // returns once the frame is queued, a frame lost later fails the next send to the device
     Status errCode = CommunicationProvider::GetInstance().SendData(pi, destination, data, static_cast<int>(length));
     if (errCode != Status::SUCCESS) {
         LOG_ERROR("commProvider_ SendData Fail.");
+        // the lost frame may have been the hello
+        capabilities.OnHelloFailed(dstDevInfo.identifier);
         return DBStatus::DB_ERROR;
     }
-
+    StoreStatistics::GetInstance().OnSent(dstDevInfo.identifier, length);
     return DBStatus::OK;
 }
 
+void ProcessCommunicatorImpl::SendHello(const std::string &deviceId, uint32_t flags) const
+{
+    PipeInfo pi = { thisProcessLabel_ };
+    DeviceId destination = { deviceId };
+    std::vector<uint8_t> hello = PeerCapabilities::EncodeHello(flags);
+    Status errCode =
+        CommunicationProvider::GetInstance().SendData(pi, destination, hello.data(), static_cast<int>(hello.size()));
+    if (errCode != Status::SUCCESS) {
+        LOG_WARN("send hello failed %{public}d", errCode);
+        PeerCapabilities::GetInstance().OnHelloFailed(deviceId);
+    }
+}
+
+// the trace header is left room in every frame, so turning tracing on never pushes one over the link mtu
 uint32_t ProcessCommunicatorImpl::GetMtuSize()
 {
-    return MTU_SIZE;
+    return MTU_SIZE - PropagationTracer::HEADER_SIZE;
 }
 
 uint32_t ProcessCommunicatorImpl::GetMtuSize(const DeviceInfos &devInfo)
 {
-    LOG_INFO("GetMtuSize start");
-    std::vector<DeviceInfo> devInfos = CommunicationProvider::GetInstance().GetDeviceList();
-    for (auto const &entry : devInfos) {
-        LOG_INFO("GetMtuSize deviceType: %{public}s", entry.deviceType.c_str());
-        bool isWatch = (entry.deviceType == SMART_WATCH_TYPE || entry.deviceType == CHILDREN_WATCH_TYPE);
-        if (entry.deviceId == devInfo.identifier && isWatch) {
-            return MTU_SIZE_WATCH;
-        }
+    uint32_t mtu = MTU_SIZE;
+    if (LinkProfileManager::GetInstance().GetMtuSize(devInfo.identifier, mtu)) {
+        return mtu - PropagationTracer::HEADER_SIZE;
     }
-    return MTU_SIZE;
+    // first frame to an unknown peer, the device list seeds every profile at once
+    LOG_INFO("GetMtuSize seed link profiles");
+    for (auto const &entry : CommunicationProvider::GetInstance().GetDeviceList()) {
+        LinkProfileManager::GetInstance().OnDeviceFound(entry);
+    }
+    if (!LinkProfileManager::GetInstance().GetMtuSize(devInfo.identifier, mtu)) {
+        LinkProfileManager::GetInstance().OnDeviceFound({ devInfo.identifier, "", "" });
+        mtu = MTU_SIZE;
+    }
+    return mtu - PropagationTracer::HEADER_SIZE;
 }
 
 DeviceInfos ProcessCommunicatorImpl::GetLocalDeviceInfos()
@@ -148,6 +189,7 @@ std::vector<DeviceInfos> ProcessCommunicatorImpl::GetRemoteOnlineDeviceInfosList
     std::vector<DeviceInfos> remoteDevInfos;
     std::vector<DeviceInfo> devInfoVec = CommunicationProvider::GetInstance().GetDeviceList();
     for (auto const &entry : devInfoVec) {
+        PeerCapabilities::GetInstance().OnOnline(entry.deviceId);
         DeviceInfos remoteDev;
         remoteDev.identifier = entry.deviceId;
         remoteDevInfos.push_back(remoteDev);
@@ -165,18 +207,49 @@ bool ProcessCommunicatorImpl::IsSameProcessLabelStartedOnPeerDevice(const Device
 void ProcessCommunicatorImpl::OnMessage(
     const DeviceInfo &info, const uint8_t *ptr, const int size, __attribute__((unused)) const PipeInfo &pipeInfo) const
 {
-    std::lock_guard<std::mutex> onDataReceiveLockGuard(onDataReceiveMutex_);
-    if (onDataReceiveHandler_ == nullptr) {
+    uint32_t capabilities = 0;
+    uint32_t flags = 0;
+    if (PeerCapabilities::DecodeHello(ptr, static_cast<uint32_t>(size), capabilities, flags)) {
+        // ours, DistributedDB never sees it
+        bool admitted = PeerCapabilities::GetInstance().OnHello(info.deviceId, capabilities);
+        PeerCapabilities::GetInstance().TakeHelloTurn(info.deviceId);
+        if ((flags & PeerCapabilities::REPLY_REQUESTED) != 0) {
+            SendHello(info.deviceId, 0);
+        }
+        if (admitted) {
+            // the syncs that failed on the dropped frames start over
+            OnDeviceChanged(info, DeviceChangeType::DEVICE_ONLINE);
+        }
+        return;
+    }
+    if (!PeerCapabilities::GetInstance().CanSync(info.deviceId)) {
+        return;
+    }
+    OnDataReceive handler;
+    {
+        std::lock_guard<std::mutex> onDataReceiveLockGuard(onDataReceiveMutex_);
+        handler = onDataReceiveHandler_;
+    }
+    if (handler == nullptr) {
         LOG_ERROR("onDataReceiveHandler_ invalid.");
         return;
     }
+    const uint8_t *data = ptr;
+    uint32_t length = static_cast<uint32_t>(size);
+    PropagationTracer::GetInstance().Unwrap(info.deviceId, data, length);
+    StoreStatistics::GetInstance().OnReceived(info.deviceId, static_cast<uint64_t>(length));
     DeviceInfos devInfo;
     devInfo.identifier = info.deviceId;
-    onDataReceiveHandler_(devInfo, ptr, static_cast<uint32_t>(size));
+    handler(devInfo, data, length);
 }
 
 void ProcessCommunicatorImpl::OnDeviceChanged(const DeviceInfo &info, const DeviceChangeType &type) const
 {
+    if (type == DeviceChangeType::DEVICE_ONLINE) {
+        PeerCapabilities::GetInstance().OnOnline(info.deviceId);
+    } else {
+        PeerCapabilities::GetInstance().OnOffline(info.deviceId);
+    }
     std::lock_guard<std::mutex> onDeviceChangeLockGuard(onDeviceChangeMutex_);
     if (onDeviceChangeHandler_ == nullptr) {
         LOG_ERROR("onDeviceChangeHandler_ invalid.");
@@ -15,15 +15,18 @@
 
 #include <logger.h>
 
+#include <algorithm>
 #include <mutex>
 #include <thread>
 
 #include "kv_store_delegate_manager.h"
+#include "link_profile.h"
 #include "process_communicator_impl.h"
 #include "securec.h"
 #include "session.h"
 #include "softbus_adapter.h"
 #include "softbus_bus_center.h"
+#include "store_statistics.h"
 
 namespace OHOS {
 namespace ObjectStore {
@@ -35,6 +38,7 @@ constexpr const char *DEFAULT_ANONYMOUS = "******";
 constexpr int32_t SOFTBUS_OK = 0;
 constexpr int32_t SOFTBUS_ERR = 1;
 constexpr int32_t INVALID_SESSION_ID = -1;
+constexpr int32_t SESSION_OPEN_TIMEOUT = -2;
 constexpr int32_t SESSION_NAME_SIZE_MAX = 65;
 constexpr int32_t DEVICE_ID_SIZE_MAX = 65;
 constexpr int32_t ID_BUF_LEN = 65;
@@ -131,6 +135,23 @@ SoftBusAdapter::SoftBusAdapter()
 SoftBusAdapter::~SoftBusAdapter()
 {
     LOG_INFO("begin");
+    {
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        eventStopped_ = true;
+        eventCv_.notify_all();
+    }
+    if (eventDispatcher_.joinable()) {
+        eventDispatcher_.join();
+    }
+    // the callbacks of the sends still queued run while the members they touch are alive
+    std::map<std::string, std::shared_ptr<TaskQueue>> sendQueues;
+    {
+        std::lock_guard<std::mutex> lock(sendQueueMutex_);
+        sendQueues.swap(sendQueues_);
+    }
+    for (auto &item : sendQueues) {
+        item.second->Stop();
+    }
     int32_t errNo = UnregNodeDeviceStateCb(&nodeStateCb_);
     if (errNo != SOFTBUS_OK) {
         LOG_ERROR("UnregNodeDeviceStateCb fail %{public}d", errNo);
@@ -140,7 +161,8 @@ SoftBusAdapter::~SoftBusAdapter()
 void SoftBusAdapter::Init()
 {
     LOG_INFO("begin");
-    std::thread th = std::thread([&]() {
+    auto start = StoreStatistics::Clock::now();
+    std::thread th = std::thread([&, start]() {
         int i = 0;
         constexpr int RETRY_TIMES = 300;
         while (i++ < RETRY_TIMES) {
@@ -151,6 +173,8 @@ void SoftBusAdapter::Init()
                 continue;
             }
             LOG_INFO("RegNodeDeviceStateCb success");
+            StoreStatistics::GetInstance().RecordInit(
+                StoreStatistics::INIT_NODE_REGISTER, StoreStatistics::Clock::now() - start);
             return;
         }
         LOG_ERROR("Init failed %{public}d times and exit now.", RETRY_TIMES);
@@ -195,51 +219,126 @@ Status SoftBusAdapter::StopWatchDeviceChange(
 
 void SoftBusAdapter::NotifyAll(const DeviceInfo &deviceInfo, const DeviceChangeType &type)
 {
-    std::thread th = std::thread([this, deviceInfo, type]() {
-        std::vector<const AppDeviceStatusChangeListener *> listeners;
-        {
-            std::lock_guard<std::mutex> lock(deviceChangeMutex_);
-            for (const auto &listener : listeners_) {
-                listeners.push_back(listener);
-            }
+    std::lock_guard<std::mutex> lock(eventMutex_);
+    if (eventStopped_) {
+        return;
+    }
+    if (!eventDispatcher_.joinable()) {
+        eventDispatcher_ = std::thread([this]() { DispatchDeviceEvents(); });
+    }
+    auto now = std::chrono::steady_clock::now();
+    auto it = pendingEvents_.find(deviceInfo.deviceId);
+    if (it != pendingEvents_.end()) {
+        // keep the place of the burst in the queue so the device order is preserved
+        if (it->second.type != type) {
+            it->second.due = now + DEVICE_EVENT_WINDOW;
         }
-        LOG_DEBUG("high");
-        std::string udid = GetUdidByNodeId(deviceInfo.deviceId);
-        LOG_DEBUG("[Notify] to DB from: %{public}s, type:%{public}d", ToBeAnonymous(udid).c_str(), type);
-        UpdateRelationship(deviceInfo.deviceId, type);
-        for (const auto &device : listeners) {
-            if (device == nullptr) {
-                continue;
+        it->second.deviceInfo = deviceInfo;
+        it->second.type = type;
+        it->second.merged++;
+        eventCv_.notify_one();
+        return;
+    }
+    pendingEvents_.emplace(deviceInfo.deviceId, DeviceEvent{ deviceInfo, type, now, now, 0 });
+    eventOrder_.push_back(deviceInfo.deviceId);
+    eventCv_.notify_one();
+}
+
+void SoftBusAdapter::DispatchDeviceEvents()
+{
+    while (true) {
+        DeviceEvent event;
+        {
+            std::unique_lock<std::mutex> lock(eventMutex_);
+            auto ready = eventOrder_.end();
+            while (!eventStopped_) {
+                // a flapping device is held without holding back the devices queued behind it
+                auto now = std::chrono::steady_clock::now();
+                auto next = std::chrono::steady_clock::time_point::max();
+                ready = std::find_if(eventOrder_.begin(), eventOrder_.end(), [this, now, &next](const auto &id) {
+                    next = std::min(next, pendingEvents_[id].due);
+                    return next <= now;
+                });
+                if (ready != eventOrder_.end()) {
+                    break;
+                }
+                if (next == std::chrono::steady_clock::time_point::max()) {
+                    eventCv_.wait(lock);
+                } else {
+                    eventCv_.wait_until(lock, next);
+                }
             }
-            if (device->GetChangeLevelType() == ChangeLevelType::HIGH) {
-                DeviceInfo di = { udid, deviceInfo.deviceName, deviceInfo.deviceType };
-                device->OnDeviceChanged(di, type);
-                break;
+            if (eventStopped_) {
+                return;
             }
+            std::string networkId = *ready;
+            eventOrder_.erase(ready);
+            event = std::move(pendingEvents_[networkId]);
+            pendingEvents_.erase(networkId);
         }
-        LOG_DEBUG("low");
-        for (const auto &device : listeners) {
-            if (device == nullptr) {
-                continue;
-            }
-            if (device->GetChangeLevelType() == ChangeLevelType::LOW) {
-                DeviceInfo di = { udid, deviceInfo.deviceName, deviceInfo.deviceType };
-                device->OnDeviceChanged(di, DeviceChangeType::DEVICE_OFFLINE);
+        DeliverDeviceEvent(event);
+    }
+}
+
+void SoftBusAdapter::DeliverDeviceEvent(const DeviceEvent &event)
+{
+    const DeviceInfo &deviceInfo = event.deviceInfo;
+    DeviceChangeType type = event.type;
+    auto last = deliveredStates_.find(deviceInfo.deviceId);
+    if (type == DeviceChangeType::DEVICE_OFFLINE && last != deliveredStates_.end() && last->second == type) {
+        LOG_DEBUG("drop offline burst of %{public}u merged events", event.merged + 1);
+        return;
+    }
+    deliveredStates_[deviceInfo.deviceId] = type;
+
+    std::vector<const AppDeviceStatusChangeListener *> listeners;
+    {
+        std::lock_guard<std::mutex> lock(deviceChangeMutex_);
+        listeners.assign(listeners_.begin(), listeners_.end());
+    }
+    std::stable_sort(listeners.begin(), listeners.end(), [](const auto *left, const auto *right) {
+        return static_cast<int>(left->GetChangeLevelType()) < static_cast<int>(right->GetChangeLevelType());
+    });
+    std::string udid = GetUdidByNodeId(deviceInfo.deviceId);
+    LOG_DEBUG("[Notify] to DB from: %{public}s, type:%{public}d, merged:%{public}u", ToBeAnonymous(udid).c_str(),
+        type, event.merged);
+    UpdateRelationship(deviceInfo.deviceId, type);
+    if (type == DeviceChangeType::DEVICE_ONLINE) {
+        LinkProfileManager::GetInstance().OnDeviceOnline({ udid, deviceInfo.deviceName, deviceInfo.deviceType });
+    } else {
+        LinkProfileManager::GetInstance().OnDeviceOffline(udid);
+        DropSendQueue(udid);
+    }
+    DeviceInfo di = { udid, deviceInfo.deviceName, deviceInfo.deviceType };
+    bool highNotified = false;
+    for (const auto &device : listeners) {
+        switch (device->GetChangeLevelType()) {
+            case ChangeLevelType::HIGH:
+                // only the first high level listener is notified
+                if (!highNotified) {
+                    highNotified = true;
+                    device->OnDeviceChanged(di, type);
+                }
+                break;
+            case ChangeLevelType::LOW:
+                // low level listeners rebuild their links, so an online is always preceded by an offline
+                if (type == DeviceChangeType::DEVICE_ONLINE) {
+                    device->OnDeviceChanged(di, DeviceChangeType::DEVICE_OFFLINE);
+                }
                 device->OnDeviceChanged(di, type);
-            }
-        }
-        LOG_DEBUG("min");
-        for (const auto &device : listeners) {
-            if (device == nullptr) {
-                continue;
-            }
-            if (device->GetChangeLevelType() == ChangeLevelType::MIN) {
-                DeviceInfo di = { udid, deviceInfo.deviceName, deviceInfo.deviceType };
+                break;
+            default:
                 device->OnDeviceChanged(di, type);
-            }
+                break;
         }
-    });
-    th.detach();
+    }
+    auto latency = std::chrono::steady_clock::now() - event.since;
+    eventLatency_.Record(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+}
+
+HistogramSnapshot SoftBusAdapter::GetDeviceEventLatency() const
+{
+    return eventLatency_.Snapshot();
 }
 
 std::vector<DeviceInfo> SoftBusAdapter::GetDeviceList() const
@@ -259,6 +358,7 @@ std::vector<DeviceInfo> SoftBusAdapter::GetDeviceList() const
     for (int i = 0; i < infoNum; i++) {
         std::string udid = GetUdidByNodeId(std::string(info[i].networkId));
         DeviceInfo deviceInfo = { udid, std::string(info[i].deviceName), std::to_string(info[i].deviceTypeId) };
+        LinkProfileManager::GetInstance().OnDeviceFound(deviceInfo);
         dis.push_back(deviceInfo);
     }
     if (info != nullptr) {
@@ -429,13 +529,14 @@ Status SoftBusAdapter::StartWatchDataChange(const AppDataChangeListener *observe
         return Status::INVALID_ARGUMENT;
     }
     lock_guard<mutex> lock(dataChangeMutex_);
-    auto it = dataChangeListeners_.find(pipeInfo.pipeId);
-    if (it != dataChangeListeners_.end()) {
+    if (dataChangeListeners_->find(pipeInfo.pipeId) != dataChangeListeners_->end()) {
         LOG_WARN("Add listener error or repeated adding.");
         return Status::ERROR;
     }
     LOG_DEBUG("current appid %{public}s", pipeInfo.pipeId.c_str());
-    dataChangeListeners_.insert({ pipeInfo.pipeId, observer });
+    auto listeners = std::make_shared<DataListeners>(*dataChangeListeners_);
+    listeners->insert({ pipeInfo.pipeId, { observer, std::make_shared<TaskQueue>() } });
+    std::atomic_store(&dataChangeListeners_, std::shared_ptr<const DataListeners>(std::move(listeners)));
     return Status::SUCCESS;
 }
 
@@ -443,19 +544,89 @@ Status SoftBusAdapter::StopWatchDataChange(
     __attribute__((unused)) const AppDataChangeListener *observer, const PipeInfo &pipeInfo)
 {
     LOG_DEBUG("begin");
-    lock_guard<mutex> lock(dataChangeMutex_);
-    if (dataChangeListeners_.erase(pipeInfo.pipeId)) {
-        return Status::SUCCESS;
+    std::shared_ptr<TaskQueue> queue;
+    {
+        lock_guard<mutex> lock(dataChangeMutex_);
+        auto it = dataChangeListeners_->find(pipeInfo.pipeId);
+        if (it == dataChangeListeners_->end()) {
+            LOG_WARN("stop data observer error, pipeInfo:%{public}s", pipeInfo.pipeId.c_str());
+            return Status::ERROR;
+        }
+        queue = it->second.queue;
+        auto listeners = std::make_shared<DataListeners>(*dataChangeListeners_);
+        listeners->erase(pipeInfo.pipeId);
+        std::atomic_store(&dataChangeListeners_, std::shared_ptr<const DataListeners>(std::move(listeners)));
     }
-    LOG_WARN("stop data observer error, pipeInfo:%{public}s", pipeInfo.pipeId.c_str());
-    return Status::ERROR;
+    // the observer may be released once we return, so wait for a message that is being delivered to it
+    queue->Stop();
+    return Status::SUCCESS;
+}
+
+std::shared_ptr<const SoftBusAdapter::DataListeners> SoftBusAdapter::GetDataListeners() const
+{
+    return std::atomic_load(&dataChangeListeners_);
 }
 
 Status SoftBusAdapter::SendData(
     const PipeInfo &pipeInfo, const DeviceId &deviceId, const uint8_t *ptr, int size, const MessageInfo &info)
 {
+    // the sender learns of a lost frame with its next one, and retries or gives up on the device as it would
+    // for a frame that failed at once
+    Status status = TakeSendError(deviceId.deviceId);
+    if (status == Status::SUCCESS) {
+        status = SendDataAsync(pipeInfo, deviceId, std::vector<uint8_t>(ptr, ptr + size), info,
+            [this, device = deviceId.deviceId](Status sent) {
+                if (sent != Status::SUCCESS) {
+                    OnSendFailed(device, sent);
+                }
+            });
+    }
+    if (status != Status::SUCCESS) {
+        LOG_ERROR("[SendData] to %{public}s, session:%{public}s failed, status:%{public}d",
+            ToBeAnonymous(deviceId.deviceId).c_str(), pipeInfo.pipeId.c_str(), status);
+    }
+    return status;
+}
+
+Status SoftBusAdapter::SendDataAsync(const PipeInfo &pipeInfo, const DeviceId &deviceId, std::vector<uint8_t> data,
+    const MessageInfo &info, const SendCallback &callback, std::chrono::milliseconds timeout)
+{
+    auto queue = GetSendQueue(deviceId.deviceId);
+    size_t depth = queue->Size();
+    sendQueueDepth_.Record(depth);
+    if (depth >= MAX_SEND_QUEUE_DEPTH) {
+        LOG_ERROR("send queue of %{public}s is full, depth:%{public}zu", ToBeAnonymous(deviceId.deviceId).c_str(),
+            depth);
+        return Status::ERROR;
+    }
+    auto enqueueTime = std::chrono::steady_clock::now();
+    auto deadline = enqueueTime + timeout;
+    bool posted = queue->Post([this, pipeInfo, deviceId, data = std::move(data), info, callback, enqueueTime,
+                                  deadline]() {
+        Status status = DoSend(pipeInfo, deviceId, data, info, deadline);
+        auto waited = std::chrono::steady_clock::now() - enqueueTime;
+        sendWaitTime_.Record(std::chrono::duration_cast<std::chrono::microseconds>(waited).count());
+        if (callback) {
+            callback(status);
+        }
+    }, [callback]() {
+        if (callback) {
+            callback(Status::TIME_OUT);
+        }
+    });
+    return posted ? Status::SUCCESS : Status::ILLEGAL_STATE;
+}
+
+Status SoftBusAdapter::DoSend(const PipeInfo &pipeInfo, const DeviceId &deviceId, const std::vector<uint8_t> &data,
+    const MessageInfo &info, std::chrono::steady_clock::time_point deadline)
+{
+    if (std::chrono::steady_clock::now() >= deadline) {
+        LOG_WARN("[SendData] to %{public}s expired in queue", ToBeAnonymous(deviceId.deviceId).c_str());
+        return Status::TIME_OUT;
+    }
     SessionAttribute attr;
     attr.dataType = TYPE_BYTES;
+    int size = static_cast<int>(data.size());
     LOG_DEBUG("[SendData] to %{public}s ,session:%{public}s, size:%{public}d",
         ToBeAnonymous(deviceId.deviceId).c_str(), pipeInfo.pipeId.c_str(), size);
     int sessionId = OpenSession(
@@ -463,19 +634,44 @@ Status SoftBusAdapter::SendData(
     if (sessionId < 0) {
         LOG_WARN("OpenSession %{public}s, type:%{public}d failed, sessionId:%{public}d", pipeInfo.pipeId.c_str(),
             info.msgType, sessionId);
+        LinkProfileManager::GetInstance().OnLinkFailed(deviceId.deviceId);
         return Status::CREATE_SESSION_ERROR;
     }
-    int state = GetSessionStatus(sessionId);
+    bool reused = false;
+    {
+        lock_guard<mutex> lock(statusMutex_);
+        reused = sessionsStatus_.find(sessionId) != sessionsStatus_.end();
+    }
+    auto openTime = std::chrono::steady_clock::now();
+    auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - openTime);
+    int state = GetSessionStatus(sessionId, std::max(remain, std::chrono::milliseconds(0)));
+    auto sendTime = std::chrono::steady_clock::now();
+    StoreStatistics::GetInstance().Record(StoreStatistics::SESSION_OPEN, sendTime - openTime);
+    if (!reused && state == SOFTBUS_OK) {
+        LinkProfileManager::GetInstance().OnSessionOpened(
+            deviceId.deviceId, std::chrono::duration_cast<std::chrono::microseconds>(sendTime - openTime));
+    }
     LOG_DEBUG("Waited for notification, state:%{public}d", state);
+    if (state == SESSION_OPEN_TIMEOUT) {
+        LOG_ERROR("OpenSession %{public}d not answered in time, close it", sessionId);
+        CloseSession(sessionId);
+        OnSessionClose(sessionId);
+        LinkProfileManager::GetInstance().OnLinkFailed(deviceId.deviceId);
+        return Status::TIME_OUT;
+    }
     if (state != SOFTBUS_OK) {
         LOG_ERROR("OpenSession callback result error");
+        LinkProfileManager::GetInstance().OnLinkFailed(deviceId.deviceId);
         return Status::CREATE_SESSION_ERROR;
     }
     int key = sessionId;
     LOG_DEBUG("[SendBytes] start,sessionId is %{public}d, size is %{public}d, "
               "session type is %{public}d.",
         key, size, attr.dataType);
-    int32_t ret = SendBytes(sessionId, (void *)ptr, size);
+    int32_t ret = SendBytes(sessionId, data.data(), size);
+    auto cost = std::chrono::steady_clock::now() - sendTime;
+    LinkProfileManager::GetInstance().OnSendComplete(deviceId.deviceId, size,
+        std::chrono::duration_cast<std::chrono::microseconds>(cost), ret == SOFTBUS_OK);
     if (ret != SOFTBUS_OK) {
         LOG_ERROR("[SendBytes] to %{public}d failed, ret:%{public}d.", sessionId, ret);
         return Status::ERROR;
@@ -483,10 +679,70 @@ Status SoftBusAdapter::SendData(
     return Status::SUCCESS;
 }
 
-int32_t SoftBusAdapter::GetSessionStatus(int32_t sessionId)
+std::shared_ptr<TaskQueue> SoftBusAdapter::GetSendQueue(const std::string &deviceId)
+{
+    lock_guard<mutex> lock(sendQueueMutex_);
+    auto &queue = sendQueues_[deviceId];
+    if (queue == nullptr) {
+        queue = std::make_shared<TaskQueue>();
+    }
+    return queue;
+}
+
+void SoftBusAdapter::DropSendQueue(const std::string &deviceId)
+{
+    std::shared_ptr<TaskQueue> queue;
+    {
+        lock_guard<mutex> lock(sendQueueMutex_);
+        auto it = sendQueues_.find(deviceId);
+        if (it == sendQueues_.end()) {
+            return;
+        }
+        queue = std::move(it->second);
+        sendQueues_.erase(it);
+        sendErrors_.erase(deviceId);
+    }
+    // the sends already queued still owe their callbacks, so the queue drains them and then releases itself
+    // from its own worker, the last task holds the last reference
+    queue->Post([queue]() {});
+}
+
+void SoftBusAdapter::OnSendFailed(const std::string &deviceId, Status status)
+{
+    LOG_ERROR("[SendData] to %{public}s failed, status:%{public}d", ToBeAnonymous(deviceId).c_str(), status);
+    lock_guard<mutex> lock(sendQueueMutex_);
+    // a dropped device starts without errors when it comes back
+    if (sendQueues_.count(deviceId) != 0) {
+        sendErrors_[deviceId] = status;
+    }
+}
+
+Status SoftBusAdapter::TakeSendError(const std::string &deviceId)
+{
+    lock_guard<mutex> lock(sendQueueMutex_);
+    auto it = sendErrors_.find(deviceId);
+    if (it == sendErrors_.end()) {
+        return Status::SUCCESS;
+    }
+    Status status = it->second;
+    sendErrors_.erase(it);
+    return status;
+}
+
+HistogramSnapshot SoftBusAdapter::GetSendQueueDepth() const
+{
+    return sendQueueDepth_.Snapshot();
+}
+
+HistogramSnapshot SoftBusAdapter::GetSendWaitTime() const
+{
+    return sendWaitTime_.Snapshot();
+}
+
+int32_t SoftBusAdapter::GetSessionStatus(int32_t sessionId, std::chrono::milliseconds timeout)
 {
     auto semaphore = GetSemaphore(sessionId);
-    return semaphore->GetValue();
+    return semaphore->GetValue(timeout, SESSION_OPEN_TIMEOUT);
 }
 
 void SoftBusAdapter::OnSessionOpen(int32_t sessionId, int32_t status)
@@ -575,16 +831,39 @@ void SoftBusAdapter::NotifyDataListeners(
     const uint8_t *ptr, const int size, const std::string &deviceId, const PipeInfo &pipeInfo)
 {
     LOG_DEBUG("begin");
-    lock_guard<mutex> lock(dataChangeMutex_);
-    auto it = dataChangeListeners_.find(pipeInfo.pipeId);
-    if (it != dataChangeListeners_.end()) {
-        LOG_DEBUG("ready to notify, pipeName:%{public}s, deviceId:%{public}s.", pipeInfo.pipeId.c_str(),
-            ToBeAnonymous(deviceId).c_str());
-        DeviceInfo deviceInfo = { deviceId, "", "" };
-        it->second->OnMessage(deviceInfo, ptr, size, pipeInfo);
+    auto listeners = GetDataListeners();
+    auto it = listeners->find(pipeInfo.pipeId);
+    if (it == listeners->end()) {
+        LOG_WARN("no listener %{public}s.", pipeInfo.pipeId.c_str());
+        return;
+    }
+    LOG_DEBUG("ready to notify, pipeName:%{public}s, deviceId:%{public}s.", pipeInfo.pipeId.c_str(),
+        ToBeAnonymous(deviceId).c_str());
+    // softbus only lends the buffer for the duration of this callback
+    std::vector<uint8_t> data(ptr, ptr + size);
+    const AppDataChangeListener *observer = it->second.observer;
+    size_t length = data.size();
+    bool posted = it->second.queue->Post([this, pipeId = pipeInfo.pipeId, observer, deviceId, data = std::move(data)]() {
+        DispatchData(pipeId, observer, deviceId, data);
+    }, [pipeId = pipeInfo.pipeId, length]() {
+        LOG_WARN("listener of %{public}s stopped, drop message of %{public}zu bytes.", pipeId.c_str(), length);
+    });
+    if (!posted) {
+        LOG_WARN("pipe %{public}s is stopping, drop message.", pipeInfo.pipeId.c_str());
+    }
+}
+
+void SoftBusAdapter::DispatchData(const std::string &pipeId, const AppDataChangeListener *observer,
+    const std::string &deviceId, const std::vector<uint8_t> &data) const
+{
+    auto listeners = GetDataListeners();
+    auto it = listeners->find(pipeId);
+    if (it == listeners->end() || it->second.observer != observer) {
+        LOG_WARN("listener of %{public}s changed, drop message.", pipeId.c_str());
         return;
     }
-    LOG_WARN("no listener %{public}s.", pipeInfo.pipeId.c_str());
+    DeviceInfo deviceInfo = { deviceId, "", "" };
+    observer->OnMessage(deviceInfo, data.data(), static_cast<int>(data.size()), { pipeId });
 }
 
 void AppDataListenerWrap::SetDataHandler(SoftBusAdapter *handler)
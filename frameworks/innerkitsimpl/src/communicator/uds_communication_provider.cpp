@@ -0,0 +1,607 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "uds_communication_provider.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <vector>
+
+#include "logger.h"
+#include "securec.h"
+
+namespace OHOS {
+namespace ObjectStore {
+namespace {
+constexpr uint32_t FRAME_MAGIC = 0x4F425553;
+constexpr uint32_t MAX_FRAME_SIZE = 5 * 1024 * 1024; // same limit as AppPipeMgr
+constexpr uint32_t MAX_SENDER_SIZE = 256;
+constexpr int LISTEN_BACKLOG = 16;
+constexpr int RECEIVE_TIMEOUT_SECONDS = 1;
+constexpr int SEND_TIMEOUT_SECONDS = 5; // same as SoftBusAdapter::SEND_TIMEOUT
+constexpr char SEPARATOR = '@';
+constexpr std::chrono::milliseconds DISCOVERY_INTERVAL = std::chrono::milliseconds(200);
+
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t senderSize;
+    uint32_t dataSize;
+};
+
+bool ReadFully(int fd, void *buf, size_t len)
+{
+    auto *pos = static_cast<uint8_t *>(buf);
+    while (len > 0) {
+        ssize_t ret = recv(fd, pos, len, 0);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return false;
+        }
+        pos += ret;
+        len -= static_cast<size_t>(ret);
+    }
+    return true;
+}
+
+bool WriteFully(int fd, struct iovec *iov, int count)
+{
+    while (count > 0) {
+        struct msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<size_t>(count);
+        ssize_t ret = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret < 0) {
+            return false;
+        }
+        auto sent = static_cast<size_t>(ret);
+        while (count > 0 && sent >= iov->iov_len) {
+            sent -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<uint8_t *>(iov->iov_base) + sent;
+            iov->iov_len -= sent;
+        }
+    }
+    return true;
+}
+
+bool ToAddress(const std::string &path, struct sockaddr_un &addr)
+{
+    addr = {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        LOG_ERROR("socket path too long %{public}s", path.c_str());
+        return false;
+    }
+    return strcpy_s(addr.sun_path, sizeof(addr.sun_path), path.c_str()) == EOK;
+}
+
+int Connect(const std::string &path)
+{
+    struct sockaddr_un addr;
+    if (!ToAddress(path, addr)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    // a peer that stops reading must not block the sender forever
+    struct timeval timeout = { SEND_TIMEOUT_SECONDS, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+bool GetPeerCredential(int fd, struct ucred &cred)
+{
+    socklen_t len = sizeof(cred);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && len == sizeof(cred);
+}
+
+// the sockets carry objects of the user, nobody else may create or replace one
+bool IsPrivateDir(const char *dir)
+{
+    struct stat st;
+    if (lstat(dir, &st) != 0) {
+        LOG_ERROR("stat socket dir %{public}s failed %{public}d", dir, errno);
+        return false;
+    }
+    if (!S_ISDIR(st.st_mode) || st.st_uid != getuid() || (st.st_mode & (S_IRWXG | S_IRWXO)) != 0) {
+        LOG_ERROR("socket dir %{public}s must be a directory of uid %{public}u with mode 0700, uid:%{public}u, "
+                  "mode:%{public}o",
+            dir, getuid(), st.st_uid, st.st_mode & ALLPERMS);
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+UdsCommunicationProvider::Connection::~Connection()
+{
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+CommunicationProvider *UdsCommunicationProvider::Init()
+{
+    static std::unique_ptr<UdsCommunicationProvider> instance = []() -> std::unique_ptr<UdsCommunicationProvider> {
+        const char *dir = getenv(SOCKET_DIR_ENV);
+        if (dir == nullptr || *dir == '\0') {
+            return nullptr;
+        }
+        const char *id = getenv(DEVICE_ID_ENV);
+        std::string deviceId = (id != nullptr && *id != '\0') ? id : "uds_" + std::to_string(getpid());
+        if (mkdir(dir, S_IRWXU) != 0 && errno != EEXIST) {
+            LOG_ERROR("create socket dir %{public}s failed %{public}d", dir, errno);
+            return nullptr;
+        }
+        if (!IsPrivateDir(dir)) {
+            return nullptr;
+        }
+        LOG_INFO("uds transport in %{public}s as %{public}s", dir, deviceId.c_str());
+        return std::unique_ptr<UdsCommunicationProvider>(new UdsCommunicationProvider(dir, deviceId));
+    }();
+    return instance.get();
+}
+
+UdsCommunicationProvider::UdsCommunicationProvider(const std::string &socketDir, const std::string &deviceId)
+    : socketDir_(socketDir), localDeviceId_(deviceId)
+{
+    discovery_ = std::thread([this]() { DiscoveryLoop(); });
+}
+
+UdsCommunicationProvider::~UdsCommunicationProvider()
+{
+    {
+        std::lock_guard<std::mutex> lock(discoveryMutex_);
+        stopped_ = true;
+        discoveryCv_.notify_all();
+    }
+    if (discovery_.joinable()) {
+        discovery_.join();
+    }
+    std::vector<std::string> pipeIds;
+    {
+        std::lock_guard<std::mutex> lock(pipeMutex_);
+        for (auto &item : pipes_) {
+            pipeIds.push_back(item.first);
+        }
+    }
+    for (auto &pipeId : pipeIds) {
+        Stop({ pipeId });
+    }
+}
+
+std::string UdsCommunicationProvider::SocketPath(const std::string &deviceId, const std::string &pipeId) const
+{
+    return socketDir_ + "/" + deviceId + SEPARATOR + pipeId;
+}
+
+Status UdsCommunicationProvider::StartWatchDeviceChange(
+    const AppDeviceStatusChangeListener *observer, __attribute__((unused)) const PipeInfo &pipeInfo)
+{
+    if (observer == nullptr) {
+        return Status::INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lock(deviceChangeMutex_);
+    return deviceListeners_.insert(observer).second ? Status::SUCCESS : Status::ERROR;
+}
+
+Status UdsCommunicationProvider::StopWatchDeviceChange(
+    const AppDeviceStatusChangeListener *observer, __attribute__((unused)) const PipeInfo &pipeInfo)
+{
+    std::lock_guard<std::mutex> lock(deviceChangeMutex_);
+    return deviceListeners_.erase(observer) > 0 ? Status::SUCCESS : Status::ERROR;
+}
+
+std::shared_ptr<UdsCommunicationProvider::ListenerSlot> UdsCommunicationProvider::GetListenerSlot(
+    const std::string &pipeId)
+{
+    std::lock_guard<std::mutex> lock(listenerMutex_);
+    auto &slot = dataListeners_[pipeId];
+    if (slot == nullptr) {
+        slot = std::make_shared<ListenerSlot>();
+    }
+    return slot;
+}
+
+Status UdsCommunicationProvider::StartWatchDataChange(
+    const AppDataChangeListener *observer, const PipeInfo &pipeInfo)
+{
+    if (observer == nullptr) {
+        return Status::INVALID_ARGUMENT;
+    }
+    auto slot = GetListenerSlot(pipeInfo.pipeId);
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    if (slot->observer != nullptr) {
+        LOG_WARN("repeated adding %{public}s.", pipeInfo.pipeId.c_str());
+        return Status::ERROR;
+    }
+    slot->observer = observer;
+    return Status::SUCCESS;
+}
+
+Status UdsCommunicationProvider::StopWatchDataChange(
+    __attribute__((unused)) const AppDataChangeListener *observer, const PipeInfo &pipeInfo)
+{
+    auto slot = GetListenerSlot(pipeInfo.pipeId);
+    // waits for a message being delivered on this pipe
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    if (slot->observer == nullptr) {
+        return Status::ERROR;
+    }
+    slot->observer = nullptr;
+    return Status::SUCCESS;
+}
+
+Status UdsCommunicationProvider::Start(const PipeInfo &pipeInfo)
+{
+    if (pipeInfo.pipeId.empty() || pipeInfo.pipeId.find('/') != std::string::npos) {
+        return Status::INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lock(pipeMutex_);
+    if (pipes_.count(pipeInfo.pipeId) != 0) {
+        return Status::REPEATED_REGISTER;
+    }
+    std::string path = SocketPath(localDeviceId_, pipeInfo.pipeId);
+    struct sockaddr_un addr;
+    if (!ToAddress(path, addr)) {
+        return Status::INVALID_ARGUMENT;
+    }
+    auto pipe = std::make_shared<Pipe>();
+    pipe->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (pipe->listenFd < 0 || pipe2(pipe->wakeFd, O_CLOEXEC) != 0) {
+        LOG_ERROR("create socket failed %{public}d", errno);
+        close(pipe->listenFd);
+        return Status::ILLEGAL_STATE;
+    }
+    unlink(path.c_str());
+    if (bind(pipe->listenFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0
+        || listen(pipe->listenFd, LISTEN_BACKLOG) != 0) {
+        LOG_ERROR("listen on %{public}s failed %{public}d", path.c_str(), errno);
+        close(pipe->listenFd);
+        close(pipe->wakeFd[0]);
+        close(pipe->wakeFd[1]);
+        return Status::ILLEGAL_STATE;
+    }
+    pipe->worker = std::thread([this, pipeId = pipeInfo.pipeId, pipe]() { ReceiveLoop(pipeId, pipe); });
+    pipes_.emplace(pipeInfo.pipeId, pipe);
+    LOG_INFO("pipe %{public}s listening", pipeInfo.pipeId.c_str());
+    return Status::SUCCESS;
+}
+
+Status UdsCommunicationProvider::Stop(const PipeInfo &pipeInfo)
+{
+    std::shared_ptr<Pipe> pipe;
+    {
+        std::lock_guard<std::mutex> lock(pipeMutex_);
+        auto it = pipes_.find(pipeInfo.pipeId);
+        if (it == pipes_.end()) {
+            return Status::KEY_NOT_FOUND;
+        }
+        pipe = it->second;
+        pipes_.erase(it);
+    }
+    unlink(SocketPath(localDeviceId_, pipeInfo.pipeId).c_str());
+    uint8_t wake = 0;
+    while (write(pipe->wakeFd[1], &wake, sizeof(wake)) < 0 && errno == EINTR) {
+    }
+    if (pipe->worker.joinable()) {
+        pipe->worker.join();
+    }
+    close(pipe->listenFd);
+    close(pipe->wakeFd[0]);
+    close(pipe->wakeFd[1]);
+    return Status::SUCCESS;
+}
+
+void UdsCommunicationProvider::ReceiveLoop(const std::string &pipeId, std::shared_ptr<Pipe> pipe)
+{
+    // slot 0 wakes the loop up for Stop, slot 1 accepts peers, the rest are peer connections
+    std::vector<struct pollfd> fds = { { pipe->wakeFd[0], POLLIN, 0 }, { pipe->listenFd, POLLIN, 0 } };
+    std::map<int, Peer> peers;
+    while (true) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("poll %{public}s failed %{public}d", pipeId.c_str(), errno);
+            break;
+        }
+        if (fds[0].revents != 0) {
+            break;
+        }
+        for (size_t i = fds.size() - 1; i >= 2; i--) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            if ((fds[i].revents & POLLIN) == 0 || !ReceiveFrame(fds[i].fd, pipeId, peers[fds[i].fd])) {
+                peers.erase(fds[i].fd);
+                close(fds[i].fd);
+                fds.erase(fds.begin() + static_cast<long>(i));
+            }
+        }
+        if ((fds[1].revents & POLLIN) != 0) {
+            int fd = accept4(pipe->listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            struct ucred cred = {};
+            if (fd >= 0 && (!GetPeerCredential(fd, cred) || cred.uid != getuid())) {
+                LOG_WARN("refuse peer of uid %{public}u on %{public}s", cred.uid, pipeId.c_str());
+                close(fd);
+            } else if (fd >= 0) {
+                // a peer dying in the middle of a frame must not wedge the pipe
+                struct timeval timeout = { RECEIVE_TIMEOUT_SECONDS, 0 };
+                setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                fds.push_back({ fd, POLLIN, 0 });
+                peers[fd] = { cred.pid, "" };
+            }
+        }
+    }
+    for (size_t i = 2; i < fds.size(); i++) {
+        close(fds[i].fd);
+    }
+}
+
+bool UdsCommunicationProvider::ReceiveFrame(int fd, const std::string &pipeId, Peer &peer)
+{
+    FrameHeader header;
+    if (!ReadFully(fd, &header, sizeof(header))) {
+        return false;
+    }
+    if (header.magic != FRAME_MAGIC || header.senderSize > MAX_SENDER_SIZE || header.dataSize > MAX_FRAME_SIZE) {
+        LOG_ERROR("bad frame on %{public}s, size:%{public}u", pipeId.c_str(), header.dataSize);
+        return false;
+    }
+    std::string sender(header.senderSize, '\0');
+    std::vector<uint8_t> data(header.dataSize);
+    if (!ReadFully(fd, &sender[0], sender.size()) || !ReadFully(fd, data.data(), data.size())) {
+        return false;
+    }
+    if (peer.deviceId.empty()) {
+        if (sender.empty() || !VerifySender(sender, pipeId, peer.pid)) {
+            LOG_WARN("refuse frame of pid %{public}d claiming %{public}s", peer.pid, sender.c_str());
+            return false;
+        }
+        peer.deviceId = sender;
+    } else if (sender != peer.deviceId) {
+        LOG_WARN("sender of a connection changed to %{public}s", sender.c_str());
+        return false;
+    }
+    auto slot = GetListenerSlot(pipeId);
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    if (slot->observer == nullptr) {
+        LOG_WARN("no listener %{public}s.", pipeId.c_str());
+        return true;
+    }
+    DeviceInfo deviceInfo = { sender, "", "" };
+    slot->observer->OnMessage(deviceInfo, data.data(), static_cast<int>(data.size()), { pipeId });
+    return true;
+}
+
+// the sender id is whatever the frame says, so it is only trusted from the process listening on its socket
+bool UdsCommunicationProvider::VerifySender(const std::string &sender, const std::string &pipeId, pid_t pid) const
+{
+    if (sender.find('/') != std::string::npos || sender.find(SEPARATOR) != std::string::npos) {
+        return false;
+    }
+    int fd = Connect(SocketPath(sender, pipeId));
+    if (fd < 0) {
+        return false;
+    }
+    struct ucred cred = {};
+    bool verified = GetPeerCredential(fd, cred) && cred.uid == getuid() && cred.pid == pid;
+    close(fd);
+    return verified;
+}
+
+Status UdsCommunicationProvider::SendData(const PipeInfo &pipeInfo, const DeviceId &deviceId, const uint8_t *ptr,
+    int size, __attribute__((unused)) const MessageInfo &info)
+{
+    if (ptr == nullptr || size <= 0 || static_cast<uint32_t>(size) > MAX_FRAME_SIZE || deviceId.deviceId.empty()) {
+        LOG_WARN("Input is invalid, maxSize:%{public}u, current size:%{public}d", MAX_FRAME_SIZE, size);
+        return Status::ERROR;
+    }
+    std::string path = SocketPath(deviceId.deviceId, pipeInfo.pipeId);
+    std::shared_ptr<Connection> connection;
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex_);
+        auto &item = connections_[path];
+        if (item == nullptr) {
+            item = std::make_shared<Connection>();
+        }
+        connection = item;
+    }
+    return WriteFrame(connection, path, ptr, static_cast<uint32_t>(size));
+}
+
+Status UdsCommunicationProvider::WriteFrame(
+    const std::shared_ptr<Connection> &connection, const std::string &path, const uint8_t *ptr, uint32_t size)
+{
+    std::lock_guard<std::mutex> lock(connection->mutex);
+    // a cached connection may have been closed by a restarted peer, reconnect once
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (connection->fd < 0) {
+            connection->fd = Connect(path);
+            if (connection->fd < 0) {
+                if (errno == ECONNREFUSED) {
+                    LOG_WARN("remove stale socket %{public}s", path.c_str());
+                    unlink(path.c_str());
+                }
+                return Status::CREATE_SESSION_ERROR;
+            }
+        }
+        FrameHeader header = { FRAME_MAGIC, static_cast<uint32_t>(localDeviceId_.size()), size };
+        struct iovec iov[] = {
+            { &header, sizeof(header) },
+            { const_cast<char *>(localDeviceId_.data()), localDeviceId_.size() },
+            { const_cast<uint8_t *>(ptr), size },
+        };
+        if (WriteFully(connection->fd, iov, sizeof(iov) / sizeof(iov[0]))) {
+            return Status::SUCCESS;
+        }
+        int err = errno;
+        // part of the frame may be out, the stream is unusable either way
+        close(connection->fd);
+        connection->fd = -1;
+        if (err == EAGAIN || err == EWOULDBLOCK) {
+            LOG_ERROR("send to %{public}s timed out", path.c_str());
+            return Status::TIME_OUT;
+        }
+        errno = err;
+    }
+    LOG_ERROR("send to %{public}s failed %{public}d", path.c_str(), errno);
+    return Status::ERROR;
+}
+
+std::vector<DeviceInfo> UdsCommunicationProvider::GetDeviceList() const
+{
+    std::vector<DeviceInfo> devices;
+    std::lock_guard<std::mutex> lock(deviceMutex_);
+    for (auto &deviceId : onlineDevices_) {
+        devices.push_back({ deviceId, deviceId, DEVICE_TYPE });
+    }
+    return devices;
+}
+
+DeviceInfo UdsCommunicationProvider::GetLocalDevice() const
+{
+    return { localDeviceId_, localDeviceId_, DEVICE_TYPE };
+}
+
+bool UdsCommunicationProvider::IsSameStartedOnPeer(const PipeInfo &pipeInfo, const DeviceId &peer) const
+{
+    struct stat st;
+    return stat(SocketPath(peer.deviceId, pipeInfo.pipeId).c_str(), &st) == 0 && S_ISSOCK(st.st_mode);
+}
+
+std::set<std::string> UdsCommunicationProvider::ScanDevices() const
+{
+    std::set<std::string> devices;
+    DIR *dir = opendir(socketDir_.c_str());
+    if (dir == nullptr) {
+        return devices;
+    }
+    struct dirent *entry = nullptr;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string name = entry->d_name;
+        auto pos = name.find(SEPARATOR);
+        if (pos == std::string::npos || pos == 0) {
+            continue;
+        }
+        std::string deviceId = name.substr(0, pos);
+        if (deviceId == localDeviceId_ || devices.count(deviceId) != 0) {
+            continue;
+        }
+        struct stat st;
+        std::string path = socketDir_ + "/" + name;
+        if (stat(path.c_str(), &st) != 0 || !S_ISSOCK(st.st_mode)) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(deviceMutex_);
+            if (onlineDevices_.count(deviceId) != 0) {
+                devices.insert(deviceId);
+                continue;
+            }
+        }
+        // only a newcomer is probed, a socket left behind by a crashed process refuses connections
+        int fd = Connect(path);
+        if (fd >= 0) {
+            close(fd);
+            devices.insert(deviceId);
+        }
+    }
+    closedir(dir);
+    return devices;
+}
+
+void UdsCommunicationProvider::DiscoveryLoop()
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(discoveryMutex_);
+            if (discoveryCv_.wait_for(lock, DISCOVERY_INTERVAL, [this]() { return stopped_; })) {
+                return;
+            }
+        }
+        std::set<std::string> devices = ScanDevices();
+        std::vector<std::string> online;
+        std::vector<std::string> offline;
+        {
+            std::lock_guard<std::mutex> lock(deviceMutex_);
+            for (auto &deviceId : devices) {
+                if (onlineDevices_.count(deviceId) == 0) {
+                    online.push_back(deviceId);
+                }
+            }
+            for (auto &deviceId : onlineDevices_) {
+                if (devices.count(deviceId) == 0) {
+                    offline.push_back(deviceId);
+                }
+            }
+            onlineDevices_ = std::move(devices);
+        }
+        for (auto &deviceId : offline) {
+            NotifyDeviceChange(deviceId, DeviceChangeType::DEVICE_OFFLINE);
+        }
+        for (auto &deviceId : online) {
+            NotifyDeviceChange(deviceId, DeviceChangeType::DEVICE_ONLINE);
+        }
+    }
+}
+
+void UdsCommunicationProvider::NotifyDeviceChange(const std::string &deviceId, DeviceChangeType type)
+{
+    LOG_INFO("device %{public}s, type:%{public}d", deviceId.c_str(), type);
+    if (type == DeviceChangeType::DEVICE_OFFLINE) {
+        std::lock_guard<std::mutex> lock(connectionMutex_);
+        std::string prefix = socketDir_ + "/" + deviceId + SEPARATOR;
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            it = (it->first.compare(0, prefix.size(), prefix) == 0) ? connections_.erase(it) : std::next(it);
+        }
+    }
+    std::vector<const AppDeviceStatusChangeListener *> listeners;
+    {
+        std::lock_guard<std::mutex> lock(deviceChangeMutex_);
+        listeners.assign(deviceListeners_.begin(), deviceListeners_.end());
+    }
+    DeviceInfo deviceInfo = { deviceId, deviceId, DEVICE_TYPE };
+    for (auto listener : listeners) {
+        listener->OnDeviceChanged(deviceInfo, type);
+    }
+}
+} // namespace ObjectStore
+} // namespace OHOS
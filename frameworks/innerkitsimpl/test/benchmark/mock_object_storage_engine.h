@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOCK_OBJECT_STORAGE_ENGINE_H
+#define MOCK_OBJECT_STORAGE_ENGINE_H
+
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+#include "object_storage_engine.h"
+#include "objectstore_errors.h"
+
+namespace OHOS::ObjectStore {
+// In memory engine with the locking of FlatObjectStorageEngine and none of DistributedDB, so that a
+// benchmark over it measures what the object store adds on top of the database.
+class MockObjectStorageEngine : public ObjectStorageEngine {
+public:
+    uint32_t Open(const std::string &) override
+    {
+        isOpened_ = true;
+        return SUCCESS;
+    }
+
+    uint32_t Close() override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        tables_.clear();
+        isOpened_ = false;
+        return SUCCESS;
+    }
+
+    uint32_t DeleteTable(const std::string &key) override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        return tables_.erase(key) == 0 ? ERR_DB_NOT_EXIST : SUCCESS;
+    }
+
+    uint32_t CreateTable(const std::string &key, const ObjectOptions &) override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        return tables_.emplace(key, Table {}).second ? SUCCESS : ERR_EXIST;
+    }
+
+    uint32_t GetTable(const std::string &key, std::map<std::string, Value> &result) override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto table = tables_.find(key);
+        if (table == tables_.end()) {
+            return ERR_DB_NOT_EXIST;
+        }
+        result = table->second;
+        return SUCCESS;
+    }
+
+    uint32_t GetItems(
+        const std::string &key, const std::string &prefix, std::map<std::string, Value> &result) override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto table = tables_.find(key);
+        if (table == tables_.end()) {
+            return ERR_DB_NOT_EXIST;
+        }
+        result.clear();
+        for (auto it = table->second.lower_bound(prefix);
+             it != table->second.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            result.insert_or_assign(it->first, it->second);
+        }
+        return SUCCESS;
+    }
+
+    uint32_t UpdateItem(const std::string &key, const std::string &itemKey, const Value &value) override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto table = tables_.find(key);
+        if (table == tables_.end()) {
+            return ERR_DB_NOT_EXIST;
+        }
+        table->second[itemKey] = value;
+        return SUCCESS;
+    }
+
+    uint32_t UpdateItems(const std::string &key, const std::map<std::string, Value> &data,
+        const std::vector<std::string> &removed) override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto table = tables_.find(key);
+        if (table == tables_.end()) {
+            return ERR_DB_NOT_EXIST;
+        }
+        for (auto &[itemKey, value] : data) {
+            table->second[itemKey] = value;
+        }
+        for (auto &itemKey : removed) {
+            table->second.erase(itemKey);
+        }
+        return SUCCESS;
+    }
+
+    uint32_t GetItem(const std::string &key, const std::string &itemKey, Value &value) override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto table = tables_.find(key);
+        if (table == tables_.end()) {
+            return ERR_DB_NOT_EXIST;
+        }
+        auto item = table->second.find(itemKey);
+        if (item == table->second.end()) {
+            return ERR_DB_GET_FAIL;
+        }
+        value = item->second;
+        return SUCCESS;
+    }
+
+    uint32_t DeleteItems(const std::string &key, const std::vector<std::string> &itemKeys) override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto table = tables_.find(key);
+        if (table == tables_.end()) {
+            return ERR_DB_NOT_EXIST;
+        }
+        for (auto &itemKey : itemKeys) {
+            table->second.erase(itemKey);
+        }
+        return SUCCESS;
+    }
+
+    uint32_t RegisterObserver(const std::string &, std::shared_ptr<TableWatcher>) override
+    {
+        return SUCCESS;
+    }
+
+    uint32_t UnRegisterObserver(const std::string &) override
+    {
+        return SUCCESS;
+    }
+
+    uint32_t SetStatusNotifier(std::shared_ptr<StatusWatcher>) override
+    {
+        return SUCCESS;
+    }
+
+    uint32_t SyncAllData(const std::string &,
+        const std::function<void(const std::map<std::string, DistributedDB::DBStatus> &)> &) override
+    {
+        return SUCCESS;
+    }
+
+    uint64_t SetMemoryBudget(uint64_t) override
+    {
+        return 0;
+    }
+
+    void GetUsage(std::map<std::string, SessionStatistics> &usage) override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        usage.clear();
+        for (auto &[key, table] : tables_) {
+            SessionStatistics &session = usage[key];
+            session.fields = table.size();
+            for (auto &[itemKey, value] : table) {
+                session.bytes += itemKey.size() + value.size();
+            }
+        }
+    }
+
+private:
+    using Table = std::map<std::string, Value>;
+    std::shared_mutex mutex_ {};
+    std::map<std::string, Table> tables_ {};
+};
+} // namespace OHOS::ObjectStore
+#endif // MOCK_OBJECT_STORAGE_ENGINE_H
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "distributed_object_impl.h"
+#include "field_codec.h"
+#include "flat_object_store.h"
+#include "mock_object_storage_engine.h"
+#include "objectstore_errors.h"
+
+namespace {
+// allocations made by the calling thread, the measured loop reads it before and after
+thread_local uint64_t t_allocations = 0;
+} // namespace
+
+void *operator new(size_t size)
+{
+    t_allocations++;
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    t_allocations++;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+namespace OHOS::ObjectStore {
+namespace {
+constexpr const char *BUNDLE_NAME = "objectstore_benchmark";
+constexpr const char *FIELD_KEY = "value";
+constexpr size_t BYTES_PER_CASE = 256 * 1024 * 1024;  // payload moved by one case, bounds big values
+constexpr size_t MIN_OPS = 32;
+constexpr size_t MAX_OPS = 50000;
+constexpr size_t WARMUP_OPS = 4;
+constexpr size_t BATCH_FIELDS = 8;
+constexpr size_t COMPLEX_HEAD_SIZE = 8;
+constexpr double P99 = 0.99;
+const std::vector<size_t> DEFAULT_SIZES = { 8, 64, 512, 4 * 1024, 32 * 1024, 256 * 1024, 4 * 1024 * 1024 };
+const std::vector<size_t> DEFAULT_THREADS = { 1, 2, 4, 8, 16, 32 };
+
+// inputs and outputs of one thread, allocated before the measured loop
+struct Context {
+    std::string text;
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> head;
+    std::map<std::string, FieldValue> fields;
+    std::string textOut;
+    std::vector<uint8_t> bytesOut;
+    std::map<std::string, FieldValue> fieldsOut;
+    double number = 0;
+    bool flag = false;
+    Type type = TYPE_STRING;
+    size_t offset = 0;
+};
+
+using Operation = std::function<uint32_t(DistributedObject &object, Context &context)>;
+
+struct Case {
+    const char *name;
+    bool sized;
+    // stores what the operation reads, runs once before the measurement
+    Operation prepare;
+    Operation run;
+};
+
+uint32_t PutString(DistributedObject &object, Context &context)
+{
+    return object.PutString(FIELD_KEY, context.text);
+}
+
+uint32_t PutComplex(DistributedObject &object, Context &context)
+{
+    return object.PutComplex(FIELD_KEY, context.bytes);
+}
+
+uint32_t PutComplexTail(DistributedObject &object, Context &context)
+{
+    return object.PutComplex(FIELD_KEY, context.head, context.bytes.data(), context.bytes.size());
+}
+
+uint32_t PutBatch(DistributedObject &object, Context &context)
+{
+    return object.PutBatch(context.fields);
+}
+
+const std::vector<Case> CASES = {
+    { "PutDouble", false, nullptr,
+        [](DistributedObject &object, Context &) { return object.PutDouble(FIELD_KEY, 1.5); } },
+    { "GetDouble", false,
+        [](DistributedObject &object, Context &) { return object.PutDouble(FIELD_KEY, 1.5); },
+        [](DistributedObject &object, Context &context) { return object.GetDouble(FIELD_KEY, context.number); } },
+    { "PutBoolean", false, nullptr,
+        [](DistributedObject &object, Context &) { return object.PutBoolean(FIELD_KEY, true); } },
+    { "GetBoolean", false,
+        [](DistributedObject &object, Context &) { return object.PutBoolean(FIELD_KEY, true); },
+        [](DistributedObject &object, Context &context) { return object.GetBoolean(FIELD_KEY, context.flag); } },
+    { "GetType", false,
+        [](DistributedObject &object, Context &) { return object.PutBoolean(FIELD_KEY, true); },
+        [](DistributedObject &object, Context &context) { return object.GetType(FIELD_KEY, context.type); } },
+    { "PutString", true, nullptr, PutString },
+    { "GetString", true, PutString,
+        [](DistributedObject &object, Context &context) { return object.GetString(FIELD_KEY, context.textOut); } },
+    { "PutComplex", true, nullptr, PutComplex },
+    { "GetComplex", true, PutComplex,
+        [](DistributedObject &object, Context &context) { return object.GetComplex(FIELD_KEY, context.bytesOut); } },
+    { "PutComplexTail", true, nullptr, PutComplexTail },
+    { "GetComplexOffset", true, PutComplexTail,
+        [](DistributedObject &object, Context &context) {
+            return object.GetComplex(FIELD_KEY, context.bytesOut, context.offset);
+        } },
+    { "PutBatch", true, nullptr, PutBatch },
+    { "GetAll", true, PutBatch,
+        [](DistributedObject &object, Context &context) {
+            context.fieldsOut.clear();
+            return object.GetAll(context.fieldsOut);
+        } },
+    // the same fields through Put<T> and Get<T> of field_codec.h
+    { "TypedPutDouble", false, nullptr,
+        [](DistributedObject &object, Context &) { return Put(object, FIELD_KEY, 1.5); } },
+    { "TypedGetDouble", false,
+        [](DistributedObject &object, Context &) { return Put(object, FIELD_KEY, 1.5); },
+        [](DistributedObject &object, Context &context) { return Get(object, FIELD_KEY, context.number); } },
+    { "TypedPutBoolean", false, nullptr,
+        [](DistributedObject &object, Context &) { return Put(object, FIELD_KEY, true); } },
+    { "TypedGetBoolean", false,
+        [](DistributedObject &object, Context &) { return Put(object, FIELD_KEY, true); },
+        [](DistributedObject &object, Context &context) { return Get(object, FIELD_KEY, context.flag); } },
+    { "TypedPutString", true, nullptr,
+        [](DistributedObject &object, Context &context) { return Put(object, FIELD_KEY, context.text); } },
+    { "TypedGetString", true,
+        [](DistributedObject &object, Context &context) { return Put(object, FIELD_KEY, context.text); },
+        [](DistributedObject &object, Context &context) { return Get(object, FIELD_KEY, context.textOut); } },
+    { "TypedPutComplex", true, nullptr,
+        [](DistributedObject &object, Context &context) { return Put(object, FIELD_KEY, context.bytes); } },
+    { "TypedGetComplex", true,
+        [](DistributedObject &object, Context &context) { return Put(object, FIELD_KEY, context.bytes); },
+        [](DistributedObject &object, Context &context) { return Get(object, FIELD_KEY, context.bytesOut); } },
+};
+
+struct Options {
+    std::string filter;
+    std::vector<size_t> sizes = DEFAULT_SIZES;
+    std::vector<size_t> threads = DEFAULT_THREADS;
+};
+
+struct Result {
+    size_t ops = 0;
+    uint64_t totalNs = 0;
+    uint64_t p99Ns = 0;
+    uint64_t allocations = 0;
+    uint64_t wallNs = 0;
+    uint32_t errors = 0;
+};
+
+uint64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Fill(Context &context, size_t size)
+{
+    context.text.assign(size, 'x');
+    context.bytes.assign(size, 0x5a);
+    context.head.assign(COMPLEX_HEAD_SIZE, 0x01);
+    size_t fieldSize = std::max<size_t>(size / BATCH_FIELDS, 1);
+    for (size_t i = 0; i < BATCH_FIELDS; i++) {
+        context.fields[std::string(FIELD_KEY) + std::to_string(i)] = std::string(fieldSize, 'x');
+    }
+}
+
+size_t OpsPerThread(size_t size, size_t threads)
+{
+    return std::clamp(BYTES_PER_CASE / (std::max<size_t>(size, sizeof(double)) * threads), MIN_OPS, MAX_OPS);
+}
+
+Result Run(FlatObjectStore &store, const Case &benchCase, size_t size, size_t threadCount)
+{
+    size_t ops = OpsPerThread(size, threadCount);
+    std::vector<std::string> sessions;
+    std::vector<std::unique_ptr<DistributedObjectImpl>> objects;
+    std::vector<Context> contexts(threadCount);
+    std::vector<std::vector<uint64_t>> samples(threadCount, std::vector<uint64_t>(ops));
+    std::vector<uint64_t> allocations(threadCount, 0);
+    std::atomic<uint32_t> errors { 0 };
+    // one session per thread, they share the store and its engine lock as separate objects of an app would
+    for (size_t i = 0; i < threadCount; i++) {
+        sessions.push_back(std::string(BUNDLE_NAME) + "_" + std::to_string(i));
+        store.CreateObject(sessions.back());
+        objects.push_back(std::make_unique<DistributedObjectImpl>(sessions.back(), &store));
+        Fill(contexts[i], size);
+        if (benchCase.prepare != nullptr && benchCase.prepare(*objects[i], contexts[i]) != SUCCESS) {
+            errors++;
+        }
+        for (size_t op = 0; op < WARMUP_OPS; op++) {
+            benchCase.run(*objects[i], contexts[i]);
+        }
+    }
+    std::atomic<size_t> ready { 0 };
+    std::atomic<bool> start { false };
+    auto worker = [&](size_t index) {
+        ready++;
+        while (!start.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        auto &object = *objects[index];
+        auto &context = contexts[index];
+        auto &times = samples[index];
+        uint64_t before = t_allocations;
+        for (size_t op = 0; op < ops; op++) {
+            uint64_t begin = NowNs();
+            uint32_t status = benchCase.run(object, context);
+            times[op] = NowNs() - begin;
+            if (status != SUCCESS) {
+                errors++;
+            }
+        }
+        allocations[index] = t_allocations - before;
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threadCount; i++) {
+        workers.emplace_back(worker, i);
+    }
+    while (ready.load() < threadCount) {
+        std::this_thread::yield();
+    }
+    uint64_t wallStart = NowNs();
+    start.store(true, std::memory_order_release);
+    for (auto &thread : workers) {
+        thread.join();
+    }
+    Result result;
+    result.wallNs = NowNs() - wallStart;
+    std::vector<uint64_t> all;
+    all.reserve(ops * threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        all.insert(all.end(), samples[i].begin(), samples[i].end());
+        result.allocations += allocations[i];
+    }
+    for (auto sample : all) {
+        result.totalNs += sample;
+    }
+    result.ops = all.size();
+    auto p99 = all.begin() + static_cast<ptrdiff_t>(P99 * (all.size() - 1));
+    std::nth_element(all.begin(), p99, all.end());
+    result.p99Ns = *p99;
+    result.errors = errors.load();
+    objects.clear();
+    for (auto &session : sessions) {
+        store.Delete(session);
+    }
+    return result;
+}
+
+std::string SizeName(size_t size)
+{
+    constexpr size_t KB = 1024;
+    if (size >= KB * KB && size % (KB * KB) == 0) {
+        return std::to_string(size / (KB * KB)) + "MB";
+    }
+    if (size >= KB && size % KB == 0) {
+        return std::to_string(size / KB) + "KB";
+    }
+    return std::to_string(size) + "B";
+}
+
+std::vector<size_t> ParseList(const char *text)
+{
+    std::vector<size_t> values;
+    for (const char *p = text; *p != '\0';) {
+        char *end = nullptr;
+        values.push_back(strtoull(p, &end, 0));
+        p = (*end == ',') ? end + 1 : end;
+        if (end == p && *p != '\0') {
+            break;
+        }
+    }
+    return values;
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--filter=", strlen("--filter=")) == 0) {
+            options.filter = arg + strlen("--filter=");
+        } else if (strncmp(arg, "--sizes=", strlen("--sizes=")) == 0) {
+            options.sizes = ParseList(arg + strlen("--sizes="));
+        } else if (strncmp(arg, "--threads=", strlen("--threads=")) == 0) {
+            options.threads = ParseList(arg + strlen("--threads="));
+        } else {
+            printf("usage: %s [--filter=<case substring>] [--sizes=8,4096,...] [--threads=1,4,...]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+int Main(int argc, char *argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return EXIT_FAILURE;
+    }
+    FlatObjectStore store(BUNDLE_NAME, std::make_shared<MockObjectStorageEngine>());
+    printf("%-18s %8s %7s %12s %10s %12s %14s\n", "case", "size", "threads", "ns/op", "allocs/op", "p99(ns)",
+        "ops/s");
+    uint32_t failed = 0;
+    for (auto &benchCase : CASES) {
+        if (!options.filter.empty() && strstr(benchCase.name, options.filter.c_str()) == nullptr) {
+            continue;
+        }
+        std::vector<size_t> sizes = benchCase.sized ? options.sizes : std::vector<size_t> { sizeof(double) };
+        for (auto size : sizes) {
+            for (auto threads : options.threads) {
+                if (threads == 0) {
+                    continue;
+                }
+                Result result = Run(store, benchCase, size, threads);
+                double nsPerOp = static_cast<double>(result.totalNs) / result.ops;
+                double allocsPerOp = static_cast<double>(result.allocations) / result.ops;
+                double opsPerSecond = result.ops * 1e9 / std::max<uint64_t>(result.wallNs, 1);
+                printf("%-18s %8s %7zu %12.1f %10.2f %12" PRIu64 " %14.0f%s\n", benchCase.name,
+                    benchCase.sized ? SizeName(size).c_str() : "-", threads, nsPerOp, allocsPerOp, result.p99Ns,
+                    opsPerSecond, result.errors == 0 ? "" : " FAILED");
+                fflush(stdout);
+                failed += result.errors;
+            }
+        }
+    }
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+} // namespace OHOS::ObjectStore
+
+int main(int argc, char *argv[])
+{
+    return OHOS::ObjectStore::Main(argc, argv);
+}
@@ -0,0 +1,748 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "communication_provider.h"
+#include "distributed_object_impl.h"
+#include "flat_object_storage_engine.h"
+#include "flat_object_store.h"
+#include "objectstore_errors.h"
+#include "virtual_communication_provider.h"
+#include "virtual_network.h"
+
+namespace OHOS::ObjectStore {
+namespace {
+constexpr const char *BUNDLE_NAME = "objectstore_sync_benchmark";
+constexpr const char *SESSION_ID = "sync_benchmark_session";
+constexpr const char *DOCUMENT_KEY = "document";
+constexpr size_t MARKER_SIZE = 32;
+constexpr const char *DATA_ROOT = "/data/local/tmp/objectstore_sync_benchmark";
+constexpr size_t LINE_SIZE = 4096;
+constexpr int64_t NS_PER_MS = 1000000;
+constexpr std::chrono::milliseconds MIN_SETTLE = std::chrono::milliseconds(200);
+constexpr int SETTLE_LATENCIES = 4;
+
+struct Options {
+    uint32_t devices = 3;
+    uint32_t latencyMs = 20;
+    uint64_t bandwidthKbps = 0;
+    double loss = 0;
+    uint32_t mtu = 0;
+    uint32_t fields = 16;
+    uint32_t size = 256;
+    uint32_t documentSize = 2 * 1024 * 1024;
+    std::vector<std::string> workloads = { "single", "all", "rejoin", "restart", "restart-durable", "edit",
+        "edit-whole" };
+    uint32_t timeoutMs = 30000;
+    uint32_t seed = 1;
+    bool verbose = false;
+};
+
+struct Result {
+    std::string workload;
+    uint32_t ops = 0;
+    bool converged = true;
+    int64_t convergeNs = 0;
+    NetworkStatistics statistics;
+};
+
+int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+std::string DeviceId(uint32_t index)
+{
+    return "device" + std::to_string(index);
+}
+
+std::string FieldKey(uint32_t writer, uint32_t index)
+{
+    return "f" + std::to_string(writer) + "_" + std::to_string(index);
+}
+
+std::vector<std::string> Split(const std::string &text, char separator)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, separator)) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// one simulated device, runs in its own process: DistributedDB keeps one communicator per process
+class Device {
+public:
+    explicit Device(int controlFd) : control_(fdopen(controlFd, "r+"))
+    {
+    }
+    ~Device()
+    {
+        if (control_ != nullptr) {
+            fclose(control_);
+        }
+    }
+    DISABLE_COPY_AND_MOVE(Device);
+
+    int Run(const std::string &deviceId, int networkFd, const std::string &dataDir);
+
+private:
+    class ChangeWatcher : public FlatObjectWatcher {
+    public:
+        ChangeWatcher(const std::string &sessionId, Device &device) : FlatObjectWatcher(sessionId), device_(device)
+        {
+        }
+        void OnChanged(__attribute__((unused)) const std::string &sessionid,
+            __attribute__((unused)) const std::vector<std::string> &changedData) override
+        {
+            std::lock_guard<std::mutex> lock(device_.mutex_);
+            device_.changes_++;
+            device_.cv_.notify_all();
+        }
+
+    private:
+        Device &device_;
+    };
+    // peers coming back online pull what they missed, like the js status listener does
+    class PullWatcher : public StatusWatcher {
+    public:
+        void OnChanged(__attribute__((unused)) const std::string &sessionId,
+            __attribute__((unused)) const std::string &networkId,
+            __attribute__((unused)) const std::string &onlineStatus) override
+        {
+        }
+    };
+
+    void Reply(const char *result, int64_t ns);
+    void Write(const std::string &tag, uint32_t count, uint32_t size);
+    void Edit(const std::string &tag, uint32_t size);
+    void Wait(const std::function<bool()> &converged, uint32_t timeoutMs);
+    void Reopen(bool durable);
+    bool Converged(const std::string &tag, uint32_t count, const std::vector<uint32_t> &writers);
+    bool Edited(const std::string &tag, uint32_t size);
+
+    FILE *control_;
+    uint32_t index_ = 0;
+    std::string dataDir_;
+    std::unique_ptr<FlatObjectStore> store_;
+    std::unique_ptr<DistributedObjectImpl> object_;
+    std::vector<uint8_t> document_;
+    std::mutex mutex_ {};
+    std::condition_variable cv_ {};
+    uint64_t changes_ = 0;
+};
+
+int Device::Run(const std::string &deviceId, int networkFd, const std::string &dataDir)
+{
+    index_ = static_cast<uint32_t>(std::stoul(deviceId.substr(strlen("device"))));
+    dataDir_ = dataDir;
+    VirtualCommunicationProvider provider(deviceId, networkFd);
+    CommunicationProvider::SetInstance(&provider);
+    store_ = std::make_unique<FlatObjectStore>(BUNDLE_NAME, std::make_shared<FlatObjectStorageEngine>());
+    if (store_->CreateObject(SESSION_ID) != SUCCESS
+        || store_->Watch(SESSION_ID, std::make_shared<ChangeWatcher>(SESSION_ID, *this)) != SUCCESS
+        || store_->SetStatusNotifier(std::make_shared<PullWatcher>()) != SUCCESS) {
+        Reply("error", NowNs());
+        return EXIT_FAILURE;
+    }
+    object_ = std::make_unique<DistributedObjectImpl>(SESSION_ID, store_.get());
+    Reply("ready", NowNs());
+    char line[LINE_SIZE];
+    while (fgets(line, sizeof(line), control_) != nullptr) {
+        std::vector<std::string> args = Split(std::string(line, strcspn(line, "\n")), ' ');
+        if (args.empty() || args[0] == "quit") {
+            break;
+        }
+        // reopen <memory|durable> closes the session and waits like wait does in the session opened again
+        bool reopen = args[0] == "reopen" && args.size() == 6;
+        if (reopen) {
+            Reopen(args[1] == "durable");
+            args.erase(args.begin());
+        }
+        if (object_ == nullptr) {
+            Reply("error", NowNs());
+        } else if (args[0] == "write" && args.size() == 4) {
+            Write(args[1], std::stoul(args[2]), std::stoul(args[3]));
+        } else if ((args[0] == "wait" || reopen) && args.size() == 5) {
+            std::vector<uint32_t> writers;
+            for (auto &writer : Split(args[3], ',')) {
+                writers.push_back(std::stoul(writer));
+            }
+            std::string tag = args[1];
+            uint32_t count = std::stoul(args[2]);
+            Wait([this, &tag, count, &writers]() { return Converged(tag, count, writers); }, std::stoul(args[4]));
+        } else if (args[0] == "edit" && args.size() == 3) {
+            Edit(args[1], std::stoul(args[2]));
+        } else if (args[0] == "editwait" && args.size() == 4) {
+            std::string tag = args[1];
+            uint32_t size = std::stoul(args[2]);
+            Wait([this, &tag, size]() { return Edited(tag, size); }, std::stoul(args[3]));
+        } else if (args[0] == "chunking" && args.size() == 2) {
+            DistributedObjectImpl::SetChunkThreshold(
+                args[1] == "on" ? DistributedObjectImpl::CHUNK_THRESHOLD : SIZE_MAX);
+            Reply("done", NowNs());
+        } else {
+            Reply("error", NowNs());
+        }
+    }
+    object_ = nullptr;
+    store_->UnWatch(SESSION_ID);
+    store_->Delete(SESSION_ID);
+    store_ = nullptr;
+    return EXIT_SUCCESS;
+}
+
+// as close to a restart of the application as one process gets: the session is closed, so a memory
+// store loses its data, and opened again
+void Device::Reopen(bool durable)
+{
+    object_ = nullptr;
+    store_->UnWatch(SESSION_ID);
+    store_->Delete(SESSION_ID);
+    ObjectOptions options;
+    options.durable = durable;
+    options.dataDir = dataDir_;
+    if (store_->CreateObject(SESSION_ID, options) != SUCCESS
+        || store_->Watch(SESSION_ID, std::make_shared<ChangeWatcher>(SESSION_ID, *this)) != SUCCESS) {
+        return;
+    }
+    object_ = std::make_unique<DistributedObjectImpl>(SESSION_ID, store_.get());
+}
+
+void Device::Reply(const char *result, int64_t ns)
+{
+    fprintf(control_, "%s %" PRId64 "\n", result, ns);
+    fflush(control_);
+}
+
+void Device::Write(const std::string &tag, uint32_t count, uint32_t size)
+{
+    std::string value = tag + ":";
+    if (value.size() < size) {
+        value.resize(size, 'x');
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (object_->PutString(FieldKey(index_, i), value) != SUCCESS) {
+            Reply("error", NowNs());
+            return;
+        }
+    }
+    Reply("done", NowNs());
+}
+
+// inserts a marker of the tag into the middle of a document of size random bytes, the document is
+// put whole every time, how much of it goes over the wire is up to the store
+void Device::Edit(const std::string &tag, uint32_t size)
+{
+    if (document_.size() < size) {
+        std::mt19937 random(size);
+        document_.resize(size);
+        for (auto &byte : document_) {
+            byte = static_cast<uint8_t>(random());
+        }
+    }
+    std::string marker = tag + ":";
+    marker.resize(MARKER_SIZE, '-');
+    document_.insert(document_.begin() + size / 2, marker.begin(), marker.end());
+    Reply(object_->PutComplex(DOCUMENT_KEY, document_) == SUCCESS ? "done" : "error", NowNs());
+}
+
+bool Device::Edited(const std::string &tag, uint32_t size)
+{
+    std::string marker = tag + ":";
+    std::vector<uint8_t> document;
+    return object_->GetComplex(DOCUMENT_KEY, document) == SUCCESS && document.size() >= size / 2 + marker.size()
+        && std::equal(marker.begin(), marker.end(), document.begin() + size / 2);
+}
+
+bool Device::Converged(const std::string &tag, uint32_t count, const std::vector<uint32_t> &writers)
+{
+    std::string prefix = tag + ":";
+    std::string value;
+    for (auto writer : writers) {
+        for (uint32_t i = 0; i < count; i++) {
+            if (object_->GetString(FieldKey(writer, i), value) != SUCCESS || value.compare(0, prefix.size(), prefix)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void Device::Wait(const std::function<bool()> &converged, uint32_t timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        uint64_t changes = changes_;
+        lock.unlock();
+        // checked after taking the change count, a change landing during the check wakes the wait up
+        bool done = converged();
+        int64_t now = NowNs();
+        lock.lock();
+        if (done) {
+            Reply("done", now);
+            return;
+        }
+        if (!cv_.wait_until(lock, deadline, [this, changes]() { return changes_ != changes; })) {
+            Reply("timeout", NowNs());
+            return;
+        }
+    }
+}
+
+// parent side of the control socket of one device
+class Channel {
+public:
+    Channel(pid_t pid, int fd) : pid_(pid), stream_(fdopen(fd, "r+"))
+    {
+    }
+    ~Channel()
+    {
+        if (stream_ != nullptr) {
+            fclose(stream_);
+        }
+        if (pid_ > 0) {
+            waitpid(pid_, nullptr, 0);
+        }
+    }
+    DISABLE_COPY_AND_MOVE(Channel);
+
+    void Send(const std::string &command)
+    {
+        fprintf(stream_, "%s\n", command.c_str());
+        fflush(stream_);
+    }
+    // returns false for anything but done or ready
+    bool Receive(int64_t &ns)
+    {
+        char line[LINE_SIZE];
+        char result[LINE_SIZE];
+        if (fgets(line, sizeof(line), stream_) == nullptr || sscanf(line, "%4095s %" SCNd64, result, &ns) != 2) {
+            return false;
+        }
+        return strcmp(result, "done") == 0 || strcmp(result, "ready") == 0;
+    }
+
+private:
+    pid_t pid_;
+    FILE *stream_;
+};
+
+class Harness {
+public:
+    explicit Harness(const Options &options) : options_(options)
+    {
+    }
+    ~Harness() = default;
+    DISABLE_COPY_AND_MOVE(Harness);
+
+    bool Start();
+    void Stop();
+    bool RunWorkload(const std::string &workload, std::vector<Result> &results);
+
+private:
+    bool Round(const std::string &tag, const std::vector<uint32_t> &writers, const std::vector<uint32_t> &waiters,
+        int64_t &convergeNs);
+    bool Catchup(const std::string &tag, const std::vector<uint32_t> &writers, uint32_t device, int64_t &convergeNs);
+    bool Restart(const std::string &tag, const std::vector<uint32_t> &writers, uint32_t device, bool durable,
+        int64_t &convergeNs);
+    bool EditRound(const std::string &tag, const std::vector<uint32_t> &waiters, int64_t &convergeNs);
+    bool SetChunking(bool enabled);
+    void Settle();
+    std::string WriterList(const std::vector<uint32_t> &writers) const;
+    static NetworkStatistics Delta(const NetworkStatistics &end, const NetworkStatistics &begin);
+
+    const Options options_;
+    std::unique_ptr<VirtualNetwork> network_;
+    std::vector<std::unique_ptr<Channel>> channels_;
+    uint32_t round_ = 0;
+    // durable stores of this run, removed when it stops
+    const std::string dataDir_ = std::string(DATA_ROOT) + "/" + std::to_string(getpid());
+};
+
+bool Harness::Start()
+{
+    LinkConfig config;
+    config.latency = std::chrono::milliseconds(options_.latencyMs);
+    config.bandwidth = options_.bandwidthKbps * 1000 / 8;
+    config.loss = options_.loss;
+    config.mtu = options_.mtu;
+    network_ = std::make_unique<VirtualNetwork>(config, options_.seed);
+    std::vector<int> networkFds;
+    std::vector<int> controlFds;
+    for (uint32_t i = 0; i < options_.devices; i++) {
+        int network[2];
+        int control[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, network) != 0
+            || socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, control) != 0) {
+            perror("socketpair");
+            return false;
+        }
+        networkFds.insert(networkFds.end(), network, network + 2);
+        controlFds.insert(controlFds.end(), control, control + 2);
+    }
+    // every device forks before the network starts a thread
+    for (uint32_t i = 0; i < options_.devices; i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return false;
+        }
+        if (pid == 0) {
+            for (size_t fd = 0; fd < networkFds.size(); fd++) {
+                if (fd != 2 * i + 1) {
+                    close(networkFds[fd]);
+                    close(controlFds[fd]);
+                }
+            }
+            if (!options_.verbose) {
+                int null = open("/dev/null", O_WRONLY | O_CLOEXEC);
+                dup2(null, STDOUT_FILENO);
+                close(null);
+            }
+            int status =
+                Device(controlFds[2 * i + 1]).Run(DeviceId(i), networkFds[2 * i + 1], dataDir_ + "/" + DeviceId(i));
+            _exit(status);
+        }
+        close(networkFds[2 * i + 1]);
+        close(controlFds[2 * i + 1]);
+        network_->AddDevice(DeviceId(i), networkFds[2 * i]);
+        channels_.push_back(std::make_unique<Channel>(pid, controlFds[2 * i]));
+    }
+    if (!network_->Start()) {
+        return false;
+    }
+    for (auto &channel : channels_) {
+        int64_t ns = 0;
+        if (!channel->Receive(ns)) {
+            fprintf(stderr, "a device failed to open its store\n");
+            return false;
+        }
+    }
+    Settle();
+    return true;
+}
+
+void Harness::Stop()
+{
+    for (auto &channel : channels_) {
+        channel->Send("quit");
+    }
+    channels_.clear();
+    if (network_ != nullptr) {
+        network_->Stop();
+    }
+    std::error_code error;
+    std::filesystem::remove_all(dataDir_, error);
+}
+
+std::string Harness::WriterList(const std::vector<uint32_t> &writers) const
+{
+    std::string list;
+    for (auto writer : writers) {
+        list += (list.empty() ? "" : ",") + std::to_string(writer);
+    }
+    return list;
+}
+
+void Harness::Settle()
+{
+    // lets acks and retransmissions of the last round drain before the statistics are read
+    auto latency = std::chrono::milliseconds(options_.latencyMs);
+    std::this_thread::sleep_for(std::max<std::chrono::milliseconds>(MIN_SETTLE, latency * SETTLE_LATENCIES));
+}
+
+NetworkStatistics Harness::Delta(const NetworkStatistics &end, const NetworkStatistics &begin)
+{
+    return { end.frames - begin.frames, end.bytes - begin.bytes, end.lostFrames - begin.lostFrames,
+        end.offlineFrames - begin.offlineFrames, end.rejectedFrames - begin.rejectedFrames };
+}
+
+bool Harness::Round(const std::string &tag, const std::vector<uint32_t> &writers,
+    const std::vector<uint32_t> &waiters, int64_t &convergeNs)
+{
+    std::string command = "wait " + tag + " " + std::to_string(options_.fields) + " " + WriterList(writers) + " " +
+        std::to_string(options_.timeoutMs);
+    int64_t start = NowNs();
+    for (auto writer : writers) {
+        channels_[writer]->Send("write " + tag + " " + std::to_string(options_.fields) + " " +
+            std::to_string(options_.size));
+    }
+    for (auto waiter : waiters) {
+        channels_[waiter]->Send(command);
+    }
+    // replies of one device come in command order, a writer answers its write first
+    bool converged = true;
+    int64_t end = start;
+    std::set<uint32_t> writing(writers.begin(), writers.end());
+    for (uint32_t device = 0; device < channels_.size(); device++) {
+        int64_t ns = 0;
+        if (writing.count(device) != 0 && !channels_[device]->Receive(ns)) {
+            converged = false;
+        }
+    }
+    for (auto waiter : waiters) {
+        int64_t ns = 0;
+        converged = channels_[waiter]->Receive(ns) && converged;
+        end = std::max(end, ns);
+    }
+    convergeNs = end - start;
+    return converged;
+}
+
+bool Harness::Catchup(const std::string &tag, const std::vector<uint32_t> &writers, uint32_t device,
+    int64_t &convergeNs)
+{
+    int64_t start = NowNs();
+    network_->SetOnline(DeviceId(device), true);
+    channels_[device]->Send("wait " + tag + " " + std::to_string(options_.fields) + " " + WriterList(writers) + " " +
+        std::to_string(options_.timeoutMs));
+    int64_t end = 0;
+    bool converged = channels_[device]->Receive(end);
+    convergeNs = end - start;
+    return converged;
+}
+
+// time from asking the device to reopen its session until it has every field of the writers again
+bool Harness::Restart(const std::string &tag, const std::vector<uint32_t> &writers, uint32_t device, bool durable,
+    int64_t &convergeNs)
+{
+    int64_t start = NowNs();
+    channels_[device]->Send(std::string("reopen ") + (durable ? "durable " : "memory ") + tag + " " +
+        std::to_string(options_.fields) + " " + WriterList(writers) + " " + std::to_string(options_.timeoutMs));
+    int64_t end = 0;
+    bool converged = channels_[device]->Receive(end);
+    convergeNs = end - start;
+    return converged;
+}
+
+// time from device 0 putting its edited document until every waiter reads the edit
+bool Harness::EditRound(const std::string &tag, const std::vector<uint32_t> &waiters, int64_t &convergeNs)
+{
+    int64_t start = NowNs();
+    channels_[0]->Send("edit " + tag + " " + std::to_string(options_.documentSize));
+    for (auto waiter : waiters) {
+        channels_[waiter]->Send("editwait " + tag + " " + std::to_string(options_.documentSize) + " " +
+            std::to_string(options_.timeoutMs));
+    }
+    int64_t end = start;
+    bool converged = channels_[0]->Receive(end);
+    for (auto waiter : waiters) {
+        int64_t ns = 0;
+        converged = channels_[waiter]->Receive(ns) && converged;
+        end = std::max(end, ns);
+    }
+    convergeNs = end - start;
+    return converged;
+}
+
+// only the writer decides how a value is stored, the readers take both forms
+bool Harness::SetChunking(bool enabled)
+{
+    int64_t ns = 0;
+    channels_[0]->Send(std::string("chunking ") + (enabled ? "on" : "off"));
+    return channels_[0]->Receive(ns);
+}
+
+bool Harness::RunWorkload(const std::string &workload, std::vector<Result> &results)
+{
+    std::vector<uint32_t> all;
+    for (uint32_t i = 0; i < options_.devices; i++) {
+        all.push_back(i);
+    }
+    std::string tag = "r" + std::to_string(round_++);
+    Result result;
+    result.workload = workload;
+    NetworkStatistics begin = network_->GetStatistics();
+    if (workload == "single") {
+        std::vector<uint32_t> waiters(all.begin() + 1, all.end());
+        result.ops = options_.fields;
+        result.converged = Round(tag, { 0 }, waiters, result.convergeNs);
+    } else if (workload == "all") {
+        result.ops = options_.fields * options_.devices;
+        result.converged = Round(tag, all, all, result.convergeNs);
+    } else if (workload == "rejoin") {
+        // the last device misses a round of all the others, then catches up when it comes back
+        uint32_t last = options_.devices - 1;
+        std::vector<uint32_t> others(all.begin(), all.end() - 1);
+        network_->SetOnline(DeviceId(last), false);
+        Settle();
+        int64_t roundNs = 0;
+        bool converged = Round(tag, others, others, roundNs);
+        Settle();
+        begin = network_->GetStatistics();
+        result.ops = options_.fields * static_cast<uint32_t>(others.size());
+        result.converged = Catchup(tag, others, last, result.convergeNs) && converged;
+    } else if (workload == "restart" || workload == "restart-durable") {
+        // the last device restarts after a round of the others: a memory store pulls everything back
+        // from the peers, a durable one reads it from disk
+        uint32_t last = options_.devices - 1;
+        std::vector<uint32_t> others(all.begin(), all.end() - 1);
+        bool durable = workload == "restart-durable";
+        int64_t roundNs = 0;
+        bool converged = true;
+        if (durable) {
+            // switches the device to a durable store first, so the measured round is on its disk
+            converged = Round(tag, others, all, roundNs) && Restart(tag, others, last, true, roundNs);
+            tag = "r" + std::to_string(round_++);
+        }
+        converged = Round(tag, others, all, roundNs) && converged;
+        Settle();
+        begin = network_->GetStatistics();
+        result.ops = options_.fields * static_cast<uint32_t>(others.size());
+        result.converged = Restart(tag, others, last, durable, result.convergeNs) && converged;
+    } else if (workload == "edit" || workload == "edit-whole") {
+        // device 0 puts a large document, then inserts a few bytes into its middle and only that is
+        // measured; edit sends the chunks the insert touched, edit-whole the document in one piece
+        std::vector<uint32_t> waiters(all.begin() + 1, all.end());
+        int64_t roundNs = 0;
+        bool converged = SetChunking(workload == "edit") && EditRound(tag, waiters, roundNs);
+        tag = "r" + std::to_string(round_++);
+        Settle();
+        begin = network_->GetStatistics();
+        result.ops = 1;
+        result.converged = EditRound(tag, waiters, result.convergeNs) && converged;
+        SetChunking(true);
+    } else {
+        fprintf(stderr, "unknown workload %s\n", workload.c_str());
+        return false;
+    }
+    Settle();
+    result.statistics = Delta(network_->GetStatistics(), begin);
+    results.push_back(result);
+    return result.converged;
+}
+
+void PrintResults(const Options &options, const std::vector<Result> &results)
+{
+    printf("devices=%u latency=%ums bandwidth=%" PRIu64 "kbps loss=%.3f mtu=%u fields=%u size=%uB document=%uB\n",
+        options.devices, options.latencyMs, options.bandwidthKbps, options.loss, options.mtu, options.fields,
+        options.size, options.documentSize);
+    printf("%-8s %8s %8s %14s %12s %8s %10s %6s %8s %9s\n", "workload", "devices", "ops", "converge(ms)",
+        "wire bytes", "frames", "frames/op", "lost", "offline", "rejected");
+    for (auto &result : results) {
+        char converge[32];
+        if (result.converged) {
+            snprintf(converge, sizeof(converge), "%.2f", static_cast<double>(result.convergeNs) / NS_PER_MS);
+        } else {
+            snprintf(converge, sizeof(converge), "timeout");
+        }
+        const NetworkStatistics &statistics = result.statistics;
+        printf("%-8s %8u %8u %14s %12" PRIu64 " %8" PRIu64 " %10.2f %6" PRIu64 " %8" PRIu64 " %9" PRIu64 "\n",
+            result.workload.c_str(), options.devices, result.ops, converge, statistics.bytes, statistics.frames,
+            result.ops == 0 ? 0.0 : static_cast<double>(statistics.frames) / result.ops, statistics.lostFrames,
+            statistics.offlineFrames, statistics.rejectedFrames);
+    }
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t pos = arg.find('=');
+        std::string name = arg.substr(0, pos);
+        std::string value = pos == std::string::npos ? "" : arg.substr(pos + 1);
+        if (name == "--devices") {
+            options.devices = std::stoul(value);
+        } else if (name == "--latency-ms") {
+            options.latencyMs = std::stoul(value);
+        } else if (name == "--bandwidth-kbps") {
+            options.bandwidthKbps = std::stoull(value);
+        } else if (name == "--loss") {
+            options.loss = std::stod(value);
+        } else if (name == "--mtu") {
+            options.mtu = std::stoul(value);
+        } else if (name == "--fields") {
+            options.fields = std::stoul(value);
+        } else if (name == "--size") {
+            options.size = std::stoul(value);
+        } else if (name == "--document-size") {
+            options.documentSize = std::stoul(value);
+        } else if (name == "--workload") {
+            options.workloads = Split(value, ',');
+        } else if (name == "--timeout-ms") {
+            options.timeoutMs = std::stoul(value);
+        } else if (name == "--seed") {
+            options.seed = std::stoul(value);
+        } else if (name == "--verbose") {
+            options.verbose = true;
+        } else {
+            return false;
+        }
+    }
+    return options.devices >= 2 && options.fields > 0;
+}
+} // namespace
+} // namespace OHOS::ObjectStore
+
+int main(int argc, char *argv[])
+{
+    using namespace OHOS::ObjectStore;
+    Options options;
+    try {
+        if (!ParseOptions(argc, argv, options)) {
+            throw std::invalid_argument("usage");
+        }
+    } catch (const std::exception &) {
+        fprintf(stderr,
+            "usage: %s [--devices=3] [--latency-ms=20] [--bandwidth-kbps=0] [--loss=0] [--mtu=0] [--fields=16]\n"
+            "       [--size=256] [--document-size=2097152]\n"
+            "       [--workload=single,all,rejoin,restart,restart-durable,edit,edit-whole] [--timeout-ms=30000]\n"
+            "       [--seed=1] [--verbose]\n",
+            argv[0]);
+        return EXIT_FAILURE;
+    }
+    Harness harness(options);
+    if (!harness.Start()) {
+        harness.Stop();
+        return EXIT_FAILURE;
+    }
+    std::vector<Result> results;
+    bool converged = true;
+    for (auto &workload : options.workloads) {
+        converged = harness.RunWorkload(workload, results) && converged;
+    }
+    harness.Stop();
+    PrintResults(options, results);
+    return converged ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "virtual_communication_provider.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "link_profile.h"
+#include "logger.h"
+#include "virtual_network.h"
+
+namespace OHOS::ObjectStore {
+namespace {
+void CopyId(char (&dst)[VirtualFrame::ID_SIZE], const std::string &src)
+{
+    size_t size = std::min(src.size(), static_cast<size_t>(VirtualFrame::ID_SIZE - 1));
+    std::memcpy(dst, src.data(), size);
+    dst[size] = '\0';
+}
+} // namespace
+
+VirtualCommunicationProvider::VirtualCommunicationProvider(const std::string &deviceId, int fd)
+    : localDeviceId_(deviceId), fd_(fd)
+{
+    reader_ = std::thread([this]() { ReceiveLoop(); });
+    WriteFrame(VirtualFrame::HELLO, localDeviceId_, "", nullptr, 0);
+    std::unique_lock<std::mutex> lock(configMutex_);
+    configCv_.wait(lock, [this]() { return configured_; });
+}
+
+VirtualCommunicationProvider::~VirtualCommunicationProvider()
+{
+    // the reader leaves once the network side is closed too
+    shutdown(fd_, SHUT_RDWR);
+    if (reader_.joinable()) {
+        reader_.join();
+    }
+    close(fd_);
+}
+
+Status VirtualCommunicationProvider::StartWatchDeviceChange(
+    const AppDeviceStatusChangeListener *observer, __attribute__((unused)) const PipeInfo &pipeInfo)
+{
+    if (observer == nullptr) {
+        return Status::INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lock(deviceChangeMutex_);
+    return deviceListeners_.insert(observer).second ? Status::SUCCESS : Status::ERROR;
+}
+
+Status VirtualCommunicationProvider::StopWatchDeviceChange(
+    const AppDeviceStatusChangeListener *observer, __attribute__((unused)) const PipeInfo &pipeInfo)
+{
+    std::lock_guard<std::mutex> lock(deviceChangeMutex_);
+    return deviceListeners_.erase(observer) > 0 ? Status::SUCCESS : Status::ERROR;
+}
+
+Status VirtualCommunicationProvider::StartWatchDataChange(
+    const AppDataChangeListener *observer, const PipeInfo &pipeInfo)
+{
+    if (observer == nullptr) {
+        return Status::INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lock(listenerMutex_);
+    return dataListeners_.emplace(pipeInfo.pipeId, observer).second ? Status::SUCCESS : Status::ERROR;
+}
+
+Status VirtualCommunicationProvider::StopWatchDataChange(
+    __attribute__((unused)) const AppDataChangeListener *observer, const PipeInfo &pipeInfo)
+{
+    std::lock_guard<std::mutex> lock(listenerMutex_);
+    return dataListeners_.erase(pipeInfo.pipeId) > 0 ? Status::SUCCESS : Status::ERROR;
+}
+
+Status VirtualCommunicationProvider::Start(__attribute__((unused)) const PipeInfo &pipeInfo)
+{
+    return Status::SUCCESS;
+}
+
+Status VirtualCommunicationProvider::Stop(__attribute__((unused)) const PipeInfo &pipeInfo)
+{
+    return Status::SUCCESS;
+}
+
+Status VirtualCommunicationProvider::SendData(const PipeInfo &pipeInfo, const DeviceId &deviceId,
+    const uint8_t *ptr, int size, __attribute__((unused)) const MessageInfo &info)
+{
+    if (ptr == nullptr || size <= 0 || deviceId.deviceId.empty()) {
+        return Status::ERROR;
+    }
+    {
+        std::lock_guard<std::mutex> lock(deviceMutex_);
+        if (onlineDevices_.count(deviceId.deviceId) == 0) {
+            return Status::ERROR;
+        }
+    }
+    auto bytes = static_cast<uint32_t>(size);
+    if (mtu_ != 0 && bytes > mtu_) {
+        // the link refuses the frame like a softbus session does, the profile shrinks the next ones
+        WriteFrame(VirtualFrame::REJECTED, deviceId.deviceId, pipeInfo.pipeId, nullptr, 0);
+        LinkProfileManager::GetInstance().OnSendComplete(deviceId.deviceId, bytes, std::chrono::microseconds(0), false);
+        return Status::ERROR;
+    }
+    auto start = std::chrono::steady_clock::now();
+    bool success = WriteFrame(VirtualFrame::DATA, deviceId.deviceId, pipeInfo.pipeId, ptr, bytes);
+    auto cost = std::chrono::steady_clock::now() - start;
+    LinkProfileManager::GetInstance().OnSendComplete(
+        deviceId.deviceId, bytes, std::chrono::duration_cast<std::chrono::microseconds>(cost), success);
+    return success ? Status::SUCCESS : Status::ERROR;
+}
+
+std::vector<DeviceInfo> VirtualCommunicationProvider::GetDeviceList() const
+{
+    std::vector<DeviceInfo> devices;
+    std::lock_guard<std::mutex> lock(deviceMutex_);
+    for (auto &deviceId : onlineDevices_) {
+        devices.push_back({ deviceId, deviceId, DEVICE_TYPE });
+    }
+    return devices;
+}
+
+DeviceInfo VirtualCommunicationProvider::GetLocalDevice() const
+{
+    return { localDeviceId_, localDeviceId_, DEVICE_TYPE };
+}
+
+bool VirtualCommunicationProvider::IsSameStartedOnPeer(
+    __attribute__((unused)) const PipeInfo &pipeInfo, const DeviceId &peer) const
+{
+    std::lock_guard<std::mutex> lock(deviceMutex_);
+    return onlineDevices_.count(peer.deviceId) != 0;
+}
+
+bool VirtualCommunicationProvider::WriteFrame(
+    uint32_t type, const std::string &deviceId, const std::string &pipeId, const uint8_t *ptr, uint32_t size)
+{
+    VirtualFrame frame;
+    frame.type = type;
+    frame.size = size;
+    CopyId(frame.device, deviceId);
+    CopyId(frame.pipe, pipeId);
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    return VirtualFrame::Write(fd_, frame, ptr);
+}
+
+void VirtualCommunicationProvider::ReceiveLoop()
+{
+    VirtualFrame frame;
+    std::vector<uint8_t> payload;
+    while (VirtualFrame::Read(fd_, &frame, sizeof(frame))) {
+        payload.resize(frame.size);
+        if (!VirtualFrame::Read(fd_, payload.data(), payload.size())) {
+            break;
+        }
+        std::string peer(frame.device, strnlen(frame.device, VirtualFrame::ID_SIZE));
+        switch (frame.type) {
+            case VirtualFrame::CONFIG: {
+                std::lock_guard<std::mutex> lock(configMutex_);
+                if (payload.size() == sizeof(mtu_)) {
+                    std::memcpy(&mtu_, payload.data(), sizeof(mtu_));
+                }
+                configured_ = true;
+                configCv_.notify_all();
+                break;
+            }
+            case VirtualFrame::ONLINE:
+            case VirtualFrame::OFFLINE:
+                NotifyDeviceChange(peer, frame.type == VirtualFrame::ONLINE ? DeviceChangeType::DEVICE_ONLINE
+                                                                            : DeviceChangeType::DEVICE_OFFLINE);
+                break;
+            case VirtualFrame::DATA: {
+                std::string pipeId(frame.pipe, strnlen(frame.pipe, VirtualFrame::ID_SIZE));
+                std::lock_guard<std::mutex> lock(listenerMutex_);
+                auto it = dataListeners_.find(pipeId);
+                if (it == dataListeners_.end()) {
+                    LOG_WARN("no listener %{public}s.", pipeId.c_str());
+                    break;
+                }
+                DeviceInfo deviceInfo = { peer, "", "" };
+                it->second->OnMessage(deviceInfo, payload.data(), static_cast<int>(payload.size()), { pipeId });
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    // never leave the constructor waiting on a network that went away
+    std::lock_guard<std::mutex> lock(configMutex_);
+    configured_ = true;
+    configCv_.notify_all();
+}
+
+void VirtualCommunicationProvider::NotifyDeviceChange(const std::string &deviceId, DeviceChangeType type)
+{
+    DeviceInfo info = { deviceId, deviceId, DEVICE_TYPE };
+    {
+        std::lock_guard<std::mutex> lock(deviceMutex_);
+        if (type == DeviceChangeType::DEVICE_ONLINE) {
+            onlineDevices_.insert(deviceId);
+        } else {
+            onlineDevices_.erase(deviceId);
+        }
+    }
+    if (type == DeviceChangeType::DEVICE_ONLINE) {
+        LinkProfileManager::GetInstance().OnDeviceOnline(info);
+    } else {
+        LinkProfileManager::GetInstance().OnDeviceOffline(deviceId);
+    }
+    std::vector<const AppDeviceStatusChangeListener *> listeners;
+    {
+        std::lock_guard<std::mutex> lock(deviceChangeMutex_);
+        listeners.assign(deviceListeners_.begin(), deviceListeners_.end());
+    }
+    std::stable_sort(listeners.begin(), listeners.end(), [](const auto *left, const auto *right) {
+        return static_cast<int>(left->GetChangeLevelType()) < static_cast<int>(right->GetChangeLevelType());
+    });
+    for (const auto *listener : listeners) {
+        listener->OnDeviceChanged(info, type);
+    }
+}
+} // namespace OHOS::ObjectStore
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VIRTUAL_COMMUNICATION_PROVIDER_H
+#define VIRTUAL_COMMUNICATION_PROVIDER_H
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "communication_provider.h"
+#include "macro.h"
+
+namespace OHOS::ObjectStore {
+// CommunicationProvider of one simulated device, stands in for SoftBusAdapter and talks to the
+// VirtualNetwork over fd. Device events and send results feed LinkProfileManager like the real
+// transport, so a small network mtu shrinks the frames DistributedDB hands out.
+class VirtualCommunicationProvider : public CommunicationProvider {
+public:
+    static constexpr const char *DEVICE_TYPE = "VIRTUAL";
+
+    // blocks until the network has answered with its configuration
+    VirtualCommunicationProvider(const std::string &deviceId, int fd);
+    ~VirtualCommunicationProvider() override;
+    DISABLE_COPY_AND_MOVE(VirtualCommunicationProvider);
+
+    Status StartWatchDeviceChange(const AppDeviceStatusChangeListener *observer, const PipeInfo &pipeInfo) override;
+    Status StopWatchDeviceChange(const AppDeviceStatusChangeListener *observer, const PipeInfo &pipeInfo) override;
+    Status StartWatchDataChange(const AppDataChangeListener *observer, const PipeInfo &pipeInfo) override;
+    Status StopWatchDataChange(const AppDataChangeListener *observer, const PipeInfo &pipeInfo) override;
+    Status SendData(const PipeInfo &pipeInfo, const DeviceId &deviceId, const uint8_t *ptr, int size,
+        const MessageInfo &info) override;
+    std::vector<DeviceInfo> GetDeviceList() const override;
+    DeviceInfo GetLocalDevice() const override;
+    Status Start(const PipeInfo &pipeInfo) override;
+    Status Stop(const PipeInfo &pipeInfo) override;
+    bool IsSameStartedOnPeer(const PipeInfo &pipeInfo, const DeviceId &peer) const override;
+
+private:
+    void ReceiveLoop();
+    void NotifyDeviceChange(const std::string &deviceId, DeviceChangeType type);
+    bool WriteFrame(uint32_t type, const std::string &deviceId, const std::string &pipeId, const uint8_t *ptr,
+        uint32_t size);
+
+    const std::string localDeviceId_;
+    const int fd_;
+    std::mutex writeMutex_ {};
+    std::mutex configMutex_ {};
+    std::condition_variable configCv_ {};
+    bool configured_ = false;
+    uint32_t mtu_ = 0;
+    std::mutex listenerMutex_ {};
+    std::map<std::string, const AppDataChangeListener *> dataListeners_ {};
+    std::mutex deviceChangeMutex_ {};
+    std::set<const AppDeviceStatusChangeListener *> deviceListeners_ {};
+    mutable std::mutex deviceMutex_ {};
+    std::set<std::string> onlineDevices_ {};
+    std::thread reader_;
+};
+} // namespace OHOS::ObjectStore
+#endif // VIRTUAL_COMMUNICATION_PROVIDER_H
@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "virtual_network.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace OHOS::ObjectStore {
+namespace {
+constexpr uint32_t MAX_PAYLOAD_SIZE = 64 * 1024 * 1024;
+constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+void CopyId(char (&dst)[VirtualFrame::ID_SIZE], const std::string &src)
+{
+    size_t size = std::min(src.size(), static_cast<size_t>(VirtualFrame::ID_SIZE - 1));
+    std::memcpy(dst, src.data(), size);
+    dst[size] = '\0';
+}
+
+std::string ToId(const char (&src)[VirtualFrame::ID_SIZE])
+{
+    return std::string(src, strnlen(src, VirtualFrame::ID_SIZE));
+}
+} // namespace
+
+bool VirtualFrame::Read(int fd, void *buf, size_t size)
+{
+    auto *pos = static_cast<uint8_t *>(buf);
+    while (size > 0) {
+        ssize_t ret = recv(fd, pos, size, 0);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return false;
+        }
+        pos += ret;
+        size -= static_cast<size_t>(ret);
+    }
+    return true;
+}
+
+bool VirtualFrame::Write(int fd, const VirtualFrame &header, const uint8_t *payload)
+{
+    struct iovec iov[] = { { const_cast<VirtualFrame *>(&header), sizeof(header) },
+        { const_cast<uint8_t *>(payload), payload == nullptr ? 0 : header.size } };
+    struct iovec *pos = iov;
+    int count = payload == nullptr || header.size == 0 ? 1 : 2;
+    while (count > 0) {
+        struct msghdr msg = {};
+        msg.msg_iov = pos;
+        msg.msg_iovlen = static_cast<size_t>(count);
+        ssize_t ret = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret < 0) {
+            return false;
+        }
+        auto sent = static_cast<size_t>(ret);
+        while (count > 0 && sent >= pos->iov_len) {
+            sent -= pos->iov_len;
+            pos++;
+            count--;
+        }
+        if (count > 0) {
+            pos->iov_base = static_cast<uint8_t *>(pos->iov_base) + sent;
+            pos->iov_len -= sent;
+        }
+    }
+    return true;
+}
+
+VirtualNetwork::VirtualNetwork(const LinkConfig &config, uint32_t seed) : config_(config), random_(seed)
+{
+}
+
+VirtualNetwork::~VirtualNetwork()
+{
+    Stop();
+    for (auto &device : devices_) {
+        if (device.fd >= 0) {
+            close(device.fd);
+        }
+    }
+}
+
+void VirtualNetwork::AddDevice(const std::string &deviceId, int fd)
+{
+    Device device;
+    device.id = deviceId;
+    device.fd = fd;
+    devices_.push_back(std::move(device));
+    for (auto &item : devices_) {
+        item.busyUntil.resize(devices_.size());
+    }
+}
+
+bool VirtualNetwork::Start()
+{
+    if (worker_.joinable() || pipe2(wakeFd_, O_CLOEXEC) != 0) {
+        return false;
+    }
+    stopped_ = false;
+    worker_ = std::thread([this]() { Loop(); });
+    return true;
+}
+
+void VirtualNetwork::Stop()
+{
+    if (!worker_.joinable()) {
+        return;
+    }
+    stopped_ = true;
+    uint8_t wake = 0;
+    while (write(wakeFd_[1], &wake, sizeof(wake)) < 0 && errno == EINTR) {
+    }
+    worker_.join();
+    close(wakeFd_[0]);
+    close(wakeFd_[1]);
+    wakeFd_[0] = wakeFd_[1] = -1;
+}
+
+void VirtualNetwork::SetOnline(const std::string &deviceId, bool online)
+{
+    {
+        std::lock_guard<std::mutex> lock(commandMutex_);
+        commands_.emplace_back(deviceId, online);
+    }
+    uint8_t wake = 0;
+    while (write(wakeFd_[1], &wake, sizeof(wake)) < 0 && errno == EINTR) {
+    }
+}
+
+NetworkStatistics VirtualNetwork::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(statisticsMutex_);
+    return statistics_;
+}
+
+size_t VirtualNetwork::Find(const std::string &deviceId) const
+{
+    for (size_t i = 0; i < devices_.size(); i++) {
+        if (devices_[i].id == deviceId) {
+            return i;
+        }
+    }
+    return NOT_FOUND;
+}
+
+void VirtualNetwork::Loop()
+{
+    // slot 0 wakes the loop up for commands and Stop, slot i + 1 is device i
+    std::vector<struct pollfd> fds = { { wakeFd_[0], POLLIN, 0 } };
+    for (auto &device : devices_) {
+        fds.push_back({ device.fd, POLLIN, 0 });
+    }
+    while (!stopped_) {
+        int timeout = -1;
+        if (!pending_.empty()) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(pending_.top().due - Clock::now());
+            // poll rounds down, wake up a millisecond late rather than spin
+            timeout = static_cast<int>(std::max<int64_t>(0, wait.count() + 1));
+        }
+        if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) {
+            break;
+        }
+        if ((fds[0].revents & POLLIN) != 0) {
+            uint8_t buf[64];
+            while (read(wakeFd_[0], buf, sizeof(buf)) < 0 && errno == EINTR) {
+            }
+            ApplyCommands();
+        }
+        for (size_t i = 1; i < fds.size(); i++) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            if ((fds[i].revents & POLLIN) == 0 || !Receive(i - 1)) {
+                // the device has gone, stop polling it
+                fds[i].fd = -1;
+                devices_[i - 1].connected = false;
+            }
+        }
+        Deliver(Clock::now());
+    }
+}
+
+void VirtualNetwork::ApplyCommands()
+{
+    std::vector<std::pair<std::string, bool>> commands;
+    {
+        std::lock_guard<std::mutex> lock(commandMutex_);
+        commands.swap(commands_);
+    }
+    for (auto &[deviceId, online] : commands) {
+        size_t index = Find(deviceId);
+        if (index != NOT_FOUND) {
+            ChangeOnline(index, online);
+        }
+    }
+}
+
+bool VirtualNetwork::Receive(size_t index)
+{
+    VirtualFrame header;
+    if (!VirtualFrame::Read(devices_[index].fd, &header, sizeof(header)) || header.size > MAX_PAYLOAD_SIZE) {
+        return false;
+    }
+    std::vector<uint8_t> payload(header.size);
+    if (!VirtualFrame::Read(devices_[index].fd, payload.data(), payload.size())) {
+        return false;
+    }
+    switch (header.type) {
+        case VirtualFrame::HELLO:
+            Connect(index);
+            break;
+        case VirtualFrame::DATA:
+            Route(index, header, std::move(payload));
+            break;
+        case VirtualFrame::REJECTED: {
+            std::lock_guard<std::mutex> lock(statisticsMutex_);
+            statistics_.rejectedFrames++;
+            break;
+        }
+        default:
+            break;
+    }
+    return true;
+}
+
+void VirtualNetwork::Connect(size_t index)
+{
+    Device &device = devices_[index];
+    VirtualFrame config;
+    config.type = VirtualFrame::CONFIG;
+    config.size = sizeof(config_.mtu);
+    CopyId(config.device, device.id);
+    VirtualFrame::Write(device.fd, config, reinterpret_cast<const uint8_t *>(&config_.mtu));
+    device.connected = true;
+    if (!device.online) {
+        return;
+    }
+    for (size_t peer = 0; peer < devices_.size(); peer++) {
+        if (peer != index && devices_[peer].connected && devices_[peer].online) {
+            Notify(index, peer, true);
+            Notify(peer, index, true);
+        }
+    }
+}
+
+void VirtualNetwork::ChangeOnline(size_t index, bool online)
+{
+    Device &device = devices_[index];
+    if (device.online == online) {
+        return;
+    }
+    device.online = online;
+    if (!device.connected) {
+        return;
+    }
+    for (size_t peer = 0; peer < devices_.size(); peer++) {
+        if (peer != index && devices_[peer].connected && devices_[peer].online) {
+            Notify(index, peer, online);
+            Notify(peer, index, online);
+        }
+    }
+}
+
+void VirtualNetwork::Notify(size_t to, size_t peer, bool online)
+{
+    VirtualFrame frame;
+    frame.type = online ? VirtualFrame::ONLINE : VirtualFrame::OFFLINE;
+    CopyId(frame.device, devices_[peer].id);
+    VirtualFrame::Write(devices_[to].fd, frame, nullptr);
+}
+
+void VirtualNetwork::Route(size_t from, const VirtualFrame &header, std::vector<uint8_t> &&payload)
+{
+    size_t to = Find(ToId(header.device));
+    if (to == NOT_FOUND || !devices_[from].online || !devices_[to].online) {
+        std::lock_guard<std::mutex> lock(statisticsMutex_);
+        statistics_.offlineFrames++;
+        return;
+    }
+    if (config_.loss > 0 && std::uniform_real_distribution<double>(0, 1)(random_) < config_.loss) {
+        std::lock_guard<std::mutex> lock(statisticsMutex_);
+        statistics_.lostFrames++;
+        return;
+    }
+    // frames queue behind each other on the link, then all of them fly for the latency
+    auto now = Clock::now();
+    auto &busyUntil = devices_[from].busyUntil[to];
+    auto start = std::max(now, busyUntil);
+    if (config_.bandwidth > 0) {
+        busyUntil = start + std::chrono::microseconds(payload.size() * std::micro::den / config_.bandwidth);
+    } else {
+        busyUntil = start;
+    }
+    Pending pending;
+    pending.due = busyUntil + config_.latency;
+    pending.sequence = sequence_++;
+    pending.from = from;
+    pending.to = to;
+    pending.payload = std::move(payload);
+    pending.pipe = ToId(header.pipe);
+    pending_.push(std::move(pending));
+}
+
+void VirtualNetwork::Deliver(Clock::time_point now)
+{
+    while (!pending_.empty() && pending_.top().due <= now) {
+        const Pending &pending = pending_.top();
+        const Device &from = devices_[pending.from];
+        const Device &to = devices_[pending.to];
+        bool delivered = false;
+        // a device going offline loses what is still on the way
+        if (from.online && to.online && to.connected) {
+            VirtualFrame frame;
+            frame.type = VirtualFrame::DATA;
+            frame.size = static_cast<uint32_t>(pending.payload.size());
+            CopyId(frame.device, from.id);
+            CopyId(frame.pipe, pending.pipe);
+            delivered = VirtualFrame::Write(to.fd, frame, pending.payload.data());
+        }
+        {
+            std::lock_guard<std::mutex> lock(statisticsMutex_);
+            if (delivered) {
+                statistics_.frames++;
+                statistics_.bytes += pending.payload.size();
+            } else {
+                statistics_.offlineFrames++;
+            }
+        }
+        pending_.pop();
+    }
+}
+} // namespace OHOS::ObjectStore
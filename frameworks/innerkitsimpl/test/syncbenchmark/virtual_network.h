@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VIRTUAL_NETWORK_H
+#define VIRTUAL_NETWORK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "macro.h"
+
+namespace OHOS::ObjectStore {
+// Header of every message between a simulated device and the network, the payload follows it.
+struct VirtualFrame {
+    enum Type : uint32_t {
+        HELLO = 0,  // device -> network, device is the id of the sender
+        CONFIG,     // network -> device, payload is the mtu as uint32_t
+        DATA,       // device is the destination when sent and the source when delivered
+        ONLINE,     // network -> device, device is the peer
+        OFFLINE,
+        REJECTED,   // device -> network, a frame over the mtu was refused by the sender
+    };
+    static constexpr uint32_t ID_SIZE = 64;
+    uint32_t type = HELLO;
+    uint32_t size = 0;
+    char device[ID_SIZE] = { 0 };
+    char pipe[ID_SIZE] = { 0 };
+
+    static bool Read(int fd, void *buf, size_t size);
+    static bool Write(int fd, const VirtualFrame &header, const uint8_t *payload);
+};
+
+// Same for every link of the network.
+struct LinkConfig {
+    std::chrono::microseconds latency { 0 };
+    uint64_t bandwidth = 0;  // bytes per second of each direction of a link, 0 for unlimited
+    double loss = 0;         // probability a data frame is lost on the way
+    uint32_t mtu = 0;        // largest frame a device may send, 0 for unlimited
+};
+
+struct NetworkStatistics {
+    uint64_t frames = 0;         // data frames delivered
+    uint64_t bytes = 0;          // payload bytes delivered
+    uint64_t lostFrames = 0;     // dropped by the loss rate
+    uint64_t offlineFrames = 0;  // dropped because one end was offline
+    uint64_t rejectedFrames = 0; // refused by the sender for being over the mtu
+};
+
+// Switch between simulated devices, each connected by one stream socket. Data frames are delayed by the
+// serialization time of the link and its latency, in order per link, and lost at the configured rate.
+class VirtualNetwork {
+public:
+    VirtualNetwork(const LinkConfig &config, uint32_t seed);
+    ~VirtualNetwork();
+    DISABLE_COPY_AND_MOVE(VirtualNetwork);
+
+    // fd is the network end of the device socket, the network closes it; only before Start
+    void AddDevice(const std::string &deviceId, int fd);
+    bool Start();
+    void Stop();
+    // an offline device and its peers are told about each other, frames from or to it are dropped
+    void SetOnline(const std::string &deviceId, bool online);
+    NetworkStatistics GetStatistics() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Device {
+        std::string id;
+        int fd = -1;
+        bool connected = false;
+        bool online = true;
+        std::vector<Clock::time_point> busyUntil;  // per destination, the link is sending until then
+    };
+    struct Pending {
+        Clock::time_point due;
+        uint64_t sequence = 0;
+        size_t from = 0;
+        size_t to = 0;
+        std::vector<uint8_t> payload;
+        std::string pipe;
+        bool operator>(const Pending &other) const
+        {
+            return due != other.due ? due > other.due : sequence > other.sequence;
+        }
+    };
+
+    void Loop();
+    void ApplyCommands();
+    bool Receive(size_t index);
+    void Route(size_t from, const VirtualFrame &header, std::vector<uint8_t> &&payload);
+    void Deliver(Clock::time_point now);
+    void Notify(size_t to, size_t peer, bool online);
+    void Connect(size_t index);
+    void ChangeOnline(size_t index, bool online);
+    size_t Find(const std::string &deviceId) const;
+
+    const LinkConfig config_;
+    std::mt19937 random_;
+    std::vector<Device> devices_ {};
+    std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> pending_ {};
+    uint64_t sequence_ = 0;
+    int wakeFd_[2] = { -1, -1 };
+    std::thread worker_;
+    std::mutex commandMutex_ {};
+    std::vector<std::pair<std::string, bool>> commands_ {};
+    std::atomic<bool> stopped_ { false };
+    mutable std::mutex statisticsMutex_ {};
+    NetworkStatistics statistics_ {};
+};
+} // namespace OHOS::ObjectStore
+#endif // VIRTUAL_NETWORK_H
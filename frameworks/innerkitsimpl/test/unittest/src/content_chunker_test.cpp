@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <random>
+#include <set>
+
+#include "content_chunker.h"
+
+using namespace testing::ext;
+using namespace OHOS::ObjectStore;
+
+namespace {
+std::vector<uint8_t> RandomBytes(size_t size, uint32_t seed)
+{
+    std::mt19937 engine(seed);
+    std::vector<uint8_t> data(size);
+    for (uint8_t &byte : data) {
+        byte = static_cast<uint8_t>(engine());
+    }
+    return data;
+}
+
+std::set<std::string> Digests(const std::vector<uint8_t> &data)
+{
+    std::set<std::string> digests;
+    size_t offset = 0;
+    for (size_t length : ContentChunker::Split(data.data(), data.size())) {
+        digests.insert(ContentChunker::ToHex(ContentChunker::Hash(data.data() + offset, length)));
+        offset += length;
+    }
+    return digests;
+}
+} // namespace
+
+class ContentChunkerTest : public testing::Test {
+};
+
+/**
+ * @tc.name: Split001
+ * @tc.desc: the chunks cover the value, stay within the size limits and are cut the same way every time
+ * @tc.type: FUNC
+ */
+HWTEST_F(ContentChunkerTest, Split001, TestSize.Level1)
+{
+    std::vector<uint8_t> data = RandomBytes(1024 * 1024, 1);
+    std::vector<size_t> lengths = ContentChunker::Split(data.data(), data.size());
+    ASSERT_GT(lengths.size(), 1u);
+    EXPECT_EQ(std::accumulate(lengths.begin(), lengths.end(), size_t(0)), data.size());
+    for (size_t i = 0; i < lengths.size(); i++) {
+        EXPECT_LE(lengths[i], ContentChunker::MAX_SIZE);
+        if (i + 1 < lengths.size()) {
+            EXPECT_GT(lengths[i], ContentChunker::MIN_SIZE);
+        }
+    }
+    EXPECT_EQ(ContentChunker::Split(data.data(), data.size()), lengths);
+}
+
+/**
+ * @tc.name: Split002
+ * @tc.desc: values up to the minimum size are one chunk, an empty value has none
+ * @tc.type: FUNC
+ */
+HWTEST_F(ContentChunkerTest, Split002, TestSize.Level1)
+{
+    std::vector<uint8_t> data = RandomBytes(ContentChunker::MIN_SIZE, 2);
+    EXPECT_EQ(ContentChunker::Split(data.data(), data.size()), std::vector<size_t> { data.size() });
+    EXPECT_TRUE(ContentChunker::Split(data.data(), 0).empty());
+}
+
+/**
+ * @tc.name: Split003
+ * @tc.desc: bytes inserted in the middle change only the chunks around them, the others keep their digest
+ * @tc.type: FUNC
+ */
+HWTEST_F(ContentChunkerTest, Split003, TestSize.Level1)
+{
+    std::vector<uint8_t> data = RandomBytes(1024 * 1024, 3);
+    std::set<std::string> before = Digests(data);
+    data.insert(data.begin() + data.size() / 2, 50, 1);
+    std::set<std::string> after = Digests(data);
+    size_t kept = 0;
+    for (const std::string &digest : after) {
+        kept += before.count(digest);
+    }
+    EXPECT_GE(kept + 3, after.size());
+}
+
+/**
+ * @tc.name: Hash001
+ * @tc.desc: the digest is the start of the sha-256 of the bytes
+ * @tc.type: FUNC
+ */
+HWTEST_F(ContentChunkerTest, Hash001, TestSize.Level1)
+{
+    const uint8_t abc[] = { 'a', 'b', 'c' };
+    EXPECT_EQ(ContentChunker::ToHex(ContentChunker::Hash(abc, sizeof(abc))), "ba7816bf8f01cfea414140de5dae2223");
+    EXPECT_EQ(ContentChunker::ToHex(ContentChunker::Hash(abc, 0)), "e3b0c44298fc1c149afbf4c8996fb924");
+    // the length in bits does not fit the last block, the padding takes a second one
+    std::vector<uint8_t> data(56, 'a');
+    EXPECT_EQ(ContentChunker::ToHex(ContentChunker::Hash(data.data(), data.size())),
+        "b35439a4ac6f0948b6d6f9e3c6af0f5f");
+}
@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "distributed_object_impl.h"
+#include "field_codec.h"
+#include "flat_object_store.h"
+#include "mock_object_storage_engine.h"
+#include "objectstore_errors.h"
+#include "peer_capabilities.h"
+
+using namespace testing::ext;
+using namespace OHOS::ObjectStore;
+
+namespace {
+const std::string BUNDLE_NAME = "com.example.objectstore.test";
+const std::string SESSION_ID = "session";
+const std::string PEER = "peer";
+const std::string OLD_PEER = "oldPeer";
+constexpr size_t LARGE_SIZE = 1024 * 1024;
+
+std::vector<uint8_t> RandomBytes(size_t size, uint32_t seed)
+{
+    std::mt19937 engine(seed);
+    std::vector<uint8_t> data(size);
+    for (uint8_t &byte : data) {
+        byte = static_cast<uint8_t>(engine());
+    }
+    return data;
+}
+} // namespace
+
+class DistributedObjectImplTest : public testing::Test {
+public:
+    void SetUp() override;
+    void TearDown() override;
+
+protected:
+    std::set<std::string> ChunkKeys();
+    Bytes Record(const std::string &key);
+
+    std::shared_ptr<FlatObjectStore> store_;
+    std::shared_ptr<DistributedObjectImpl> object_;
+};
+
+void DistributedObjectImplTest::SetUp()
+{
+    store_ = std::make_shared<FlatObjectStore>(BUNDLE_NAME, std::make_shared<MockObjectStorageEngine>());
+    ASSERT_EQ(store_->CreateObject(SESSION_ID), SUCCESS);
+    object_ = std::make_shared<DistributedObjectImpl>(SESSION_ID, store_.get());
+}
+
+void DistributedObjectImplTest::TearDown()
+{
+    PeerCapabilities::GetInstance().OnOffline(PEER);
+    PeerCapabilities::GetInstance().OnOffline(OLD_PEER);
+    object_ = nullptr;
+    store_->Delete(SESSION_ID);
+    store_ = nullptr;
+}
+
+std::set<std::string> DistributedObjectImplTest::ChunkKeys()
+{
+    std::map<std::string, Bytes> chunks;
+    store_->GetAll(SESSION_ID, CHUNKS_PREFIX, chunks);
+    std::set<std::string> keys;
+    for (auto &item : chunks) {
+        keys.insert(item.first);
+    }
+    return keys;
+}
+
+// the stored record of field key, a manifest for a chunked value
+Bytes DistributedObjectImplTest::Record(const std::string &key)
+{
+    std::string sessionId = SESSION_ID;
+    Bytes record;
+    store_->Get(sessionId, FIELDS_PREFIX + key, record);
+    return record;
+}
+
+/**
+ * @tc.name: Chunk001
+ * @tc.desc: with no peer online a large complex value is stored in one piece
+ * @tc.type: FUNC
+ */
+HWTEST_F(DistributedObjectImplTest, Chunk001, TestSize.Level1)
+{
+    std::vector<uint8_t> data = RandomBytes(LARGE_SIZE, 1);
+    ASSERT_EQ(object_->PutComplex("doc", data), SUCCESS);
+    EXPECT_TRUE(ChunkKeys().empty());
+    EXPECT_EQ(Record("doc").size(), sizeof(Type) + data.size());
+    std::vector<uint8_t> value;
+    ASSERT_EQ(object_->GetComplex("doc", value), SUCCESS);
+    EXPECT_EQ(value, data);
+}
+
+/**
+ * @tc.name: Chunk002
+ * @tc.desc: while every peer assembles manifests a large value is stored as chunks and reads back whole
+ * @tc.type: FUNC
+ */
+HWTEST_F(DistributedObjectImplTest, Chunk002, TestSize.Level1)
+{
+    PeerCapabilities::GetInstance().OnHello(PEER, PeerCapabilities::LOCAL);
+    std::vector<uint8_t> data = RandomBytes(LARGE_SIZE, 2);
+    ASSERT_EQ(object_->PutComplex("doc", data), SUCCESS);
+    EXPECT_GT(ChunkKeys().size(), 1u);
+    EXPECT_LT(Record("doc").size(), DistributedObjectImpl::CHUNK_THRESHOLD);
+    std::vector<uint8_t> value;
+    ASSERT_EQ(object_->GetComplex("doc", value), SUCCESS);
+    EXPECT_EQ(value, data);
+    Type type = TYPE_STRING;
+    ASSERT_EQ(object_->GetType("doc", type), SUCCESS);
+    EXPECT_EQ(type, TYPE_COMPLEX);
+    std::map<std::string, FieldValue> fields;
+    ASSERT_EQ(object_->GetAll(fields), SUCCESS);
+    ASSERT_EQ(fields.size(), 1u);
+    EXPECT_EQ(std::get<std::vector<uint8_t>>(fields["doc"]), data);
+}
+
+/**
+ * @tc.name: Chunk003
+ * @tc.desc: one online peer without the capability keeps large values in one piece
+ * @tc.type: FUNC
+ */
+HWTEST_F(DistributedObjectImplTest, Chunk003, TestSize.Level1)
+{
+    PeerCapabilities::GetInstance().OnHello(PEER, PeerCapabilities::LOCAL);
+    PeerCapabilities::GetInstance().OnOnline(OLD_PEER);
+    ASSERT_EQ(object_->PutComplex("doc", RandomBytes(LARGE_SIZE, 3)), SUCCESS);
+    std::map<std::string, FieldValue> batch { { "list", RandomBytes(LARGE_SIZE, 4) } };
+    ASSERT_EQ(object_->PutBatch(batch), SUCCESS);
+    EXPECT_TRUE(ChunkKeys().empty());
+}
+
+/**
+ * @tc.name: Chunk004
+ * @tc.desc: an edit writes only the chunks it changed, a copy of a value writes none
+ * @tc.type: FUNC
+ */
+HWTEST_F(DistributedObjectImplTest, Chunk004, TestSize.Level1)
+{
+    PeerCapabilities::GetInstance().OnHello(PEER, PeerCapabilities::LOCAL);
+    std::vector<uint8_t> data = RandomBytes(LARGE_SIZE, 5);
+    ASSERT_EQ(object_->PutComplex("doc", data), SUCCESS);
+    size_t chunkCount = ChunkKeys().size();
+    data.insert(data.begin() + data.size() / 2, 50, 1);
+    ASSERT_EQ(object_->PutComplex("doc", data), SUCCESS);
+    size_t editedCount = ChunkKeys().size();
+    EXPECT_GT(editedCount, chunkCount);
+    EXPECT_LE(editedCount, chunkCount + 3);
+    ASSERT_EQ(object_->PutComplex("copy", data), SUCCESS);
+    EXPECT_EQ(ChunkKeys().size(), editedCount);
+    std::vector<uint8_t> value;
+    ASSERT_EQ(object_->GetComplex("copy", value), SUCCESS);
+    EXPECT_EQ(value, data);
+}
+
+/**
+ * @tc.name: Chunk005
+ * @tc.desc: a rewritten field keeps its old chunks, a manifest still syncing from a peer assembles
+ * @tc.type: FUNC
+ */
+HWTEST_F(DistributedObjectImplTest, Chunk005, TestSize.Level1)
+{
+    PeerCapabilities::GetInstance().OnHello(PEER, PeerCapabilities::LOCAL);
+    std::vector<uint8_t> first = RandomBytes(LARGE_SIZE, 6);
+    ASSERT_EQ(object_->PutComplex("doc", first), SUCCESS);
+    Bytes firstManifest = Record("doc");
+    std::set<std::string> firstChunks = ChunkKeys();
+    ASSERT_EQ(object_->PutComplex("doc", RandomBytes(LARGE_SIZE, 7)), SUCCESS);
+    std::set<std::string> chunks = ChunkKeys();
+    for (const std::string &chunk : firstChunks) {
+        EXPECT_EQ(chunks.count(chunk), 1u);
+    }
+    // the older manifest arrives from a peer after the local rewrite
+    ASSERT_EQ(store_->Put(SESSION_ID, FIELDS_PREFIX + std::string("doc"), firstManifest), SUCCESS);
+    std::vector<uint8_t> value;
+    ASSERT_EQ(object_->GetComplex("doc", value), SUCCESS);
+    EXPECT_EQ(value, first);
+}
+
+/**
+ * @tc.name: Codec001
+ * @tc.desc: Put and Get of every codec round trip, a field of another type is ERR_DATA_LEN
+ * @tc.type: FUNC
+ */
+HWTEST_F(DistributedObjectImplTest, Codec001, TestSize.Level1)
+{
+    ASSERT_EQ(Put(*object_, "name", std::string("Amy")), SUCCESS);
+    ASSERT_EQ(Put(*object_, "isVis", true), SUCCESS);
+    ASSERT_EQ(Put(*object_, "score", 0.25), SUCCESS);
+    ASSERT_EQ(Put(*object_, "time", int64_t(1650000000000)), SUCCESS);
+    ASSERT_EQ(Put(*object_, "image", std::vector<uint8_t> { 1, 2, 3 }), SUCCESS);
+    std::string name;
+    bool isVis = false;
+    double score = 0;
+    int64_t time = 0;
+    std::vector<uint8_t> image;
+    ASSERT_EQ(Get(*object_, "name", name), SUCCESS);
+    ASSERT_EQ(Get(*object_, "isVis", isVis), SUCCESS);
+    ASSERT_EQ(Get(*object_, "score", score), SUCCESS);
+    ASSERT_EQ(Get(*object_, "time", time), SUCCESS);
+    ASSERT_EQ(Get(*object_, "image", image), SUCCESS);
+    EXPECT_EQ(name, "Amy");
+    EXPECT_TRUE(isVis);
+    EXPECT_EQ(score, 0.25);
+    EXPECT_EQ(time, 1650000000000);
+    EXPECT_EQ(image, (std::vector<uint8_t> { 1, 2, 3 }));
+    // JS reads these as they are, the bytes are the ones of the typed puts
+    double number = 0;
+    ASSERT_EQ(object_->GetDouble("time", number), SUCCESS);
+    EXPECT_EQ(number, 1650000000000.0);
+    EXPECT_EQ(Get(*object_, "name", score), ERR_DATA_LEN);
+    EXPECT_EQ(Get(*object_, "score", time), ERR_DATA_LEN);
+    EXPECT_EQ(Get(*object_, "name", image), ERR_DATA_LEN);
+    EXPECT_EQ(Put(*object_, "time", (int64_t(1) << 53) + 1), ERR_DATA_LEN);
+}
+
+/**
+ * @tc.name: Codec002
+ * @tc.desc: a complex value read in place starts at the offset, stored in one piece or as chunks
+ * @tc.type: FUNC
+ */
+HWTEST_F(DistributedObjectImplTest, Codec002, TestSize.Level1)
+{
+    std::vector<uint8_t> data = RandomBytes(LARGE_SIZE, 8);
+    ASSERT_EQ(Put(*object_, "plain", data), SUCCESS);
+    PeerCapabilities::GetInstance().OnHello(PEER, PeerCapabilities::LOCAL);
+    ASSERT_EQ(Put(*object_, "chunked", data), SUCCESS);
+    for (const auto &key : { "plain", "chunked" }) {
+        std::vector<uint8_t> value;
+        size_t offset = 0;
+        ASSERT_EQ(Get(*object_, key, value, offset), SUCCESS);
+        ASSERT_EQ(value.size() - offset, data.size());
+        EXPECT_TRUE(std::equal(data.begin(), data.end(), value.begin() + offset));
+        ASSERT_EQ(Get(*object_, key, value), SUCCESS);
+        EXPECT_EQ(value, data);
+    }
+}
+
+/**
+ * @tc.name: PutBatch001
+ * @tc.desc: the puts and deletes of one batch land together, a field not stored deletes fine
+ * @tc.type: FUNC
+ */
+HWTEST_F(DistributedObjectImplTest, PutBatch001, TestSize.Level1)
+{
+    ASSERT_EQ(object_->PutString("list/0", "a"), SUCCESS);
+    ASSERT_EQ(object_->PutString("list/1", "b"), SUCCESS);
+    std::map<std::string, FieldValue> batch { { "list/0", std::string("c") } };
+    ASSERT_EQ(object_->PutBatch(batch, { "list/1", "list/2" }), SUCCESS);
+    std::map<std::string, FieldValue> fields;
+    ASSERT_EQ(object_->GetAll(fields), SUCCESS);
+    ASSERT_EQ(fields.size(), 1u);
+    EXPECT_EQ(std::get<std::string>(fields["list/0"]), "c");
+}
+
+/**
+ * @tc.name: GetAll001
+ * @tc.desc: a prefix read returns only the fields under it, a chunked one among them whole
+ * @tc.type: FUNC
+ */
+HWTEST_F(DistributedObjectImplTest, GetAll001, TestSize.Level1)
+{
+    PeerCapabilities::GetInstance().OnHello(PEER, PeerCapabilities::LOCAL);
+    std::vector<uint8_t> data = RandomBytes(LARGE_SIZE, 6);
+    ASSERT_EQ(object_->PutComplex("doc/0", data), SUCCESS);
+    ASSERT_FALSE(ChunkKeys().empty());
+    ASSERT_EQ(object_->PutString("doc/1", "a"), SUCCESS);
+    ASSERT_EQ(object_->PutString("docs", "b"), SUCCESS);
+    ASSERT_EQ(object_->PutComplex("other", data), SUCCESS);
+    std::map<std::string, FieldValue> fields;
+    ASSERT_EQ(object_->GetAll("doc/", fields), SUCCESS);
+    ASSERT_EQ(fields.size(), 2u);
+    EXPECT_EQ(std::get<std::vector<uint8_t>>(fields["doc/0"]), data);
+    EXPECT_EQ(std::get<std::string>(fields["doc/1"]), "a");
+    fields.clear();
+    ASSERT_EQ(object_->GetAll(fields), SUCCESS);
+    EXPECT_EQ(fields.size(), 4u);
+}
+
+/**
+ * @tc.name: Chunk006
+ * @tc.desc: a peer coming online after a value was chunked is not synced until its hello shows it reads chunks
+ * @tc.type: FUNC
+ */
+HWTEST_F(DistributedObjectImplTest, Chunk006, TestSize.Level1)
+{
+    PeerCapabilities &capabilities = PeerCapabilities::GetInstance();
+    capabilities.OnHello(PEER, PeerCapabilities::LOCAL);
+    ASSERT_EQ(object_->PutComplex("doc", RandomBytes(LARGE_SIZE, 7)), SUCCESS);
+    // what the storage engine does for every record it keeps
+    std::map<std::string, Bytes> records;
+    ASSERT_EQ(store_->GetAll(SESSION_ID, "", records), SUCCESS);
+    for (const auto &[key, record] : records) {
+        capabilities.OnStored(key, record);
+    }
+    ASSERT_EQ(capabilities.GetStored() & PeerCapabilities::CHUNKED_VALUES, PeerCapabilities::CHUNKED_VALUES);
+    EXPECT_TRUE(capabilities.CanSync(PEER));
+
+    capabilities.OnOnline(OLD_PEER);
+    EXPECT_FALSE(capabilities.CanSync(OLD_PEER));
+    EXPECT_FALSE(capabilities.OnHello(OLD_PEER, PeerCapabilities::TRACE_HEADER));
+    EXPECT_FALSE(capabilities.CanSync(OLD_PEER));
+    // back with a release that reads every stored format
+    capabilities.OnOffline(OLD_PEER);
+    capabilities.OnOnline(OLD_PEER);
+    EXPECT_FALSE(capabilities.CanSync(OLD_PEER));
+    EXPECT_TRUE(capabilities.OnHello(OLD_PEER, PeerCapabilities::LOCAL));
+    EXPECT_TRUE(capabilities.CanSync(OLD_PEER));
+}
+
+/**
+ * @tc.name: Formats001
+ * @tc.desc: chunks, path nodes and binary complex values are told apart from the records every release reads
+ * @tc.type: FUNC
+ */
+HWTEST_F(DistributedObjectImplTest, Formats001, TestSize.Level1)
+{
+    std::string node = "[OBJECT][\"a\"]";
+    Bytes path { TYPE_STRING };
+    path.insert(path.end(), node.begin(), node.end());
+    EXPECT_EQ(PeerCapabilities::FormatsOf("p_doc", path), PeerCapabilities::PATH_FIELDS);
+    EXPECT_EQ(PeerCapabilities::FormatsOf("c_0123", Bytes(16, 1)), PeerCapabilities::CHUNKED_VALUES);
+    EXPECT_EQ(PeerCapabilities::FormatsOf("p_list", Bytes { TYPE_COMPLEX, 0xC5, 1, 0 }),
+        PeerCapabilities::BINARY_COMPLEX);
+    EXPECT_EQ(PeerCapabilities::FormatsOf("p_list", Bytes { TYPE_COMPLEX, 1, 2, 3 }), 0u);
+    EXPECT_EQ(PeerCapabilities::FormatsOf("p_name", Bytes { TYPE_STRING, 'a' }), 0u);
+    EXPECT_EQ(PeerCapabilities::FormatsOf("p_empty", Bytes()), 0u);
+}
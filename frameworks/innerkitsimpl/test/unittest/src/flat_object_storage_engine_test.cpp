@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <thread>
+
+#include "flat_object_storage_engine.h"
+#include "objectstore_errors.h"
+
+using namespace testing::ext;
+using namespace OHOS::ObjectStore;
+
+namespace {
+const std::string BUNDLE_NAME = "com.example.objectstore.test";
+const std::string DATA_DIR = "/data/test/objectstore_unittest";
+// longer than a table has to stay unused before it is evicted
+constexpr std::chrono::seconds EVICT_IDLE = std::chrono::seconds(11);
+
+ObjectOptions Durable()
+{
+    ObjectOptions options;
+    options.durable = true;
+    options.dataDir = DATA_DIR;
+    return options;
+}
+} // namespace
+
+class FlatObjectStorageEngineTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp() override;
+    void TearDown() override;
+
+protected:
+    std::shared_ptr<FlatObjectStorageEngine> engine_;
+};
+
+void FlatObjectStorageEngineTest::SetUpTestCase()
+{
+    std::error_code error;
+    std::filesystem::remove_all(DATA_DIR, error);
+}
+
+void FlatObjectStorageEngineTest::TearDownTestCase()
+{
+    std::error_code error;
+    std::filesystem::remove_all(DATA_DIR, error);
+}
+
+void FlatObjectStorageEngineTest::SetUp()
+{
+    engine_ = std::make_shared<FlatObjectStorageEngine>();
+    ASSERT_EQ(engine_->Open(BUNDLE_NAME), SUCCESS);
+}
+
+void FlatObjectStorageEngineTest::TearDown()
+{
+    if (engine_ != nullptr) {
+        engine_->Close();
+        engine_ = nullptr;
+    }
+}
+
+/**
+ * @tc.name: WriteBehind001
+ * @tc.desc: buffered puts of a durable table read back at once and are on disk after the close
+ * @tc.type: FUNC
+ */
+HWTEST_F(FlatObjectStorageEngineTest, WriteBehind001, TestSize.Level1)
+{
+    ASSERT_EQ(engine_->CreateTable("writeBehind", Durable()), SUCCESS);
+    std::map<std::string, Value> batch;
+    for (int i = 0; i < 100; i++) {
+        batch["p_field" + std::to_string(i)] = Value(16, i);
+    }
+    ASSERT_EQ(engine_->UpdateItems("writeBehind", batch, {}), SUCCESS);
+    ASSERT_EQ(engine_->UpdateItem("writeBehind", "p_name", Value(4, 'a')), SUCCESS);
+    std::map<std::string, Value> items;
+    ASSERT_EQ(engine_->GetTable("writeBehind", items), SUCCESS);
+    EXPECT_EQ(items.size(), batch.size() + 1);
+    Value value;
+    ASSERT_EQ(engine_->GetItem("writeBehind", "p_field99", value), SUCCESS);
+    EXPECT_EQ(value, batch["p_field99"]);
+    ASSERT_EQ(engine_->Close(), SUCCESS);
+
+    engine_ = std::make_shared<FlatObjectStorageEngine>();
+    ASSERT_EQ(engine_->Open(BUNDLE_NAME), SUCCESS);
+    ASSERT_EQ(engine_->CreateTable("writeBehind", Durable()), SUCCESS);
+    items.clear();
+    ASSERT_EQ(engine_->GetTable("writeBehind", items), SUCCESS);
+    EXPECT_EQ(items.size(), batch.size() + 1);
+    EXPECT_EQ(items["p_name"], Value(4, 'a'));
+    ASSERT_EQ(engine_->DeleteTable("writeBehind"), SUCCESS);
+}
+
+/**
+ * @tc.name: WriteBehind002
+ * @tc.desc: the buffered puts of an engine destroyed without a close are on disk
+ * @tc.type: FUNC
+ */
+HWTEST_F(FlatObjectStorageEngineTest, WriteBehind002, TestSize.Level1)
+{
+    ASSERT_EQ(engine_->CreateTable("writeBehindLeft", Durable()), SUCCESS);
+    ASSERT_EQ(engine_->UpdateItem("writeBehindLeft", "p_name", Value(4, 'b')), SUCCESS);
+    engine_ = nullptr;
+
+    engine_ = std::make_shared<FlatObjectStorageEngine>();
+    ASSERT_EQ(engine_->Open(BUNDLE_NAME), SUCCESS);
+    ASSERT_EQ(engine_->CreateTable("writeBehindLeft", Durable()), SUCCESS);
+    Value value;
+    ASSERT_EQ(engine_->GetItem("writeBehindLeft", "p_name", value), SUCCESS);
+    EXPECT_EQ(value, Value(4, 'b'));
+    ASSERT_EQ(engine_->DeleteTable("writeBehindLeft"), SUCCESS);
+}
+
+/**
+ * @tc.name: UpdateItems001
+ * @tc.desc: the puts and deletes of one update land together in memory and durable tables
+ * @tc.type: FUNC
+ */
+HWTEST_F(FlatObjectStorageEngineTest, UpdateItems001, TestSize.Level1)
+{
+    ASSERT_EQ(engine_->CreateTable("memoryUpdate", ObjectOptions()), SUCCESS);
+    ASSERT_EQ(engine_->CreateTable("durableUpdate", Durable()), SUCCESS);
+    for (const auto &table : { "memoryUpdate", "durableUpdate" }) {
+        std::map<std::string, Value> batch { { "p_a", Value(1, 1) }, { "p_b", Value(1, 2) } };
+        ASSERT_EQ(engine_->UpdateItems(table, batch, {}), SUCCESS);
+        // p_c was never stored, deleting it is no error
+        batch = { { "p_b", Value(1, 3) } };
+        ASSERT_EQ(engine_->UpdateItems(table, batch, { "p_a", "p_c" }), SUCCESS);
+        std::map<std::string, Value> items;
+        ASSERT_EQ(engine_->GetTable(table, items), SUCCESS);
+        ASSERT_EQ(items.size(), 1u);
+        EXPECT_EQ(items["p_b"], Value(1, 3));
+        ASSERT_EQ(engine_->DeleteTable(table), SUCCESS);
+    }
+}
+
+/**
+ * @tc.name: UpdateItems002
+ * @tc.desc: updates and deletes larger than the 128 entries KvStoreNbDelegate takes in one batch succeed
+ * @tc.type: FUNC
+ */
+HWTEST_F(FlatObjectStorageEngineTest, UpdateItems002, TestSize.Level1)
+{
+    constexpr int count = 300;
+    ASSERT_EQ(engine_->CreateTable("memoryLarge", ObjectOptions()), SUCCESS);
+    ASSERT_EQ(engine_->CreateTable("durableLarge", Durable()), SUCCESS);
+    for (const auto &table : { "memoryLarge", "durableLarge" }) {
+        std::map<std::string, Value> batch;
+        std::vector<std::string> keys;
+        for (int i = 0; i < count; i++) {
+            batch["p_field" + std::to_string(i)] = Value(8, i);
+            keys.push_back("p_field" + std::to_string(i));
+        }
+        ASSERT_EQ(engine_->UpdateItems(table, batch, {}), SUCCESS);
+        std::map<std::string, Value> items;
+        ASSERT_EQ(engine_->GetTable(table, items), SUCCESS);
+        EXPECT_EQ(items.size(), batch.size());
+
+        // the first half goes with the puts of the rest, the second half on its own
+        std::vector<std::string> half(keys.begin(), keys.begin() + count / 2);
+        batch = { { "p_new", Value(1, 1) } };
+        ASSERT_EQ(engine_->UpdateItems(table, batch, half), SUCCESS);
+        ASSERT_EQ(engine_->DeleteItems(table, std::vector<std::string>(keys.begin() + count / 2, keys.end())),
+            SUCCESS);
+        items.clear();
+        ASSERT_EQ(engine_->GetTable(table, items), SUCCESS);
+        ASSERT_EQ(items.size(), 1u);
+        EXPECT_EQ(items["p_new"], Value(1, 1));
+        ASSERT_EQ(engine_->DeleteTable(table), SUCCESS);
+    }
+}
+
+/**
+ * @tc.name: Evict001
+ * @tc.desc: over the memory budget an idle durable table is evicted and reloads on its next use,
+ *           memory tables stay resident as they have nowhere else to live and are reported as overrun
+ * @tc.type: FUNC
+ */
+HWTEST_F(FlatObjectStorageEngineTest, Evict001, TestSize.Level1)
+{
+    ASSERT_EQ(engine_->CreateTable("memoryEvict", ObjectOptions()), SUCCESS);
+    ASSERT_EQ(engine_->CreateTable("durableEvict", Durable()), SUCCESS);
+    ASSERT_EQ(engine_->UpdateItem("memoryEvict", "p_a", Value(1000, 1)), SUCCESS);
+    ASSERT_EQ(engine_->UpdateItem("durableEvict", "p_a", Value(1000, 2)), SUCCESS);
+    // both tables were just used, nothing can be evicted yet
+    std::map<std::string, SessionStatistics> usage;
+    engine_->GetUsage(usage);
+    EXPECT_EQ(engine_->SetMemoryBudget(1), usage["memoryEvict"].bytes + usage["durableEvict"].bytes - 1);
+    usage.clear();
+    engine_->GetUsage(usage);
+    EXPECT_TRUE(usage["durableEvict"].resident);
+
+    std::this_thread::sleep_for(EVICT_IDLE);
+    EXPECT_EQ(engine_->SetMemoryBudget(1), usage["memoryEvict"].bytes - 1);
+    usage.clear();
+    engine_->GetUsage(usage);
+    EXPECT_TRUE(usage["memoryEvict"].resident);
+    EXPECT_FALSE(usage["durableEvict"].resident);
+
+    Value value;
+    ASSERT_EQ(engine_->GetItem("durableEvict", "p_a", value), SUCCESS);
+    EXPECT_EQ(value, Value(1000, 2));
+    ASSERT_EQ(engine_->GetItem("memoryEvict", "p_a", value), SUCCESS);
+    EXPECT_EQ(value, Value(1000, 1));
+    usage.clear();
+    engine_->GetUsage(usage);
+    EXPECT_TRUE(usage["durableEvict"].resident);
+    EXPECT_EQ(engine_->SetMemoryBudget(0), 0u);
+    ASSERT_EQ(engine_->DeleteTable("memoryEvict"), SUCCESS);
+    ASSERT_EQ(engine_->DeleteTable("durableEvict"), SUCCESS);
+}
+
+/**
+ * @tc.name: Suppress001
+ * @tc.desc: a put of the value an item holds already is skipped and counted, alone or in a batch,
+ *           a different value is written
+ * @tc.type: FUNC
+ */
+HWTEST_F(FlatObjectStorageEngineTest, Suppress001, TestSize.Level1)
+{
+    ASSERT_EQ(engine_->CreateTable("memorySuppress", ObjectOptions()), SUCCESS);
+    ASSERT_EQ(engine_->CreateTable("durableSuppress", Durable()), SUCCESS);
+    for (const auto &table : { "memorySuppress", "durableSuppress" }) {
+        ASSERT_EQ(engine_->UpdateItem(table, "p_a", Value(100, 1)), SUCCESS);
+        ASSERT_EQ(engine_->UpdateItem(table, "p_a", Value(100, 1)), SUCCESS);
+        std::map<std::string, SessionStatistics> usage;
+        engine_->GetUsage(usage);
+        EXPECT_EQ(usage[table].suppressedWrites, 1u);
+
+        std::map<std::string, Value> batch { { "p_a", Value(100, 1) }, { "p_b", Value(1, 2) } };
+        ASSERT_EQ(engine_->UpdateItems(table, batch, {}), SUCCESS);
+        ASSERT_EQ(engine_->UpdateItem(table, "p_a", Value(100, 3)), SUCCESS);
+        usage.clear();
+        engine_->GetUsage(usage);
+        EXPECT_EQ(usage[table].suppressedWrites, 2u);
+        std::map<std::string, Value> items;
+        ASSERT_EQ(engine_->GetTable(table, items), SUCCESS);
+        ASSERT_EQ(items.size(), 2u);
+        EXPECT_EQ(items["p_a"], Value(100, 3));
+        EXPECT_EQ(items["p_b"], Value(1, 2));
+        ASSERT_EQ(engine_->DeleteTable(table), SUCCESS);
+    }
+}
@@ -31,11 +31,17 @@ public:
     static napi_value JSConstructor(napi_env env, napi_callback_info info);
     static napi_value JSGet(napi_env env, napi_callback_info info);
     static napi_value JSPut(napi_env env, napi_callback_info info);
+    static napi_value JSPutAll(napi_env env, napi_callback_info info);
+    static napi_value JSGetAll(napi_env env, napi_callback_info info);
     static napi_value GetCons(napi_env env);
 
 private:
-    static void DoPut(napi_env env, JSObjectWrapper *wrapper, char *key, napi_valuetype type, napi_value value);
-    static void DoGet(napi_env env, JSObjectWrapper *wrapper, char *key, napi_value &value);
+    static void DoPut(
+        napi_env env, JSObjectWrapper *wrapper, const std::string &key, napi_valuetype type, napi_value value);
+    static void DoGet(napi_env env, JSObjectWrapper *wrapper, const std::string &key, napi_value &value);
+    static napi_status GetFieldValue(napi_env env, napi_value in, FieldValue &out);
+    // a complex value is handed over to the returned napi_value when it can be
+    static napi_status SetFieldValue(napi_env env, FieldValue &in, napi_value &out);
 };
 } // namespace OHOS::ObjectStore
 
@@ -16,8 +16,11 @@
 #ifndef JS_DISTRIBUTEDDATAOBJECTSTORE_H
 #define JS_DISTRIBUTEDDATAOBJECTSTORE_H
 
+#include <chrono>
+#include <functional>
 #include <list>
 
+#include "callback_registry.h"
 #include "distributed_objectstore.h"
 #include "js_native_api.h"
 #include "js_object_wrapper.h"
@@ -27,17 +30,45 @@ class JSDistributedObjectStore {
 public:
     static napi_value JSCreateObjectSync(napi_env env, napi_callback_info info);
     static napi_value JSDestroyObjectSync(napi_env env, napi_callback_info info);
+    static napi_value JSCreateObject(napi_env env, napi_callback_info info);
+    static napi_value JSDestroyObject(napi_env env, napi_callback_info info);
     static napi_value JSOn(napi_env env, napi_callback_info info);
     static napi_value JSOff(napi_env env, napi_callback_info info);
     static std::string GetBundleName(napi_env env);
     static napi_value JSRecordCallback(napi_env env, napi_callback_info info);
     static napi_value JSDeleteCallback(napi_env env, napi_callback_info info);
+    static napi_value JSGetStatistics(napi_env env, napi_callback_info info);
+    static napi_value JSSetTraceEnabled(napi_env env, napi_callback_info info);
+    static napi_value JSExportTrace(napi_env env, napi_callback_info info);
+    static napi_value JSSetMemoryBudget(napi_env env, napi_callback_info info);
+    static napi_value JSGetPeerCapabilities(napi_env env, napi_callback_info info);
 private:
+    struct AsyncContext {
+        napi_async_work work = nullptr;
+        napi_deferred deferred = nullptr;
+        const char *name = nullptr;
+        DistributedObjectStore *objectStore = nullptr;
+        DistributedObject *object = nullptr;
+        std::string sessionId;
+        std::string objectId;
+        ObjectOptions options;
+        uint64_t ticket = 0;
+        uint32_t result = 0;
+        std::chrono::steady_clock::time_point requestTime;
+        int64_t storageCost = 0;
+    };
+    static bool GetCreateArgs(napi_env env, napi_callback_info info, std::string &sessionId, std::string &objectId,
+        ObjectOptions &options);
+    static napi_value QueueAsyncWork(napi_env env, AsyncContext *context, const char *name,
+        std::function<void(AsyncContext *)> task, napi_async_complete_callback complete);
+    static void CreateComplete(napi_env env, napi_status status, void *data);
+    static void DestroyComplete(napi_env env, napi_status status, void *data);
+    static void FinishAsyncWork(napi_env env, AsyncContext *context, bool success, napi_value result);
     static napi_value NewDistributedObject(
         napi_env env, DistributedObjectStore *objectStore, DistributedObject *object, const std::string &objectId);
-    static void AddCallback(napi_env env, std::map<std::string, std::list<napi_ref>> &callbacks,
+    static void AddCallback(napi_env env, std::map<std::string, CallbackRegistry> &callbacks,
         const std::string &objectId, napi_value callback);
-    static void DelCallback(napi_env env, std::map<std::string, std::list<napi_ref>> &callbacks,
+    static void DelCallback(napi_env env, std::map<std::string, CallbackRegistry> &callbacks,
         const std::string &sessionId, napi_value callback = nullptr);
     static void RestoreWatchers(napi_env env, JSObjectWrapper *wrapper, const std::string &objectId);
     static bool CheckSyncPermission(napi_env env);
@@ -16,6 +16,7 @@
 #ifndef JSWATCHER_H
 #define JSWATCHER_H
 
+#include "callback_registry.h"
 #include "distributed_objectstore.h"
 #include "flat_object_store.h"
 #include "napi/native_api.h"
@@ -24,14 +25,9 @@
 
 namespace OHOS::ObjectStore {
 class JSWatcher;
-struct EventHandler {
-    napi_ref callbackRef = nullptr;
-    EventHandler *next = nullptr;
-};
-
 class EventListener {
 public:
-    EventListener() : handlers_(nullptr)
+    EventListener()
     {
     }
 
@@ -41,12 +37,12 @@ public:
 
     virtual bool Add(napi_env env, napi_value handler);
 
+    // returns true when no handler is left
     virtual bool Del(napi_env env, napi_value handler);
 
     virtual void Clear(napi_env env);
 
-    EventHandler *Find(napi_env env, napi_value handler);
-    EventHandler *handlers_;
+    CallbackRegistry handlers_;
 };
 
 class ChangeEventListener : public EventListener {
@@ -96,21 +92,28 @@ public:
 
 private:
     struct ChangeArgs {
-        ChangeArgs(const napi_ref callback, const std::string &sessionId, const std::vector<std::string> &changeData);
-        napi_ref callback_;
+        ChangeArgs(const CallbackRegistry *callbacks, CallbackRegistry::Id callbackId, const std::string &sessionId,
+            const std::vector<std::string> &changeData);
+        // resolved on the loop, a handler removed after the change was queued is not called
+        const CallbackRegistry *callbacks_;
+        CallbackRegistry::Id callbackId_;
         const std::string sessionId_;
-        const std::vector<std::string> changeData_;
+        std::vector<std::string> changeData_;
+        uint64_t traceId_ = 0;  // propagation trace of the write behind the change, 0 when not traced
     };
     struct StatusArgs {
-        StatusArgs(const napi_ref callback, const std::string &sessionId, const std::string &networkId,
-            const std::string &status);
-        napi_ref callback_;
+        StatusArgs(const CallbackRegistry *callbacks, CallbackRegistry::Id callbackId, const std::string &sessionId,
+            const std::string &networkId, const std::string &status);
+        const CallbackRegistry *callbacks_;
+        CallbackRegistry::Id callbackId_;
         const std::string sessionId_;
         const std::string networkId_;
         const std::string status_;
     };
     EventListener *Find(const char *type);
     static void ProcessChange(napi_env env, std::list<void *> &args);
+    static void MergeChange(std::list<void *> &args);
+    static void ReportChange(uint64_t invocations, uint64_t merged);
     static void ProcessStatus(napi_env env, std::list<void *> &args);
     napi_env env_;
     ChangeEventListener *changeEventListener_;
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CALLBACK_REGISTRY_H
+#define CALLBACK_REGISTRY_H
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "macro.h"
+#include "napi/native_api.h"
+#include "napi/native_node_api.h"
+
+namespace OHOS::ObjectStore {
+// Set of JS callbacks with O(1) add and remove. Every function is tagged once in a WeakMap of its env
+// with a process wide id, so finding it again is a map lookup and a hash lookup instead of a strict
+// equals against every registered callback. The functions themselves are not touched. Should the
+// map be unavailable, callbacks fall back to the scan.
+// Add, Del and Clear run on the JS thread, ForEach may run on any thread.
+class CallbackRegistry {
+public:
+    using Id = uint64_t;
+    using Visitor = std::function<void(Id id, napi_ref callback)>;
+
+    CallbackRegistry() = default;
+    ~CallbackRegistry() = default;
+    DISABLE_COPY_AND_MOVE(CallbackRegistry);
+
+    // returns false when the callback is already registered
+    bool Add(napi_env env, napi_value callback);
+    // returns false when the callback is not registered
+    bool Del(napi_env env, napi_value callback);
+    void Clear(napi_env env);
+    bool Empty() const;
+    size_t Size() const;
+    // newest first, without copying the registry; callbacks removed while the visit is in progress
+    // on another thread are visited or not, never half
+    void ForEach(const Visitor &visitor) const;
+    // the reference behind id, nullptr when the callback has been removed since it was visited
+    napi_ref Get(Id id) const;
+
+private:
+    struct Entry {
+        Id id;
+        napi_ref callback;
+        bool tagged;
+    };
+    using Iterator = std::list<Entry>::iterator;
+
+    static bool GetTag(napi_env env, napi_value callback, bool create, Id &id);
+    static bool GetTagMap(napi_env env, napi_value &map, napi_value &get, napi_value &set);
+    Iterator FindUntagged(napi_env env, napi_value callback);
+
+    mutable std::mutex mutex_ {};
+    std::list<Entry> entries_ {};
+    std::unordered_map<Id, Iterator> index_ {};
+    size_t untagged_ = 0;
+};
+} // namespace OHOS::ObjectStore
+#endif // CALLBACK_REGISTRY_H
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_JS_SERIALIZER_H
+#define OHOS_JS_SERIALIZER_H
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "napi/native_api.h"
+#include "napi/native_node_api.h"
+
+namespace OHOS::ObjectStore {
+// Binary encoding of JS values stored as TYPE_COMPLEX. Values are tagged, integers are varints,
+// typed arrays are copied as raw bytes and a field name is written once, later objects refer to
+// it by index. Functions and symbols are skipped like JSON does.
+// The JS layer hands it typed arrays and ArrayBuffers only, and only while every online peer has
+// PeerCapabilities::BINARY_COMPLEX; ordinary objects stay JSON, which encodes them faster.
+// A typed array or ArrayBuffer stored as the whole value is never copied on the JS side: its
+// bytes are borrowed while writing and handed back as an external ArrayBuffer when reading.
+class JSSerializer final {
+public:
+    static constexpr uint8_t MAGIC = 0xC5;
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint32_t MAX_DEPTH = 64;
+
+    // memory of a JS value, valid as long as the value is not collected
+    struct Borrowed {
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+    };
+
+    static napi_status Serialize(napi_env env, napi_value in, std::vector<uint8_t> &out);
+    // the encoding is head followed by tail, tail borrows the bytes of a top-level typed array or ArrayBuffer
+    static napi_status Serialize(napi_env env, napi_value in, std::vector<uint8_t> &head, Borrowed &tail);
+    // bytes not written by Serialize are handed back as a Uint8Array, as before
+    static napi_status Deserialize(napi_env env, const std::vector<uint8_t> &in, napi_value &out);
+    // decodes in from offset on, a top-level typed array or ArrayBuffer takes over in and views its bytes
+    static napi_status Deserialize(napi_env env, std::vector<uint8_t> &&in, size_t offset, napi_value &out);
+
+private:
+    enum Tag : uint8_t {
+        TAG_UNDEFINED = 0,
+        TAG_NULL,
+        TAG_FALSE,
+        TAG_TRUE,
+        TAG_INT,
+        TAG_DOUBLE,
+        TAG_STRING,
+        TAG_ARRAY,
+        TAG_OBJECT,
+        TAG_TYPED_ARRAY,
+        TAG_ARRAY_BUFFER,
+    };
+
+    struct Writer {
+        std::vector<uint8_t> &out;
+        std::unordered_map<std::string, uint64_t> keys {};
+        Borrowed *tail = nullptr;
+    };
+
+    class Reader {
+    public:
+        Reader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+        bool ReadByte(uint8_t &value);
+        bool ReadVarint(uint64_t &value);
+        bool ReadBytes(size_t size, const uint8_t *&value);
+        std::vector<napi_value> keys {};
+        std::vector<uint8_t> *owner = nullptr;
+
+    private:
+        const uint8_t *data_;
+        size_t size_;
+        size_t offset_ = 0;
+    };
+
+    static napi_status WriteValue(napi_env env, napi_value in, uint32_t depth, Writer &writer);
+    static napi_status WriteNumber(napi_env env, napi_value in, Writer &writer);
+    static napi_status WriteString(napi_env env, napi_value in, Writer &writer);
+    static napi_status WriteArray(napi_env env, napi_value in, uint32_t depth, Writer &writer);
+    static napi_status WriteObject(napi_env env, napi_value in, uint32_t depth, Writer &writer);
+    static napi_status WriteKey(napi_env env, napi_value in, Writer &writer);
+    static napi_status WriteTypedArray(napi_env env, napi_value in, uint32_t depth, Writer &writer);
+    static napi_status WriteArrayBuffer(napi_env env, napi_value in, uint32_t depth, Writer &writer);
+    static void WritePayload(const void *data, size_t size, uint32_t depth, Writer &writer);
+    static void WriteVarint(uint64_t value, std::vector<uint8_t> &out);
+    static void WriteBytes(const void *data, size_t size, std::vector<uint8_t> &out);
+
+    static napi_status ReadValue(napi_env env, Reader &reader, uint32_t depth, napi_value &out);
+    static napi_status ReadString(napi_env env, Reader &reader, napi_value &out);
+    static napi_status ReadArray(napi_env env, Reader &reader, uint32_t depth, napi_value &out);
+    static napi_status ReadObject(napi_env env, Reader &reader, uint32_t depth, napi_value &out);
+    static napi_status ReadKey(napi_env env, Reader &reader, napi_value &out);
+    static napi_status ReadTypedArray(napi_env env, Reader &reader, uint32_t depth, napi_value &out);
+    static napi_status ReadArrayBuffer(napi_env env, Reader &reader, uint32_t depth, napi_value &out);
+    static napi_status ReadPayload(
+        napi_env env, Reader &reader, bool topLevel, const uint8_t *data, size_t size, napi_value &out);
+};
+} // namespace OHOS::ObjectStore
+#endif // OHOS_JS_SERIALIZER_H
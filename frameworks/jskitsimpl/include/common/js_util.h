@@ -43,6 +43,10 @@ public:
     /* napi_value <-> std::vector<uint8_t> */
     static napi_status GetValue(napi_env env, napi_value in, std::vector<uint8_t> &out);
     static napi_status SetValue(napi_env env, const std::vector<uint8_t> &in, napi_value &out);
+
+    /* ArrayBuffer over size bytes at data inside owner, it takes over owner instead of copying */
+    static napi_status CreateArrayBuffer(
+        napi_env env, std::vector<uint8_t> &&owner, const uint8_t *data, size_t size, napi_value &out);
 };
 
 #define LOG_ERROR_RETURN(condition, message, retVal)             \
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIFECYCLE_QUEUE_H
+#define LIFECYCLE_QUEUE_H
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "task_queue.h"
+
+namespace OHOS::ObjectStore {
+// Storage setup and teardown of sessions, run in the order they were requested whichever thread
+// gets to them: a thread that needs its task done drains the queue up to and including it, so the
+// napi async work, the sync calls on the JS thread and the GC finalizers never reorder a close and
+// a reopen of the same session.
+class LifecycleQueue {
+public:
+    using Task = std::function<void()>;
+
+    static LifecycleQueue &GetInstance();
+
+    // returns the ticket of the task, to wait for it with RunUntil
+    uint64_t Push(Task task);
+    // runs the queued tasks on the calling thread until the task behind ticket has run
+    void RunUntil(uint64_t ticket);
+    // runs the task later on a background thread, for callers that must not block like GC finalizers
+    void Defer(Task task);
+    size_t Size() const;
+
+private:
+    LifecycleQueue() = default;
+    ~LifecycleQueue() = default;
+    DISABLE_COPY_AND_MOVE(LifecycleQueue);
+
+    std::mutex runMutex_ {};
+    mutable std::mutex mutex_ {};
+    std::deque<Task> tasks_ {};
+    uint64_t pushed_ = 0;
+    uint64_t done_ = 0;
+    TaskQueue background_ {};
+};
+} // namespace OHOS::ObjectStore
+#endif // LIFECYCLE_QUEUE_H
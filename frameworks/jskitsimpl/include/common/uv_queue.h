@@ -14,30 +14,57 @@
  */
 #ifndef UV_QUEUE_H
 #define UV_QUEUE_H
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <list>
-#include <map>
-#include <shared_mutex>
 
+#include "histogram.h"
 #include "napi/native_api.h"
 #include "napi/native_node_api.h"
 #include "uv.h"
 
 namespace OHOS::ObjectStore {
+// env is nullptr when the queue is destroyed with args still pending, the process must only release them
 typedef void (*Process)(napi_env env, std::list<void *> &);
 class UvQueue {
 public:
     UvQueue(napi_env env);
     virtual ~UvQueue();
 
+    // thread safe, wakes the loop once for any number of calls made before it drains
     void CallFunction(Process process, void *argv);
 
+    // microseconds from CallFunction until the process runs on the loop
+    HistogramSnapshot GetLatency() const;
+
+    // notifications queued by every UvQueue of the process and not processed yet
+    static uint64_t GetPendingCount();
+
 private:
+    // intrusive node of the Vyukov multi producer single consumer queue
+    struct Node {
+        std::atomic<Node *> next{ nullptr };
+        Process process = nullptr;
+        void *argv = nullptr;
+        std::chrono::steady_clock::time_point enqueueTime;
+    };
+    void Push(Node *node);
+    Node *Pop();
+    void Drain(napi_env env);
+    static void OnAsync(uv_async_t *async);
+
     napi_env env_;
-    std::shared_mutex mutex_{};
-    // key is callback,value is list of args
-    std::map<Process, std::list<void *>> args_;
     uv_loop_s *loop_ = nullptr;
+    uv_async_t *async_ = nullptr;
+    Node stub_;
+    std::atomic<Node *> head_{ &stub_ };
+    Node *tail_ = &stub_;
+    std::atomic<bool> closing_{ false };
+    std::atomic<uint32_t> inflight_{ 0 };
+    Histogram latency_;
+    std::atomic<uint64_t> notifications_{ 0 };
+    uint64_t wakeups_ = 0;
 };
 } // namespace OHOS::ObjectStore
 #endif
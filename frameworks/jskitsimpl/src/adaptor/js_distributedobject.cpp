@@ -19,12 +19,13 @@
 
 #include "js_common.h"
 #include "js_object_wrapper.h"
+#include "js_serializer.h"
 #include "js_util.h"
 #include "logger.h"
 #include "objectstore_errors.h"
+#include "peer_capabilities.h"
 
 namespace OHOS::ObjectStore {
-constexpr size_t KEY_SIZE = 64;
 napi_value JSDistributedObject::JSConstructor(napi_env env, napi_callback_info info)
 {
     LOG_INFO("start");
@@ -43,12 +44,11 @@ napi_value JSDistributedObject::JSGet(napi_env env, napi_callback_info info)
     napi_value argv[1] = { 0 };
     napi_value thisVar = nullptr;
     void *data = nullptr;
-    char key[KEY_SIZE] = { 0 };
-    size_t keyLen = 0;
+    std::string key;
     napi_status status = napi_get_cb_info(env, info, &argc, argv, &thisVar, &data);
     CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
     ASSERT_MATCH_ELSE_RETURN_NULL(argc >= requireArgc);
-    status = napi_get_value_string_utf8(env, argv[0], key, KEY_SIZE, &keyLen);
+    status = JSUtil::GetValue(env, argv[0], key);
     CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
     JSObjectWrapper *wrapper = nullptr;
     status = napi_unwrap(env, thisVar, (void **)&wrapper);
@@ -66,8 +66,7 @@ napi_value JSDistributedObject::JSPut(napi_env env, napi_callback_info info)
     size_t argc = 2;
     napi_value argv[2] = { 0 };
     napi_value thisVar = nullptr;
-    char key[KEY_SIZE] = { 0 };
-    size_t keyLen = 0;
+    std::string key;
     napi_valuetype valueType;
     napi_status status = napi_get_cb_info(env, info, &argc, argv, &thisVar, nullptr);
     CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
@@ -75,7 +74,7 @@ napi_value JSDistributedObject::JSPut(napi_env env, napi_callback_info info)
     status = napi_typeof(env, argv[0], &valueType);
     CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
     CHECK_EQUAL_WITH_RETURN_NULL(valueType, napi_string);
-    status = napi_get_value_string_utf8(env, argv[0], key, KEY_SIZE, &keyLen);
+    status = JSUtil::GetValue(env, argv[0], key);
     CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
     status = napi_typeof(env, argv[1], &valueType);
     CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
@@ -84,10 +83,117 @@ napi_value JSDistributedObject::JSPut(napi_env env, napi_callback_info info)
     CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
     ASSERT_MATCH_ELSE_RETURN_NULL(wrapper != nullptr);
     DoPut(env, wrapper, key, valueType, argv[1]);
-    LOG_INFO("put %{public}s success", key);
+    LOG_INFO("put %{public}s success", key.c_str());
     return nullptr;
 }
 
+// putAll(record: {[key: string]: ValueType}, removed?: string[]): number;
+// all the fields and deletes or none, SUCCESS or the error
+napi_value JSDistributedObject::JSPutAll(napi_env env, napi_callback_info info)
+{
+    size_t requireArgc = 1;
+    size_t argc = 2;
+    napi_value argv[2] = { 0 };
+    napi_value thisVar = nullptr;
+    napi_valuetype valueType = napi_undefined;
+    napi_status status = napi_get_cb_info(env, info, &argc, argv, &thisVar, nullptr);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    ASSERT_MATCH_ELSE_RETURN_NULL(argc >= requireArgc);
+    status = napi_typeof(env, argv[0], &valueType);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    CHECK_EQUAL_WITH_RETURN_NULL(valueType, napi_object);
+    std::vector<std::string> removed;
+    if (argc >= 2) {
+        status = napi_typeof(env, argv[1], &valueType);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        if (valueType != napi_undefined && valueType != napi_null) {
+            status = JSUtil::GetValue(env, argv[1], removed);
+            CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        }
+    }
+    JSObjectWrapper *wrapper = nullptr;
+    status = napi_unwrap(env, thisVar, (void **)&wrapper);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    ASSERT_MATCH_ELSE_RETURN_NULL(wrapper != nullptr);
+    napi_value names = nullptr;
+    uint32_t length = 0;
+    status = napi_get_property_names(env, argv[0], &names);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    status = napi_get_array_length(env, names, &length);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    std::map<std::string, FieldValue> fields;
+    uint32_t ret = SUCCESS;
+    for (uint32_t i = 0; i < length && ret == SUCCESS; i++) {
+        napi_value name = nullptr;
+        napi_value value = nullptr;
+        std::string key;
+        FieldValue field;
+        status = napi_get_element(env, names, i, &name);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = napi_get_property(env, argv[0], name, &value);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = JSUtil::GetValue(env, name, key);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        if (GetFieldValue(env, value, field) != napi_ok) {
+            LOG_ERROR("unsupported value of %{public}s", key.c_str());
+            ret = ERR_DATA_LEN;
+            continue;
+        }
+        fields.insert_or_assign(std::move(key), std::move(field));
+    }
+    if (ret == SUCCESS) {
+        ret = wrapper->GetObject()->PutBatch(fields, removed);
+    }
+    LOG_INFO("put %{public}zu fields, delete %{public}zu, ret %{public}u", fields.size(), removed.size(), ret);
+    napi_value result = nullptr;
+    napi_create_int32(env, ret, &result);
+    return result;
+}
+
+// getAll(prefix?: string): {[key: string]: ValueType};
+napi_value JSDistributedObject::JSGetAll(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value argv[1] = { 0 };
+    napi_value thisVar = nullptr;
+    napi_status status = napi_get_cb_info(env, info, &argc, argv, &thisVar, nullptr);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    // only the fields under the prefix are decoded and assembled, all of them without one
+    std::string prefix;
+    if (argc >= 1) {
+        napi_valuetype valueType = napi_undefined;
+        status = napi_typeof(env, argv[0], &valueType);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        if (valueType != napi_undefined && valueType != napi_null) {
+            status = JSUtil::GetValue(env, argv[0], prefix);
+            CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        }
+    }
+    JSObjectWrapper *wrapper = nullptr;
+    status = napi_unwrap(env, thisVar, (void **)&wrapper);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    ASSERT_MATCH_ELSE_RETURN_NULL(wrapper != nullptr);
+    std::map<std::string, FieldValue> fields;
+    uint32_t ret = wrapper->GetObject()->GetAll(prefix, fields);
+    ASSERT_MATCH_ELSE_RETURN_NULL(ret == SUCCESS);
+    napi_value result = nullptr;
+    status = napi_create_object(env, &result);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    for (auto &[key, field] : fields) {
+        napi_value name = nullptr;
+        napi_value value = nullptr;
+        if (SetFieldValue(env, field, value) != napi_ok) {
+            LOG_ERROR("skip %{public}s, bad value", key.c_str());
+            continue;
+        }
+        status = JSUtil::SetValue(env, key, name);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = napi_set_property(env, result, name, value);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    }
+    return result;
+}
+
 napi_value JSDistributedObject::GetCons(napi_env env)
 {
     static thread_local napi_ref g_instance = nullptr;
@@ -101,6 +207,8 @@ napi_value JSDistributedObject::GetCons(napi_env env)
     napi_property_descriptor distributedObjectDesc[] = {
         DECLARE_NAPI_FUNCTION("put", JSDistributedObject::JSPut),
         DECLARE_NAPI_FUNCTION("get", JSDistributedObject::JSGet),
+        DECLARE_NAPI_FUNCTION("putAll", JSDistributedObject::JSPutAll),
+        DECLARE_NAPI_FUNCTION("getAll", JSDistributedObject::JSGetAll),
     };
 
     napi_status status = napi_define_class(env, distributedObjectName, strlen(distributedObjectName),
@@ -115,36 +223,44 @@ napi_value JSDistributedObject::GetCons(napi_env env)
 }
 
 void JSDistributedObject::DoPut(
-    napi_env env, JSObjectWrapper *wrapper, char *key, napi_valuetype type, napi_value value)
+    napi_env env, JSObjectWrapper *wrapper, const std::string &key, napi_valuetype type, napi_value value)
 {
-    std::string keyString = key;
     switch (type) {
         case napi_boolean: {
             bool putValue = false;
             napi_status status = JSUtil::GetValue(env, value, putValue);
             CHECK_EQUAL_WITH_RETURN_VOID(status, napi_ok);
-            wrapper->GetObject()->PutBoolean(keyString, putValue);
+            wrapper->GetObject()->PutBoolean(key, putValue);
             break;
         }
         case napi_number: {
             double putValue = 0;
             napi_status status = JSUtil::GetValue(env, value, putValue);
             CHECK_EQUAL_WITH_RETURN_VOID(status, napi_ok);
-            wrapper->GetObject()->PutDouble(keyString, putValue);
+            wrapper->GetObject()->PutDouble(key, putValue);
             break;
         }
         case napi_string: {
             std::string putValue;
             napi_status status = JSUtil::GetValue(env, value, putValue);
             CHECK_EQUAL_WITH_RETURN_VOID(status, napi_ok);
-            wrapper->GetObject()->PutString(keyString, putValue);
+            wrapper->GetObject()->PutString(key, putValue);
             break;
         }
         case napi_object: {
-            std::vector<uint8_t> putValue;
-            napi_status status = JSUtil::GetValue(env, value, putValue);
+            if (!PeerCapabilities::GetInstance().AllHave(PeerCapabilities::BINARY_COMPLEX)) {
+                // older peers read the raw bytes of a Uint8Array back as one, and no other object
+                std::vector<uint8_t> putValue;
+                napi_status status = JSUtil::GetValue(env, value, putValue);
+                CHECK_EQUAL_WITH_RETURN_VOID(status, napi_ok);
+                wrapper->GetObject()->PutComplex(key, putValue);
+                break;
+            }
+            std::vector<uint8_t> head;
+            JSSerializer::Borrowed tail;
+            napi_status status = JSSerializer::Serialize(env, value, head, tail);
             CHECK_EQUAL_WITH_RETURN_VOID(status, napi_ok);
-            wrapper->GetObject()->PutComplex(keyString, putValue);
+            wrapper->GetObject()->PutComplex(key, head, tail.data, tail.size);
             break;
         }
         default: {
@@ -154,16 +270,15 @@ void JSDistributedObject::DoPut(
     }
 }
 
-void JSDistributedObject::DoGet(napi_env env, JSObjectWrapper *wrapper, char *key, napi_value &value)
+void JSDistributedObject::DoGet(napi_env env, JSObjectWrapper *wrapper, const std::string &key, napi_value &value)
 {
-    std::string keyString = key;
     Type type = TYPE_STRING;
-    wrapper->GetObject()->GetType(keyString, type);
-    LOG_DEBUG("get type %{public}s %{public}d", key, type);
+    wrapper->GetObject()->GetType(key, type);
+    LOG_DEBUG("get type %{public}s %{public}d", key.c_str(), type);
     switch (type) {
         case TYPE_STRING: {
             std::string result;
-            uint32_t ret = wrapper->GetObject()->GetString(keyString, result);
+            uint32_t ret = wrapper->GetObject()->GetString(key, result);
             ASSERT_MATCH_ELSE_RETURN_VOID(ret == SUCCESS)
             napi_status status = JSUtil::SetValue(env, result, value);
             ASSERT_MATCH_ELSE_RETURN_VOID(status == napi_ok)
@@ -171,7 +286,7 @@ void JSDistributedObject::DoGet(napi_env env, JSObjectWrapper *wrapper, char *ke
         }
         case TYPE_DOUBLE: {
             double result;
-            uint32_t ret = wrapper->GetObject()->GetDouble(keyString, result);
+            uint32_t ret = wrapper->GetObject()->GetDouble(key, result);
             LOG_DEBUG("%{public}f", result);
             ASSERT_MATCH_ELSE_RETURN_VOID(ret == SUCCESS)
             napi_status status = JSUtil::SetValue(env, result, value);
@@ -180,7 +295,7 @@ void JSDistributedObject::DoGet(napi_env env, JSObjectWrapper *wrapper, char *ke
         }
         case TYPE_BOOLEAN: {
             bool result;
-            uint32_t ret = wrapper->GetObject()->GetBoolean(keyString, result);
+            uint32_t ret = wrapper->GetObject()->GetBoolean(key, result);
             LOG_DEBUG("%{public}d", result);
             ASSERT_MATCH_ELSE_RETURN_VOID(ret == SUCCESS)
             napi_status status = JSUtil::SetValue(env, result, value);
@@ -189,9 +304,10 @@ void JSDistributedObject::DoGet(napi_env env, JSObjectWrapper *wrapper, char *ke
         }
         case TYPE_COMPLEX: {
             std::vector<uint8_t> result;
-            uint32_t ret = wrapper->GetObject()->GetComplex(keyString, result);
+            size_t offset = 0;
+            uint32_t ret = wrapper->GetObject()->GetComplex(key, result, offset);
             ASSERT_MATCH_ELSE_RETURN_VOID(ret == SUCCESS)
-            napi_status status = JSUtil::SetValue(env, result, value);
+            napi_status status = JSSerializer::Deserialize(env, std::move(result), offset, value);
             ASSERT_MATCH_ELSE_RETURN_VOID(status == napi_ok)
             break;
         }
@@ -201,4 +317,60 @@ void JSDistributedObject::DoGet(napi_env env, JSObjectWrapper *wrapper, char *ke
         }
     }
 }
+napi_status JSDistributedObject::GetFieldValue(napi_env env, napi_value in, FieldValue &out)
+{
+    napi_valuetype type = napi_undefined;
+    napi_status status = napi_typeof(env, in, &type);
+    if (status != napi_ok) {
+        return status;
+    }
+    switch (type) {
+        case napi_boolean: {
+            bool value = false;
+            status = JSUtil::GetValue(env, in, value);
+            out = value;
+            return status;
+        }
+        case napi_number: {
+            double value = 0;
+            status = JSUtil::GetValue(env, in, value);
+            out = value;
+            return status;
+        }
+        case napi_string: {
+            std::string value;
+            status = JSUtil::GetValue(env, in, value);
+            out = std::move(value);
+            return status;
+        }
+        case napi_object: {
+            std::vector<uint8_t> value;
+            if (PeerCapabilities::GetInstance().AllHave(PeerCapabilities::BINARY_COMPLEX)) {
+                status = JSSerializer::Serialize(env, in, value);
+            } else {
+                status = JSUtil::GetValue(env, in, value);
+            }
+            out = std::move(value);
+            return status;
+        }
+        default:
+            return napi_invalid_arg;
+    }
+}
+
+napi_status JSDistributedObject::SetFieldValue(napi_env env, FieldValue &in, napi_value &out)
+{
+    switch (in.index()) {
+        case TYPE_STRING:
+            return JSUtil::SetValue(env, std::get<std::string>(in), out);
+        case TYPE_BOOLEAN:
+            return JSUtil::SetValue(env, std::get<bool>(in), out);
+        case TYPE_DOUBLE:
+            return JSUtil::SetValue(env, std::get<double>(in), out);
+        case TYPE_COMPLEX:
+            return JSSerializer::Deserialize(env, std::move(std::get<std::vector<uint8_t>>(in)), 0, out);
+        default:
+            return napi_invalid_arg;
+    }
+}
 } // namespace OHOS::ObjectStore
\ No newline at end of file
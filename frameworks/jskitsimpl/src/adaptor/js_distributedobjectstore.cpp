@@ -16,6 +16,7 @@
 #include "js_distributedobjectstore.h"
 
 #include <cstring>
+#include <vector>
 
 #include "ability_context.h"
 #include "accesstoken_kit.h"
@@ -24,66 +25,73 @@
 #include "js_distributedobject.h"
 #include "js_object_wrapper.h"
 #include "js_util.h"
+#include "lifecycle_queue.h"
 #include "logger.h"
 #include "objectstore_errors.h"
+#include "peer_capabilities.h"
+#include "uv_queue.h"
 
 namespace OHOS::ObjectStore {
 constexpr size_t TYPE_SIZE = 10;
+
+static int64_t MicrosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static napi_status SetNamedNumber(napi_env env, napi_value object, const char *name, uint64_t value)
+{
+    napi_value number = nullptr;
+    napi_status status = JSUtil::SetValue(env, static_cast<double>(value), number);
+    if (status != napi_ok) {
+        return status;
+    }
+    return napi_set_named_property(env, object, name, number);
+}
+
+static napi_status SetNamedLatency(napi_env env, napi_value object, const char *name, const LatencyStatistics &latency)
+{
+    napi_value value = nullptr;
+    napi_status status = napi_create_object(env, &value);
+    if (status != napi_ok) {
+        return status;
+    }
+    const std::pair<const char *, uint64_t> fields[] = { { "count", latency.count }, { "average", latency.average },
+        { "p50", latency.p50 }, { "p99", latency.p99 }, { "max", latency.max } };
+    for (auto &[field, number] : fields) {
+        status = SetNamedNumber(env, value, field, number);
+        if (status != napi_ok) {
+            return status;
+        }
+    }
+    return napi_set_named_property(env, object, name, value);
+}
+
 const std::string DISTRIBUTED_DATASYNC = "ohos.permission.DISTRIBUTED_DATASYNC";
-static std::map<std::string, std::list<napi_ref>> g_statusCallBacks;
-static std::map<std::string, std::list<napi_ref>> g_changeCallBacks;
+static std::map<std::string, CallbackRegistry> g_statusCallBacks;
+static std::map<std::string, CallbackRegistry> g_changeCallBacks;
 
-void JSDistributedObjectStore::AddCallback(napi_env env, std::map<std::string, std::list<napi_ref>> &callbacks,
+void JSDistributedObjectStore::AddCallback(napi_env env, std::map<std::string, CallbackRegistry> &callbacks,
     const std::string &objectId, napi_value callback)
 {
     LOG_INFO("add callback %{public}s", objectId.c_str());
-    napi_ref ref = nullptr;
-    napi_status status = napi_create_reference(env, callback, 1, &ref);
-    CHECK_EQUAL_WITH_RETURN_VOID(status, napi_ok);
-    if (callbacks.count(objectId) != 0) {
-        auto lists = callbacks.at(objectId);
-        lists.push_back(ref);
-        callbacks.insert_or_assign(objectId, lists);
-    } else {
-        std::list<napi_ref> lists = { ref };
-        callbacks.insert_or_assign(objectId, lists);
-    }
+    callbacks[objectId].Add(env, callback);
 }
-void JSDistributedObjectStore::DelCallback(napi_env env, std::map<std::string, std::list<napi_ref>> &callbacks,
+void JSDistributedObjectStore::DelCallback(napi_env env, std::map<std::string, CallbackRegistry> &callbacks,
     const std::string &sessionId, napi_value callback)
 {
     LOG_INFO("del callback %{public}s", sessionId.c_str());
-    napi_status status;
-    if (callback == nullptr) {
-        if (callbacks.count(sessionId) != 0) {
-            for (auto ref : callbacks.at(sessionId)) {
-                status = napi_delete_reference(env, ref);
-                CHECK_EQUAL_WITH_RETURN_VOID(status, napi_ok);
-            }
-            callbacks.erase(sessionId);
-        }
+    auto it = callbacks.find(sessionId);
+    if (it == callbacks.end()) {
         return;
     }
-    napi_value callbackTmp;
-    if (callbacks.count(sessionId) != 0) {
-        auto lists = callbacks.at(sessionId);
-        for (auto iter = lists.begin(); iter != lists.end();) {
-            status = napi_get_reference_value(env, *iter, &callbackTmp);
-            CHECK_EQUAL_WITH_RETURN_VOID(status, napi_ok);
-            bool isEquals = false;
-            napi_strict_equals(env, callbackTmp, callback, &isEquals);
-            if (isEquals) {
-                napi_delete_reference(env, *iter);
-                iter = lists.erase(iter);
-            } else {
-                iter++;
-            }
-        }
-        if (lists.empty()) {
-            callbacks.erase(sessionId);
-        } else {
-            callbacks.insert_or_assign(sessionId, lists);
-        }
+    if (callback == nullptr) {
+        it->second.Clear(env);
+    } else {
+        it->second.Del(env, callback);
+    }
+    if (it->second.Empty()) {
+        callbacks.erase(it);
     }
 }
 napi_value JSDistributedObjectStore::NewDistributedObject(
@@ -98,11 +106,17 @@ napi_value JSDistributedObjectStore::NewDistributedObject(
         [](napi_env env, void *data, void *hint) {
             LOG_INFO("start delete object");
             auto objectWrapper = (JSObjectWrapper *)data;
-            DistributedObjectStore::GetInstance(JSDistributedObjectStore::GetBundleName(env))
-                ->DeleteObject(objectWrapper->GetObject()->GetSessionId());
-            if (objectWrapper != nullptr) {
-                delete objectWrapper;
+            if (objectWrapper == nullptr) {
+                return;
             }
+            // closing the store is left to the background, GC must not wait for storage
+            auto objectStore = DistributedObjectStore::GetInstance(JSDistributedObjectStore::GetBundleName(env));
+            std::string sessionId = objectWrapper->GetObject()->GetSessionId();
+            LifecycleQueue::GetInstance().Defer([objectStore, sessionId]() {
+                uint32_t ret = objectStore->DeleteObject(sessionId);
+                LOG_INFO("deferred delete %{public}s ret %{public}u", sessionId.c_str(), ret);
+            });
+            delete objectWrapper;
         },
         nullptr, nullptr);
     RestoreWatchers(env, objectWrapper, objectId);
@@ -110,41 +124,207 @@ napi_value JSDistributedObjectStore::NewDistributedObject(
     return result;
 }
 
-// function createObjectSync(sessionId: string, objectId:string): DistributedObject;
-napi_value JSDistributedObjectStore::JSCreateObjectSync(napi_env env, napi_callback_info info)
+bool JSDistributedObjectStore::GetCreateArgs(
+    napi_env env, napi_callback_info info, std::string &sessionId, std::string &objectId, ObjectOptions &options)
 {
-    LOG_INFO("start JSCreateObjectSync");
     if (!JSDistributedObjectStore::CheckSyncPermission(env)) {
         LOG_INFO("no permission ohos.permission.DISTRIBUTED_DATASYNC");
-        return nullptr;
+        return false;
     }
     size_t requireArgc = 2;
-    size_t argc = 2;
-    napi_value argv[2] = { 0 };
+    size_t argc = 3;
+    napi_value argv[3] = { 0 };
     napi_value thisVar = nullptr;
     void *data = nullptr;
-    std::string sessionId;
-    std::string objectId;
     napi_status status = napi_get_cb_info(env, info, &argc, argv, &thisVar, &data);
-    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
-    ASSERT_MATCH_ELSE_RETURN_NULL(argc >= requireArgc);
+    CHECK_EQUAL_WITH_RETURN_FALSE(status, napi_ok);
+    ASSERT_MATCH_ELSE_RETURN_FALSE(argc >= requireArgc);
     napi_valuetype valueType = napi_undefined;
     status = napi_typeof(env, argv[0], &valueType);
-    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
-    CHECK_EQUAL_WITH_RETURN_NULL(valueType, napi_string)
+    CHECK_EQUAL_WITH_RETURN_FALSE(status, napi_ok);
+    CHECK_EQUAL_WITH_RETURN_FALSE(valueType, napi_string)
     status = JSUtil::GetValue(env, argv[0], sessionId);
-    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    CHECK_EQUAL_WITH_RETURN_FALSE(status, napi_ok);
     status = napi_typeof(env, argv[1], &valueType);
-    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
-    CHECK_EQUAL_WITH_RETURN_NULL(valueType, napi_string)
+    CHECK_EQUAL_WITH_RETURN_FALSE(status, napi_ok);
+    CHECK_EQUAL_WITH_RETURN_FALSE(valueType, napi_string)
     status = JSUtil::GetValue(env, argv[1], objectId);
-    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    CHECK_EQUAL_WITH_RETURN_FALSE(status, napi_ok);
+    options = ObjectOptions();
+    if (argc > requireArgc) {
+        status = napi_typeof(env, argv[2], &valueType);
+        CHECK_EQUAL_WITH_RETURN_FALSE(status, napi_ok);
+        if (valueType == napi_boolean) {
+            status = JSUtil::GetValue(env, argv[2], options.durable);
+            CHECK_EQUAL_WITH_RETURN_FALSE(status, napi_ok);
+        }
+    }
+    if (options.durable) {
+        // durable stores live with the other databases of the application
+        options.dataDir = AbilityRuntime::Context::GetApplicationContext()->GetDatabaseDir() + "/distributedobject";
+    }
+    return true;
+}
+
+// function createObjectSync(sessionId: string, objectId:string, durable?: boolean): DistributedObject;
+napi_value JSDistributedObjectStore::JSCreateObjectSync(napi_env env, napi_callback_info info)
+{
+    LOG_INFO("start JSCreateObjectSync");
+    auto start = std::chrono::steady_clock::now();
+    std::string sessionId;
+    std::string objectId;
+    ObjectOptions options;
+    ASSERT_MATCH_ELSE_RETURN_NULL(GetCreateArgs(env, info, sessionId, objectId, options));
     DistributedObjectStore *objectInfo =
         DistributedObjectStore::GetInstance(JSDistributedObjectStore::GetBundleName(env));
     ASSERT_MATCH_ELSE_RETURN_NULL(objectInfo != nullptr);
-    DistributedObject *object = objectInfo->CreateObject(sessionId);
+    DistributedObject *object = nullptr;
+    auto &lifecycle = LifecycleQueue::GetInstance();
+    lifecycle.RunUntil(lifecycle.Push([objectInfo, &object, &sessionId, &options]() {
+        object = objectInfo->CreateObject(sessionId, options);
+    }));
     ASSERT_MATCH_ELSE_RETURN_NULL(object != nullptr);
-    return NewDistributedObject(env, objectInfo, object, objectId);
+    napi_value result = NewDistributedObject(env, objectInfo, object, objectId);
+    LOG_INFO("createObjectSync %{public}s blocked js thread %{public}lld us", sessionId.c_str(),
+        static_cast<long long>(MicrosecondsSince(start)));
+    return result;
+}
+
+// function createObject(sessionId: string, objectId: string, durable?: boolean): Promise<DistributedObject>;
+napi_value JSDistributedObjectStore::JSCreateObject(napi_env env, napi_callback_info info)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::string sessionId;
+    std::string objectId;
+    ObjectOptions options;
+    ASSERT_MATCH_ELSE_RETURN_NULL(GetCreateArgs(env, info, sessionId, objectId, options));
+    DistributedObjectStore *objectInfo =
+        DistributedObjectStore::GetInstance(JSDistributedObjectStore::GetBundleName(env));
+    ASSERT_MATCH_ELSE_RETURN_NULL(objectInfo != nullptr);
+    auto context = new (std::nothrow) AsyncContext;
+    ASSERT_MATCH_ELSE_RETURN_NULL(context != nullptr);
+    context->objectStore = objectInfo;
+    context->sessionId = std::move(sessionId);
+    context->objectId = std::move(objectId);
+    context->options = std::move(options);
+    context->requestTime = start;
+    napi_value promise = QueueAsyncWork(
+        env, context, "createObject",
+        [](AsyncContext *context) {
+            context->object = context->objectStore->CreateObject(context->sessionId, context->options);
+        },
+        CreateComplete);
+    LOG_DEBUG("createObject blocked js thread %{public}lld us", static_cast<long long>(MicrosecondsSince(start)));
+    return promise;
+}
+
+// function destroyObject(object: DistributedObject): Promise<number>;
+napi_value JSDistributedObjectStore::JSDestroyObject(napi_env env, napi_callback_info info)
+{
+    auto start = std::chrono::steady_clock::now();
+    size_t requireArgc = 1;
+    size_t argc = 1;
+    napi_value argv[1] = { 0 };
+    napi_status status = napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    ASSERT_MATCH_ELSE_RETURN_NULL(argc >= requireArgc);
+    JSObjectWrapper *objectWrapper = nullptr;
+    status = napi_unwrap(env, argv[0], (void **)&objectWrapper);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    ASSERT_MATCH_ELSE_RETURN_NULL(objectWrapper != nullptr);
+    DistributedObjectStore *objectInfo =
+        DistributedObjectStore::GetInstance(JSDistributedObjectStore::GetBundleName(env));
+    ASSERT_MATCH_ELSE_RETURN_NULL(objectInfo != nullptr && objectWrapper->GetObject() != nullptr);
+    // callbacks live on the JS thread, only the store is closed in the background
+    objectWrapper->DeleteWatch(env, CHANGE);
+    objectWrapper->DeleteWatch(env, STATUS);
+    auto context = new (std::nothrow) AsyncContext;
+    ASSERT_MATCH_ELSE_RETURN_NULL(context != nullptr);
+    context->objectStore = objectInfo;
+    context->sessionId = objectWrapper->GetObject()->GetSessionId();
+    context->requestTime = start;
+    napi_value promise = QueueAsyncWork(
+        env, context, "destroyObject",
+        [](AsyncContext *context) { context->result = context->objectStore->DeleteObject(context->sessionId); },
+        DestroyComplete);
+    LOG_DEBUG("destroyObject blocked js thread %{public}lld us", static_cast<long long>(MicrosecondsSince(start)));
+    return promise;
+}
+
+napi_value JSDistributedObjectStore::QueueAsyncWork(napi_env env, AsyncContext *context, const char *name,
+    std::function<void(AsyncContext *)> task, napi_async_complete_callback complete)
+{
+    napi_value promise = nullptr;
+    napi_value resourceName = nullptr;
+    context->name = name;
+    napi_status status = napi_create_promise(env, &context->deferred, &promise);
+    if (status == napi_ok) {
+        status = napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH, &resourceName);
+    }
+    if (status == napi_ok) {
+        status = napi_create_async_work(
+            env, nullptr, resourceName,
+            [](napi_env env, void *data) {
+                auto context = static_cast<AsyncContext *>(data);
+                LifecycleQueue::GetInstance().RunUntil(context->ticket);
+            },
+            complete, context, &context->work);
+    }
+    if (status != napi_ok) {
+        LOG_ERROR("%{public}s create async work failed %{public}d", name, status);
+        delete context;
+        return nullptr;
+    }
+    // the ticket is taken on the JS thread, so tasks keep the order of the calls
+    context->ticket = LifecycleQueue::GetInstance().Push([context, task]() {
+        auto start = std::chrono::steady_clock::now();
+        task(context);
+        context->storageCost = MicrosecondsSince(start);
+    });
+    status = napi_queue_async_work(env, context->work);
+    if (status != napi_ok) {
+        LOG_ERROR("%{public}s queue async work failed %{public}d, run in place", name, status);
+        LifecycleQueue::GetInstance().RunUntil(context->ticket);
+        complete(env, napi_ok, context);
+    }
+    return promise;
+}
+
+void JSDistributedObjectStore::CreateComplete(napi_env env, napi_status status, void *data)
+{
+    auto context = static_cast<AsyncContext *>(data);
+    napi_value result = nullptr;
+    if (status == napi_ok && context->object != nullptr) {
+        result = NewDistributedObject(env, context->objectStore, context->object, context->objectId);
+    }
+    FinishAsyncWork(env, context, result != nullptr, result);
+}
+
+void JSDistributedObjectStore::DestroyComplete(napi_env env, napi_status status, void *data)
+{
+    auto context = static_cast<AsyncContext *>(data);
+    napi_value result = nullptr;
+    napi_create_int32(env, context->result, &result);
+    FinishAsyncWork(env, context, status == napi_ok, result);
+}
+
+void JSDistributedObjectStore::FinishAsyncWork(napi_env env, AsyncContext *context, bool success, napi_value result)
+{
+    LOG_INFO("%{public}s %{public}s done, storage %{public}lld us, request to completion %{public}lld us",
+        context->name, context->sessionId.c_str(), static_cast<long long>(context->storageCost),
+        static_cast<long long>(MicrosecondsSince(context->requestTime)));
+    if (success) {
+        napi_resolve_deferred(env, context->deferred, result);
+    } else {
+        napi_value message = nullptr;
+        napi_value error = nullptr;
+        std::string text = std::string(context->name) + " " + context->sessionId + " failed";
+        napi_create_string_utf8(env, text.c_str(), text.size(), &message);
+        napi_create_error(env, nullptr, message, &error);
+        napi_reject_deferred(env, context->deferred, error);
+    }
+    napi_delete_async_work(env, context->work);
+    delete context;
 }
 
 // function destroyObjectSync(object: DistributedObject): number;
@@ -171,7 +351,12 @@ napi_value JSDistributedObjectStore::JSDestroyObjectSync(napi_env env, napi_call
     ASSERT_MATCH_ELSE_RETURN_NULL(objectInfo != nullptr && objectWrapper->GetObject() != nullptr);
     objectWrapper->DeleteWatch(env, CHANGE);
     objectWrapper->DeleteWatch(env, STATUS);
-    uint32_t ret = objectInfo->DeleteObject(objectWrapper->GetObject()->GetSessionId());
+    uint32_t ret = SUCCESS;
+    sessionId = objectWrapper->GetObject()->GetSessionId();
+    auto &lifecycle = LifecycleQueue::GetInstance();
+    lifecycle.RunUntil(lifecycle.Push([objectInfo, &ret, &sessionId]() {
+        ret = objectInfo->DeleteObject(sessionId);
+    }));
     napi_value result = nullptr;
     napi_create_int32(env, ret, &result);
     return result;
@@ -280,32 +465,33 @@ std::string JSDistributedObjectStore::GetBundleName(napi_env env)
 
 void JSDistributedObjectStore::RestoreWatchers(napi_env env, JSObjectWrapper *wrapper, const std::string &objectId)
 {
-    napi_status status;
-    napi_value callbackValue;
     LOG_DEBUG("start restore %{public}s", objectId.c_str());
-    if (g_changeCallBacks.count(objectId) != 0) {
-        LOG_INFO("restore change on %{public}s", objectId.c_str());
-        for (auto callback : g_changeCallBacks.at(objectId)) {
-            status = napi_get_reference_value(env, callback, &callbackValue);
+    // the records are newest first, replay them oldest first so the watcher ends up in the same order
+    auto restore = [env, wrapper](const char *type, const CallbackRegistry &callbacks) {
+        std::vector<napi_ref> refs;
+        refs.reserve(callbacks.Size());
+        callbacks.ForEach([&refs](CallbackRegistry::Id, napi_ref callback) { refs.push_back(callback); });
+        for (auto it = refs.rbegin(); it != refs.rend(); ++it) {
+            napi_value callbackValue = nullptr;
+            napi_status status = napi_get_reference_value(env, *it, &callbackValue);
             if (status != napi_ok) {
                 LOG_ERROR("error! %{public}d", status);
                 continue;
             }
-            wrapper->AddWatch(env, CHANGE, callbackValue);
+            wrapper->AddWatch(env, type, callbackValue);
         }
+    };
+    auto change = g_changeCallBacks.find(objectId);
+    if (change != g_changeCallBacks.end()) {
+        LOG_INFO("restore change on %{public}s", objectId.c_str());
+        restore(CHANGE, change->second);
     } else {
         LOG_INFO("no callback %{public}s", objectId.c_str());
     }
-    if (g_statusCallBacks.count(objectId) != 0) {
+    auto statusCallbacks = g_statusCallBacks.find(objectId);
+    if (statusCallbacks != g_statusCallBacks.end()) {
         LOG_INFO("restore status on %{public}s", objectId.c_str());
-        for (auto callback : g_statusCallBacks.at(objectId)) {
-            status = napi_get_reference_value(env, callback, &callbackValue);
-            if (status != napi_ok) {
-                LOG_ERROR("error! %{public}d", status);
-                continue;
-            }
-            wrapper->AddWatch(env, STATUS, callbackValue);
-        }
+        restore(STATUS, statusCallbacks->second);
     } else {
         LOG_INFO("no status callback %{public}s", objectId.c_str());
     }
@@ -409,6 +595,164 @@ napi_value JSDistributedObjectStore::JSDeleteCallback(napi_env env, napi_callbac
     return result;
 }
 
+// function getStatistics(): ObjectStoreStatistics;
+napi_value JSDistributedObjectStore::JSGetStatistics(napi_env env, __attribute__((unused)) napi_callback_info info)
+{
+    DistributedObjectStore *objectStore =
+        DistributedObjectStore::GetInstance(JSDistributedObjectStore::GetBundleName(env));
+    ASSERT_MATCH_ELSE_RETURN_NULL(objectStore != nullptr);
+    ObjectStoreStatistics statistics = objectStore->GetStatistics();
+    // notifications still waiting for the JS thread count as pending too
+    statistics.pendingNotifications += UvQueue::GetPendingCount();
+
+    napi_value result = nullptr;
+    napi_status status = napi_create_object(env, &result);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    const std::pair<const char *, const LatencyStatistics &> latencies[] = { { "put", statistics.put },
+        { "get", statistics.get }, { "create", statistics.create }, { "destroy", statistics.destroy },
+        { "sessionOpenWait", statistics.sessionOpenWait } };
+    for (auto &[name, latency] : latencies) {
+        status = SetNamedLatency(env, result, name, latency);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    }
+    napi_value peers = nullptr;
+    status = napi_create_object(env, &peers);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    for (auto &[networkId, peer] : statistics.peers) {
+        napi_value value = nullptr;
+        status = napi_create_object(env, &value);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = SetNamedNumber(env, value, "bytesSent", peer.bytesSent);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = SetNamedNumber(env, value, "bytesReceived", peer.bytesReceived);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = SetNamedLatency(env, value, "sync", peer.sync);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = napi_set_named_property(env, peers, networkId.c_str(), value);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    }
+    status = napi_set_named_property(env, result, "peers", peers);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    status = SetNamedNumber(env, result, "pendingNotifications", statistics.pendingNotifications);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    status = SetNamedNumber(env, result, "liveSessions", statistics.liveSessions);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    napi_value init = nullptr;
+    status = napi_create_object(env, &init);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    const std::pair<const char *, uint64_t> phases[] = { { "processLabel", statistics.init.processLabel },
+        { "communicator", statistics.init.communicator }, { "storeManager", statistics.init.storeManager },
+        { "open", statistics.init.open }, { "nodeRegister", statistics.init.nodeRegister },
+        { "readyWait", statistics.init.readyWait } };
+    for (auto &[name, cost] : phases) {
+        status = SetNamedNumber(env, init, name, cost);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    }
+    status = napi_set_named_property(env, result, "init", init);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    napi_value sessions = nullptr;
+    status = napi_create_object(env, &sessions);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    for (auto &[sessionId, session] : statistics.sessions) {
+        napi_value value = nullptr;
+        status = napi_create_object(env, &value);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = SetNamedNumber(env, value, "bytes", session.bytes);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = SetNamedNumber(env, value, "fields", session.fields);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = SetNamedNumber(env, value, "suppressedWrites", session.suppressedWrites);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        napi_value resident = nullptr;
+        status = JSUtil::SetValue(env, session.resident, resident);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = napi_set_named_property(env, value, "resident", resident);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+        status = napi_set_named_property(env, sessions, sessionId.c_str(), value);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    }
+    status = napi_set_named_property(env, result, "sessions", sessions);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    const std::pair<const char *, uint64_t> memory[] = { { "residentBytes", statistics.residentBytes },
+        { "memoryBudget", statistics.memoryBudget }, { "budgetOverrun", statistics.budgetOverrun },
+        { "evictions", statistics.evictions }, { "reloads", statistics.reloads },
+        { "suppressedWrites", statistics.suppressedWrites } };
+    for (auto &[name, number] : memory) {
+        status = SetNamedNumber(env, result, name, number);
+        CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    }
+    return result;
+}
+
+// function setMemoryBudget(bytes: number): number;
+napi_value JSDistributedObjectStore::JSSetMemoryBudget(napi_env env, napi_callback_info info)
+{
+    size_t requireArgc = 1;
+    size_t argc = 1;
+    napi_value argv[1] = { 0 };
+    napi_status status = napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    ASSERT_MATCH_ELSE_RETURN_NULL(argc >= requireArgc);
+    double bytes = 0;
+    status = JSUtil::GetValue(env, argv[0], bytes);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    ASSERT_MATCH_ELSE_RETURN_NULL(bytes >= 0);
+    DistributedObjectStore *objectStore =
+        DistributedObjectStore::GetInstance(JSDistributedObjectStore::GetBundleName(env));
+    ASSERT_MATCH_ELSE_RETURN_NULL(objectStore != nullptr);
+    uint64_t overrun = objectStore->SetMemoryBudget(static_cast<uint64_t>(bytes));
+
+    napi_value result = nullptr;
+    status = napi_create_double(env, static_cast<double>(overrun), &result);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    return result;
+}
+
+// function setTraceEnabled(enabled: boolean): void;
+napi_value JSDistributedObjectStore::JSSetTraceEnabled(napi_env env, napi_callback_info info)
+{
+    size_t requireArgc = 1;
+    size_t argc = 1;
+    napi_value argv[1] = { 0 };
+    napi_status status = napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    ASSERT_MATCH_ELSE_RETURN_NULL(argc >= requireArgc);
+    bool enabled = false;
+    status = JSUtil::GetValue(env, argv[0], enabled);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    DistributedObjectStore *objectStore =
+        DistributedObjectStore::GetInstance(JSDistributedObjectStore::GetBundleName(env));
+    ASSERT_MATCH_ELSE_RETURN_NULL(objectStore != nullptr);
+    objectStore->SetTraceEnabled(enabled);
+
+    napi_value result = nullptr;
+    napi_get_undefined(env, &result);
+    return result;
+}
+
+// function exportTrace(): string;
+napi_value JSDistributedObjectStore::JSExportTrace(napi_env env, __attribute__((unused)) napi_callback_info info)
+{
+    DistributedObjectStore *objectStore =
+        DistributedObjectStore::GetInstance(JSDistributedObjectStore::GetBundleName(env));
+    ASSERT_MATCH_ELSE_RETURN_NULL(objectStore != nullptr);
+    napi_value result = nullptr;
+    napi_status status = JSUtil::SetValue(env, objectStore->ExportTrace(), result);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    return result;
+}
+
+// function getPeerCapabilities(): number;
+// the PeerCapabilities every online peer has, 0 with none online
+napi_value JSDistributedObjectStore::JSGetPeerCapabilities(
+    napi_env env, __attribute__((unused)) napi_callback_info info)
+{
+    napi_value result = nullptr;
+    napi_status status = napi_create_uint32(env, PeerCapabilities::GetInstance().GetCommon(), &result);
+    CHECK_EQUAL_WITH_RETURN_NULL(status, napi_ok);
+    return result;
+}
+
 bool JSDistributedObjectStore::CheckSyncPermission(napi_env env)
 {
     int32_t ret = Security::AccessToken::AccessTokenKit::VerifyAccessToken(
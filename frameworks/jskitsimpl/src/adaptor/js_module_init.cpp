@@ -32,10 +32,17 @@ static napi_value DistributedDataObjectExport(napi_env env, napi_value exports)
     static napi_property_descriptor desc[] = {
         DECLARE_NAPI_FUNCTION("createObjectSync", JSDistributedObjectStore::JSCreateObjectSync),
         DECLARE_NAPI_FUNCTION("destroyObjectSync", JSDistributedObjectStore::JSDestroyObjectSync),
+        DECLARE_NAPI_FUNCTION("createObject", JSDistributedObjectStore::JSCreateObject),
+        DECLARE_NAPI_FUNCTION("destroyObject", JSDistributedObjectStore::JSDestroyObject),
         DECLARE_NAPI_FUNCTION("on", JSDistributedObjectStore::JSOn),
         DECLARE_NAPI_FUNCTION("off", JSDistributedObjectStore::JSOff),
         DECLARE_NAPI_FUNCTION("recordCallback", JSDistributedObjectStore::JSRecordCallback),
         DECLARE_NAPI_FUNCTION("deleteCallback", JSDistributedObjectStore::JSDeleteCallback),
+        DECLARE_NAPI_FUNCTION("getStatistics", JSDistributedObjectStore::JSGetStatistics),
+        DECLARE_NAPI_FUNCTION("setTraceEnabled", JSDistributedObjectStore::JSSetTraceEnabled),
+        DECLARE_NAPI_FUNCTION("exportTrace", JSDistributedObjectStore::JSExportTrace),
+        DECLARE_NAPI_FUNCTION("setMemoryBudget", JSDistributedObjectStore::JSSetMemoryBudget),
+        DECLARE_NAPI_FUNCTION("getPeerCapabilities", JSDistributedObjectStore::JSGetPeerCapabilities),
     };
 
     status = napi_define_properties(env, exports, sizeof(desc) / sizeof(desc[0]), desc);
@@ -15,15 +15,29 @@
 
 #include "js_watcher.h"
 
+#include <chrono>
+#include <cinttypes>
 #include <cstring>
+#include <map>
+#include <mutex>
+#include <unordered_set>
 
 #include "js_common.h"
 #include "js_notifier_impl.h"
 #include "js_util.h"
 #include "logger.h"
 #include "objectstore_errors.h"
+#include "propagation_tracer.h"
 
 namespace OHOS::ObjectStore {
+namespace {
+constexpr std::chrono::seconds CHANGE_REPORT_INTERVAL(1);
+std::mutex g_changeReportMutex;
+std::chrono::steady_clock::time_point g_changeReportStart = std::chrono::steady_clock::now();
+uint64_t g_changeInvocations = 0;
+uint64_t g_changeMerged = 0;
+} // namespace
+
 JSWatcher::JSWatcher(const napi_env env, DistributedObjectStore *objectStore, DistributedObject *object)
     : UvQueue(env), env_(env)
 {
@@ -69,12 +83,22 @@ void JSWatcher::ProcessChange(napi_env env, std::list<void *> &args)
     napi_value global = nullptr;
     napi_value param[ARGV_SIZE];
     napi_value result;
-    napi_status status = napi_get_global(env, &global);
+    napi_status status = napi_ok;
+    // the queue is going away, only release the args
+    ASSERT_MATCH_ELSE_GOTO_ERROR(env != nullptr);
+    status = napi_get_global(env, &global);
     ASSERT_MATCH_ELSE_GOTO_ERROR(status == napi_ok);
+    MergeChange(args);
     for (auto item : args) {
         ChangeArgs *changeArgs = static_cast<ChangeArgs *>(item);
-        status = napi_get_reference_value(env, changeArgs->callback_, &callback);
+        napi_ref callbackRef = changeArgs->callbacks_->Get(changeArgs->callbackId_);
+        if (callbackRef == nullptr) {
+            continue;
+        }
+        status = napi_get_reference_value(env, callbackRef, &callback);
         ASSERT_MATCH_ELSE_GOTO_ERROR(status == napi_ok);
+        PropagationTracer::GetInstance().Record(
+            changeArgs->traceId_, PropagationTracer::DELIVER, "", changeArgs->sessionId_);
         status = JSUtil::SetValue(env, changeArgs->sessionId_, param[0]);
         ASSERT_MATCH_ELSE_GOTO_ERROR(status == napi_ok);
         JSUtil::SetValue(env, changeArgs->changeData_, param[1]);
@@ -82,7 +106,12 @@ void JSWatcher::ProcessChange(napi_env env, std::list<void *> &args)
         LOG_INFO("start %{public}s, %{public}zu", changeArgs->sessionId_.c_str(), changeArgs->changeData_.size());
         status = napi_call_function(env, global, callback, ARGV_SIZE, param, &result);
         LOG_INFO("end %{public}s, %{public}zu", changeArgs->sessionId_.c_str(), changeArgs->changeData_.size());
-        ASSERT_MATCH_ELSE_GOTO_ERROR(status == napi_ok);
+        if (status != napi_ok) {
+            // one throwing handler must not cost the others, the cache invalidator among them, their change
+            LOG_ERROR("change handler of %{public}s failed, status:%{public}d", changeArgs->sessionId_.c_str(), status);
+            napi_value exception = nullptr;
+            napi_get_and_clear_last_exception(env, &exception);
+        }
     }
 ERROR:
     for (auto item : args) {
@@ -91,6 +120,62 @@ ERROR:
     }
     args.clear();
 }
+
+void JSWatcher::MergeChange(std::list<void *> &args)
+{
+    // several syncs may land before the loop drains, call each handler once per session
+    // with the union of the changed fields, in the order they were first reported
+    struct Target {
+        ChangeArgs *args;
+        std::unordered_set<std::string> fields;
+    };
+    std::map<std::pair<CallbackRegistry::Id, std::string>, Target> targets;
+    uint64_t merged = 0;
+    for (auto it = args.begin(); it != args.end();) {
+        ChangeArgs *changeArgs = static_cast<ChangeArgs *>(*it);
+        auto key = std::make_pair(changeArgs->callbackId_, changeArgs->sessionId_);
+        auto target = targets.find(key);
+        if (target == targets.end()) {
+            targets.emplace(key, Target { changeArgs, {} });
+            ++it;
+            continue;
+        }
+        auto &fields = target->second.fields;
+        auto &changeData = target->second.args->changeData_;
+        if (fields.empty()) {
+            fields.insert(changeData.begin(), changeData.end());
+        }
+        for (auto &field : changeArgs->changeData_) {
+            if (fields.insert(field).second) {
+                changeData.push_back(field);
+            }
+        }
+        if (changeArgs->traceId_ != 0) {
+            target->second.args->traceId_ = changeArgs->traceId_;
+        }
+        delete changeArgs;
+        it = args.erase(it);
+        merged++;
+    }
+    ReportChange(args.size(), merged);
+}
+
+void JSWatcher::ReportChange(uint64_t invocations, uint64_t merged)
+{
+    std::lock_guard<std::mutex> lock(g_changeReportMutex);
+    g_changeInvocations += invocations;
+    g_changeMerged += merged;
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - g_changeReportStart);
+    if (elapsed < CHANGE_REPORT_INTERVAL) {
+        return;
+    }
+    LOG_INFO("change callbacks:%{public}" PRIu64 " merged:%{public}" PRIu64 " in %{public}lld ms",
+        g_changeInvocations, g_changeMerged, static_cast<long long>(elapsed.count()));
+    g_changeInvocations = 0;
+    g_changeMerged = 0;
+    g_changeReportStart = now;
+}
 void JSWatcher::Emit(const char *type, const std::string &sessionId, const std::vector<std::string> &changeData)
 {
     if (changeData.empty()) {
@@ -104,10 +189,13 @@ void JSWatcher::Emit(const char *type, const std::string &sessionId, const std::
         return;
     }
 
-    for (EventHandler *handler = listener->handlers_; handler != nullptr; handler = handler->next) {
-        ChangeArgs *changeArgs = new ChangeArgs(handler->callbackRef, sessionId, changeData);
+    auto &handlers = listener->handlers_;
+    uint64_t traceId = PropagationTracer::GetCurrentTrace();
+    handlers.ForEach([this, &handlers, &sessionId, &changeData, traceId](CallbackRegistry::Id id, napi_ref) {
+        ChangeArgs *changeArgs = new ChangeArgs(&handlers, id, sessionId, changeData);
+        changeArgs->traceId_ = traceId;
         CallFunction(ProcessChange, changeArgs);
-    }
+    });
 }
 
 EventListener *JSWatcher::Find(const char *type)
@@ -128,11 +216,18 @@ void JSWatcher::ProcessStatus(napi_env env, std::list<void *> &args)
     napi_value global = nullptr;
     napi_value param[ARGV_SIZE];
     napi_value result;
-    napi_status status = napi_get_global(env, &global);
+    napi_status status = napi_ok;
+    // the queue is going away, only release the args
+    ASSERT_MATCH_ELSE_GOTO_ERROR(env != nullptr);
+    status = napi_get_global(env, &global);
     ASSERT_MATCH_ELSE_GOTO_ERROR(status == napi_ok);
     for (auto item : args) {
         StatusArgs *statusArgs = static_cast<StatusArgs *>(item);
-        status = napi_get_reference_value(env, statusArgs->callback_, &callback);
+        napi_ref callbackRef = statusArgs->callbacks_->Get(statusArgs->callbackId_);
+        if (callbackRef == nullptr) {
+            continue;
+        }
+        status = napi_get_reference_value(env, callbackRef, &callback);
         ASSERT_MATCH_ELSE_GOTO_ERROR(status == napi_ok);
         status = JSUtil::SetValue(env, statusArgs->sessionId_, param[0]);
         ASSERT_MATCH_ELSE_GOTO_ERROR(status == napi_ok);
@@ -170,85 +265,27 @@ void JSWatcher::Emit(
         return;
     }
 
-    for (EventHandler *handler = listener->handlers_; handler != nullptr; handler = handler->next) {
-        StatusArgs *changeArgs = new StatusArgs(handler->callbackRef, sessionId, networkId, status);
-        CallFunction(ProcessStatus, changeArgs);
-    }
+    auto &handlers = listener->handlers_;
+    handlers.ForEach([this, &handlers, &sessionId, &networkId, &status](CallbackRegistry::Id id, napi_ref) {
+        CallFunction(ProcessStatus, new StatusArgs(&handlers, id, sessionId, networkId, status));
+    });
     return;
 }
 
-EventHandler *EventListener::Find(napi_env env, napi_value handler)
-{
-    EventHandler *result = nullptr;
-    for (EventHandler *i = handlers_; i != nullptr; i = i->next) {
-        napi_value callback = nullptr;
-        napi_get_reference_value(env, i->callbackRef, &callback);
-        bool isEquals = false;
-        napi_strict_equals(env, handler, callback, &isEquals);
-        if (isEquals) {
-            result = i;
-        }
-    }
-    return result;
-}
-
 void EventListener::Clear(napi_env env)
 {
-    for (EventHandler *i = handlers_; i != nullptr; i = handlers_) {
-        handlers_ = i->next;
-        napi_delete_reference(env, i->callbackRef);
-        delete i;
-    }
+    handlers_.Clear(env);
 }
 
 bool EventListener::Del(napi_env env, napi_value handler)
 {
-    EventHandler *temp = nullptr;
-    napi_status status;
-    for (EventHandler *i = handlers_; i != nullptr;) {
-        napi_value callback = nullptr;
-        status = napi_get_reference_value(env, i->callbackRef, &callback);
-        if (status != napi_ok) {
-            LOG_ERROR("error! %{public}d", status);
-            return false;
-        }
-        bool isEquals = false;
-        napi_strict_equals(env, handler, callback, &isEquals);
-        if (isEquals) {
-            EventHandler *delData = i;
-            i = i->next;
-            if (temp == nullptr) {
-                handlers_ = delData->next;
-            } else {
-                temp->next = delData->next;
-            }
-            napi_delete_reference(env, delData->callbackRef);
-            delete delData;
-        } else {
-            temp = i;
-            i = i->next;
-        }
-    }
-    return handlers_ == nullptr;
+    handlers_.Del(env, handler);
+    return handlers_.Empty();
 }
 
 bool EventListener::Add(napi_env env, napi_value handler)
 {
-    if (Find(env, handler) != nullptr) {
-        LOG_ERROR("has added,return");
-        return false;
-    }
-
-    if (handlers_ == nullptr) {
-        handlers_ = new EventHandler();
-        handlers_->next = nullptr;
-    } else {
-        auto temp = new EventHandler();
-        temp->next = handlers_;
-        handlers_ = temp;
-    }
-    napi_create_reference(env, handler, 1, &handlers_->callbackRef);
-    return true;
+    return handlers_.Add(env, handler);
 }
 
 void WatcherImpl::OnChanged(const std::string &sessionid, const std::vector<std::string> &changedData)
@@ -348,15 +385,15 @@ StatusEventListener::StatusEventListener(JSWatcher *watcher, const std::string &
 {
 }
 
-JSWatcher::ChangeArgs::ChangeArgs(
-    const napi_ref callback, const std::string &sessionId, const std::vector<std::string> &changeData)
-    : callback_(callback), sessionId_(sessionId), changeData_(changeData)
+JSWatcher::ChangeArgs::ChangeArgs(const CallbackRegistry *callbacks, CallbackRegistry::Id callbackId,
+    const std::string &sessionId, const std::vector<std::string> &changeData)
+    : callbacks_(callbacks), callbackId_(callbackId), sessionId_(sessionId), changeData_(changeData)
 {
 }
 
-JSWatcher::StatusArgs::StatusArgs(
-    const napi_ref callback, const std::string &sessionId, const std::string &networkId, const std::string &status)
-    : callback_(callback), sessionId_(sessionId), networkId_(networkId), status_(status)
+JSWatcher::StatusArgs::StatusArgs(const CallbackRegistry *callbacks, CallbackRegistry::Id callbackId,
+    const std::string &sessionId, const std::string &networkId, const std::string &status)
+    : callbacks_(callbacks), callbackId_(callbackId), sessionId_(sessionId), networkId_(networkId), status_(status)
 {
 }
 } // namespace OHOS::ObjectStore
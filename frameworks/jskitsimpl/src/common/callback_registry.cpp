@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "callback_registry.h"
+
+#include <atomic>
+#include <map>
+
+#include "js_util.h"
+#include "logger.h"
+
+namespace OHOS::ObjectStore {
+namespace {
+// the WeakMap of an env and its get and set as they were when it was created
+struct TagMap {
+    napi_ref map = nullptr;
+    napi_ref get = nullptr;
+    napi_ref set = nullptr;
+};
+std::mutex g_tagMapMutex;
+std::map<napi_env, TagMap> g_tagMaps;
+std::atomic<CallbackRegistry::Id> g_nextId { 1 };
+
+// a torn down env must take its map along, a later env may be allocated at the same address
+void ReleaseTagMap(void *arg)
+{
+    auto env = static_cast<napi_env>(arg);
+    std::lock_guard<std::mutex> lock(g_tagMapMutex);
+    auto it = g_tagMaps.find(env);
+    if (it == g_tagMaps.end()) {
+        return;
+    }
+    napi_delete_reference(env, it->second.map);
+    napi_delete_reference(env, it->second.get);
+    napi_delete_reference(env, it->second.set);
+    g_tagMaps.erase(it);
+}
+
+void ClearException(napi_env env)
+{
+    bool pending = false;
+    napi_is_exception_pending(env, &pending);
+    if (pending) {
+        napi_value error = nullptr;
+        napi_get_and_clear_last_exception(env, &error);
+    }
+}
+} // namespace
+
+bool CallbackRegistry::GetTagMap(napi_env env, napi_value &map, napi_value &get, napi_value &set)
+{
+    std::lock_guard<std::mutex> lock(g_tagMapMutex);
+    auto it = g_tagMaps.find(env);
+    if (it != g_tagMaps.end()) {
+        return napi_get_reference_value(env, it->second.map, &map) == napi_ok
+               && napi_get_reference_value(env, it->second.get, &get) == napi_ok
+               && napi_get_reference_value(env, it->second.set, &set) == napi_ok;
+    }
+    // get and set are kept from creation, a script patching WeakMap.prototype later does not see the tags
+    napi_value global = nullptr;
+    napi_value constructor = nullptr;
+    if (napi_get_global(env, &global) != napi_ok
+        || napi_get_named_property(env, global, "WeakMap", &constructor) != napi_ok
+        || napi_new_instance(env, constructor, 0, nullptr, &map) != napi_ok
+        || napi_get_named_property(env, map, "get", &get) != napi_ok
+        || napi_get_named_property(env, map, "set", &set) != napi_ok) {
+        LOG_ERROR("create tag map failed");
+        ClearException(env);
+        return false;
+    }
+    TagMap tagMap;
+    napi_create_reference(env, map, 1, &tagMap.map);
+    napi_create_reference(env, get, 1, &tagMap.get);
+    napi_create_reference(env, set, 1, &tagMap.set);
+    if (tagMap.map == nullptr || tagMap.get == nullptr || tagMap.set == nullptr
+        || napi_add_env_cleanup_hook(env, ReleaseTagMap, env) != napi_ok) {
+        // without the hook the map could outlive the env, callbacks of this env are found by the scan
+        LOG_ERROR("keep tag map failed");
+        napi_delete_reference(env, tagMap.map);
+        napi_delete_reference(env, tagMap.get);
+        napi_delete_reference(env, tagMap.set);
+        return false;
+    }
+    g_tagMaps.emplace(env, tagMap);
+    return true;
+}
+
+bool CallbackRegistry::GetTag(napi_env env, napi_value callback, bool create, Id &id)
+{
+    napi_value map = nullptr;
+    napi_value get = nullptr;
+    napi_value set = nullptr;
+    if (!GetTagMap(env, map, get, set)) {
+        return false;
+    }
+    // the map holds the functions weakly and leaves them as they are, frozen ones included
+    napi_value value = nullptr;
+    if (napi_call_function(env, map, get, 1, &callback, &value) != napi_ok) {
+        ClearException(env);
+        return false;
+    }
+    int64_t tag = 0;
+    if (napi_get_value_int64(env, value, &tag) == napi_ok && tag > 0) {
+        id = static_cast<Id>(tag);
+        return true;
+    }
+    if (!create) {
+        return false;
+    }
+    Id newId = g_nextId++;
+    napi_value argv[2] = { callback, nullptr };
+    napi_status status = napi_create_int64(env, static_cast<int64_t>(newId), &argv[1]);
+    LOG_ERROR_RETURN(status == napi_ok, "create tag failed", false);
+    if (napi_call_function(env, map, set, 2, argv, &value) != napi_ok) {
+        ClearException(env);
+        return false;
+    }
+    id = newId;
+    return true;
+}
+
+CallbackRegistry::Iterator CallbackRegistry::FindUntagged(napi_env env, napi_value callback)
+{
+    for (auto it = entries_.begin(); untagged_ > 0 && it != entries_.end(); ++it) {
+        if (it->tagged) {
+            continue;
+        }
+        napi_value value = nullptr;
+        bool isEquals = false;
+        if (napi_get_reference_value(env, it->callback, &value) == napi_ok
+            && napi_strict_equals(env, callback, value, &isEquals) == napi_ok && isEquals) {
+            return it;
+        }
+    }
+    return entries_.end();
+}
+
+bool CallbackRegistry::Add(napi_env env, napi_value callback)
+{
+    // the tag is read before locking, a getter can not run into the registry while it is held
+    Id id = 0;
+    bool tagged = GetTag(env, callback, true, id);
+    if (!tagged) {
+        id = g_nextId++;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool exists = tagged ? index_.count(id) != 0 : FindUntagged(env, callback) != entries_.end();
+    if (exists) {
+        LOG_ERROR("has added,return");
+        return false;
+    }
+    napi_ref ref = nullptr;
+    napi_status status = napi_create_reference(env, callback, 1, &ref);
+    LOG_ERROR_RETURN(status == napi_ok, "create reference failed", false);
+    // handlers run newest first
+    entries_.push_front(Entry { id, ref, tagged });
+    index_.emplace(id, entries_.begin());
+    if (!tagged) {
+        untagged_++;
+    }
+    return true;
+}
+
+bool CallbackRegistry::Del(napi_env env, napi_value callback)
+{
+    Id id = 0;
+    bool tagged = GetTag(env, callback, false, id);
+    napi_ref ref = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Iterator it = entries_.end();
+        if (tagged) {
+            auto found = index_.find(id);
+            it = found == index_.end() ? entries_.end() : found->second;
+        } else {
+            it = FindUntagged(env, callback);
+        }
+        if (it == entries_.end()) {
+            return false;
+        }
+        if (!it->tagged) {
+            untagged_--;
+        }
+        ref = it->callback;
+        index_.erase(it->id);
+        entries_.erase(it);
+    }
+    napi_delete_reference(env, ref);
+    return true;
+}
+
+void CallbackRegistry::Clear(napi_env env)
+{
+    std::list<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries.swap(entries_);
+        index_.clear();
+        untagged_ = 0;
+    }
+    for (auto &entry : entries) {
+        napi_delete_reference(env, entry.callback);
+    }
+}
+
+bool CallbackRegistry::Empty() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.empty();
+}
+
+size_t CallbackRegistry::Size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void CallbackRegistry::ForEach(const Visitor &visitor) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &entry : entries_) {
+        visitor(entry.id, entry.callback);
+    }
+}
+
+napi_ref CallbackRegistry::Get(Id id) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(id);
+    return it == index_.end() ? nullptr : it->second->callback;
+}
+} // namespace OHOS::ObjectStore
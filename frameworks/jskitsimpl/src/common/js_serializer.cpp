@@ -0,0 +1,547 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "js_serializer.h"
+
+#include <cmath>
+#include <endian.h>
+#include <securec.h>
+
+#include "js_util.h"
+#include "logger.h"
+
+namespace OHOS::ObjectStore {
+namespace {
+constexpr uint32_t VARINT_SHIFT = 7;
+constexpr uint8_t VARINT_MASK = 0x7F;
+constexpr uint8_t VARINT_MORE = 0x80;
+constexpr uint32_t VARINT_MAX_BYTES = 10;
+constexpr double MAX_SAFE_INTEGER = 9007199254740991.0; // 2^53 - 1, every integer up to it is exact
+constexpr const char *TO_JSON = "toJSON";
+
+size_t ElementSize(napi_typedarray_type type)
+{
+    switch (type) {
+        case napi_int8_array:
+        case napi_uint8_array:
+        case napi_uint8_clamped_array:
+            return sizeof(uint8_t);
+        case napi_int16_array:
+        case napi_uint16_array:
+            return sizeof(uint16_t);
+        case napi_int32_array:
+        case napi_uint32_array:
+        case napi_float32_array:
+            return sizeof(uint32_t);
+        case napi_float64_array:
+        case napi_bigint64_array:
+        case napi_biguint64_array:
+            return sizeof(uint64_t);
+        default:
+            return 0;
+    }
+}
+
+uint64_t ZigZag(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// JSON leaves these out of objects and turns them into null inside arrays
+bool IsSkipped(napi_valuetype type)
+{
+    return type == napi_function || type == napi_symbol || type == napi_external || type == napi_bigint;
+}
+} // namespace
+
+napi_status JSSerializer::Serialize(napi_env env, napi_value in, std::vector<uint8_t> &out)
+{
+    out.clear();
+    out.push_back(MAGIC);
+    out.push_back(VERSION);
+    Writer writer { out };
+    napi_status status = WriteValue(env, in, 0, writer);
+    LOG_DEBUG("serialize %{public}zu bytes, status %{public}d", out.size(), status);
+    return status;
+}
+
+napi_status JSSerializer::Serialize(napi_env env, napi_value in, std::vector<uint8_t> &head, Borrowed &tail)
+{
+    head.clear();
+    head.push_back(MAGIC);
+    head.push_back(VERSION);
+    tail = {};
+    Writer writer { head };
+    writer.tail = &tail;
+    napi_status status = WriteValue(env, in, 0, writer);
+    LOG_DEBUG("serialize %{public}zu + %{public}zu bytes, status %{public}d", head.size(), tail.size, status);
+    return status;
+}
+
+napi_status JSSerializer::Deserialize(napi_env env, const std::vector<uint8_t> &in, napi_value &out)
+{
+    if (in.size() <= sizeof(MAGIC) + sizeof(VERSION) || in[0] != MAGIC || in[1] != VERSION) {
+        return JSUtil::SetValue(env, in, out);
+    }
+    Reader reader(in.data() + sizeof(MAGIC) + sizeof(VERSION), in.size() - sizeof(MAGIC) - sizeof(VERSION));
+    return ReadValue(env, reader, 0, out);
+}
+
+napi_status JSSerializer::Deserialize(napi_env env, std::vector<uint8_t> &&in, size_t offset, napi_value &out)
+{
+    LOG_ERROR_RETURN(offset <= in.size(), "offset out of value!", napi_invalid_arg);
+    const uint8_t *data = in.data() + offset;
+    size_t size = in.size() - offset;
+    if (size <= sizeof(MAGIC) + sizeof(VERSION) || data[0] != MAGIC || data[1] != VERSION) {
+        LOG_ERROR_RETURN(size > 0, "empty value!", napi_invalid_arg);
+        napi_value buffer = nullptr;
+        napi_status status = JSUtil::CreateArrayBuffer(env, std::move(in), data, size, buffer);
+        LOG_ERROR_RETURN(status == napi_ok, "create array buffer failed!", status);
+        return napi_create_typedarray(env, napi_uint8_array, size, buffer, 0, &out);
+    }
+    Reader reader(data + sizeof(MAGIC) + sizeof(VERSION), size - sizeof(MAGIC) - sizeof(VERSION));
+    reader.owner = &in;
+    return ReadValue(env, reader, 0, out);
+}
+
+napi_status JSSerializer::WriteValue(napi_env env, napi_value in, uint32_t depth, Writer &writer)
+{
+    std::vector<uint8_t> &out = writer.out;
+    LOG_ERROR_RETURN(depth < MAX_DEPTH, "value nested too deep, cyclic?", napi_invalid_arg);
+    napi_valuetype type = napi_undefined;
+    napi_status status = napi_typeof(env, in, &type);
+    LOG_ERROR_RETURN(status == napi_ok, "napi_typeof failed!", status);
+    switch (type) {
+        case napi_undefined:
+            out.push_back(TAG_UNDEFINED);
+            return napi_ok;
+        case napi_null:
+            out.push_back(TAG_NULL);
+            return napi_ok;
+        case napi_boolean: {
+            bool value = false;
+            status = napi_get_value_bool(env, in, &value);
+            out.push_back(value ? TAG_TRUE : TAG_FALSE);
+            return status;
+        }
+        case napi_number:
+            return WriteNumber(env, in, writer);
+        case napi_string:
+            return WriteString(env, in, writer);
+        case napi_object:
+            break;
+        default:
+            out.push_back(TAG_NULL);
+            return napi_ok;
+    }
+    bool is = false;
+    if (napi_is_array(env, in, &is) == napi_ok && is) {
+        return WriteArray(env, in, depth, writer);
+    }
+    if (napi_is_typedarray(env, in, &is) == napi_ok && is) {
+        return WriteTypedArray(env, in, depth, writer);
+    }
+    if (napi_is_arraybuffer(env, in, &is) == napi_ok && is) {
+        return WriteArrayBuffer(env, in, depth, writer);
+    }
+    napi_value toJson = nullptr;
+    napi_valuetype toJsonType = napi_undefined;
+    if (napi_get_named_property(env, in, TO_JSON, &toJson) == napi_ok
+        && napi_typeof(env, toJson, &toJsonType) == napi_ok && toJsonType == napi_function) {
+        // Date and friends, keep what JSON.stringify used to store
+        napi_value json = nullptr;
+        status = napi_call_function(env, in, toJson, 0, nullptr, &json);
+        LOG_ERROR_RETURN(status == napi_ok, "toJSON failed!", status);
+        return WriteValue(env, json, depth + 1, writer);
+    }
+    return WriteObject(env, in, depth, writer);
+}
+
+napi_status JSSerializer::WriteNumber(napi_env env, napi_value in, Writer &writer)
+{
+    std::vector<uint8_t> &out = writer.out;
+    double value = 0;
+    napi_status status = napi_get_value_double(env, in, &value);
+    LOG_ERROR_RETURN(status == napi_ok, "napi_get_value_double failed!", status);
+    if (std::fabs(value) <= MAX_SAFE_INTEGER && std::trunc(value) == value && !(value == 0 && std::signbit(value))) {
+        out.push_back(TAG_INT);
+        WriteVarint(ZigZag(static_cast<int64_t>(value)), out);
+        return napi_ok;
+    }
+    uint64_t bits = 0;
+    static_assert(sizeof(bits) == sizeof(value), "double is not 64 bits");
+    (void)memcpy_s(&bits, sizeof(bits), &value, sizeof(value));
+    bits = htole64(bits);
+    out.push_back(TAG_DOUBLE);
+    WriteBytes(&bits, sizeof(bits), out);
+    return napi_ok;
+}
+
+napi_status JSSerializer::WriteString(napi_env env, napi_value in, Writer &writer)
+{
+    std::vector<uint8_t> &out = writer.out;
+    size_t length = 0;
+    napi_status status = napi_get_value_string_utf8(env, in, nullptr, 0, &length);
+    LOG_ERROR_RETURN(status == napi_ok, "get string length failed!", status);
+    out.push_back(TAG_STRING);
+    WriteVarint(length, out);
+    size_t offset = out.size();
+    // napi always writes the terminating zero, let it land in the buffer and drop it afterwards
+    out.resize(offset + length + 1);
+    status = napi_get_value_string_utf8(env, in, reinterpret_cast<char *>(out.data() + offset), length + 1, &length);
+    out.resize(offset + length);
+    return status;
+}
+
+napi_status JSSerializer::WriteArray(napi_env env, napi_value in, uint32_t depth, Writer &writer)
+{
+    std::vector<uint8_t> &out = writer.out;
+    uint32_t length = 0;
+    napi_status status = napi_get_array_length(env, in, &length);
+    LOG_ERROR_RETURN(status == napi_ok, "napi_get_array_length failed!", status);
+    out.push_back(TAG_ARRAY);
+    WriteVarint(length, out);
+    for (uint32_t i = 0; i < length; i++) {
+        napi_value element = nullptr;
+        status = napi_get_element(env, in, i, &element);
+        LOG_ERROR_RETURN(status == napi_ok, "napi_get_element failed!", status);
+        status = WriteValue(env, element, depth + 1, writer);
+        if (status != napi_ok) {
+            return status;
+        }
+    }
+    return napi_ok;
+}
+
+napi_status JSSerializer::WriteObject(napi_env env, napi_value in, uint32_t depth, Writer &writer)
+{
+    std::vector<uint8_t> &out = writer.out;
+    napi_value names = nullptr;
+    napi_status status = napi_get_property_names(env, in, &names);
+    LOG_ERROR_RETURN(status == napi_ok, "napi_get_property_names failed!", status);
+    uint32_t length = 0;
+    status = napi_get_array_length(env, names, &length);
+    LOG_ERROR_RETURN(status == napi_ok, "napi_get_array_length failed!", status);
+    std::vector<std::pair<napi_value, napi_value>> fields;
+    fields.reserve(length);
+    for (uint32_t i = 0; i < length; i++) {
+        napi_value name = nullptr;
+        napi_value value = nullptr;
+        napi_valuetype type = napi_undefined;
+        status = napi_get_element(env, names, i, &name);
+        LOG_ERROR_RETURN(status == napi_ok, "napi_get_element failed!", status);
+        status = napi_get_property(env, in, name, &value);
+        LOG_ERROR_RETURN(status == napi_ok, "napi_get_property failed!", status);
+        status = napi_typeof(env, value, &type);
+        LOG_ERROR_RETURN(status == napi_ok, "napi_typeof failed!", status);
+        if (!IsSkipped(type)) {
+            fields.emplace_back(name, value);
+        }
+    }
+    out.push_back(TAG_OBJECT);
+    WriteVarint(fields.size(), out);
+    for (auto &[name, value] : fields) {
+        napi_value key = nullptr;
+        status = napi_coerce_to_string(env, name, &key);
+        LOG_ERROR_RETURN(status == napi_ok, "napi_coerce_to_string failed!", status);
+        status = WriteKey(env, key, writer);
+        LOG_ERROR_RETURN(status == napi_ok, "write key failed!", status);
+        status = WriteValue(env, value, depth + 1, writer);
+        if (status != napi_ok) {
+            return status;
+        }
+    }
+    return napi_ok;
+}
+
+napi_status JSSerializer::WriteKey(napi_env env, napi_value in, Writer &writer)
+{
+    size_t length = 0;
+    napi_status status = napi_get_value_string_utf8(env, in, nullptr, 0, &length);
+    LOG_ERROR_RETURN(status == napi_ok, "get key length failed!", status);
+    std::string key(length + 1, '\0');
+    status = napi_get_value_string_utf8(env, in, key.data(), key.size(), &length);
+    LOG_ERROR_RETURN(status == napi_ok, "get key failed!", status);
+    key.resize(length);
+    // the low bit tells a back reference from a new name
+    auto it = writer.keys.find(key);
+    if (it != writer.keys.end()) {
+        WriteVarint((it->second << 1) | 1, writer.out);
+        return napi_ok;
+    }
+    WriteVarint(static_cast<uint64_t>(length) << 1, writer.out);
+    WriteBytes(key.data(), length, writer.out);
+    writer.keys.emplace(std::move(key), writer.keys.size());
+    return napi_ok;
+}
+
+napi_status JSSerializer::WriteTypedArray(napi_env env, napi_value in, uint32_t depth, Writer &writer)
+{
+    std::vector<uint8_t> &out = writer.out;
+    napi_typedarray_type type = napi_uint8_array;
+    size_t length = 0;
+    void *data = nullptr;
+    napi_value buffer = nullptr;
+    size_t offset = 0;
+    napi_status status = napi_get_typedarray_info(env, in, &type, &length, &data, &buffer, &offset);
+    LOG_ERROR_RETURN(status == napi_ok, "napi_get_typedarray_info failed!", status);
+    size_t elementSize = ElementSize(type);
+    LOG_ERROR_RETURN(elementSize != 0, "unknown typed array!", napi_invalid_arg);
+    out.push_back(TAG_TYPED_ARRAY);
+    out.push_back(static_cast<uint8_t>(type));
+    WriteVarint(length, out);
+    WritePayload(data, length * elementSize, depth, writer);
+    return napi_ok;
+}
+
+napi_status JSSerializer::WriteArrayBuffer(napi_env env, napi_value in, uint32_t depth, Writer &writer)
+{
+    std::vector<uint8_t> &out = writer.out;
+    void *data = nullptr;
+    size_t length = 0;
+    napi_status status = napi_get_arraybuffer_info(env, in, &data, &length);
+    LOG_ERROR_RETURN(status == napi_ok, "napi_get_arraybuffer_info failed!", status);
+    out.push_back(TAG_ARRAY_BUFFER);
+    WriteVarint(length, out);
+    WritePayload(data, length, depth, writer);
+    return napi_ok;
+}
+
+void JSSerializer::WritePayload(const void *data, size_t size, uint32_t depth, Writer &writer)
+{
+    // nothing follows the bytes of the top-level value, so they can stay where they are
+    if (depth == 0 && writer.tail != nullptr) {
+        *writer.tail = { static_cast<const uint8_t *>(data), size };
+        return;
+    }
+    WriteBytes(data, size, writer.out);
+}
+
+void JSSerializer::WriteVarint(uint64_t value, std::vector<uint8_t> &out)
+{
+    while (value > VARINT_MASK) {
+        out.push_back(static_cast<uint8_t>(value & VARINT_MASK) | VARINT_MORE);
+        value >>= VARINT_SHIFT;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void JSSerializer::WriteBytes(const void *data, size_t size, std::vector<uint8_t> &out)
+{
+    if (size == 0) {
+        return;
+    }
+    auto begin = static_cast<const uint8_t *>(data);
+    out.insert(out.end(), begin, begin + size);
+}
+
+napi_status JSSerializer::ReadValue(napi_env env, Reader &reader, uint32_t depth, napi_value &out)
+{
+    LOG_ERROR_RETURN(depth < MAX_DEPTH, "value nested too deep!", napi_invalid_arg);
+    uint8_t tag = TAG_UNDEFINED;
+    LOG_ERROR_RETURN(reader.ReadByte(tag), "truncated value!", napi_invalid_arg);
+    switch (tag) {
+        case TAG_UNDEFINED:
+            return napi_get_undefined(env, &out);
+        case TAG_NULL:
+            return napi_get_null(env, &out);
+        case TAG_FALSE:
+        case TAG_TRUE:
+            return napi_get_boolean(env, tag == TAG_TRUE, &out);
+        case TAG_INT: {
+            uint64_t value = 0;
+            LOG_ERROR_RETURN(reader.ReadVarint(value), "truncated int!", napi_invalid_arg);
+            return napi_create_double(env, static_cast<double>(UnZigZag(value)), &out);
+        }
+        case TAG_DOUBLE: {
+            const uint8_t *data = nullptr;
+            uint64_t bits = 0;
+            double value = 0;
+            LOG_ERROR_RETURN(reader.ReadBytes(sizeof(bits), data), "truncated double!", napi_invalid_arg);
+            (void)memcpy_s(&bits, sizeof(bits), data, sizeof(bits));
+            bits = le64toh(bits);
+            (void)memcpy_s(&value, sizeof(value), &bits, sizeof(bits));
+            return napi_create_double(env, value, &out);
+        }
+        case TAG_STRING:
+            return ReadString(env, reader, out);
+        case TAG_ARRAY:
+            return ReadArray(env, reader, depth, out);
+        case TAG_OBJECT:
+            return ReadObject(env, reader, depth, out);
+        case TAG_TYPED_ARRAY:
+            return ReadTypedArray(env, reader, depth, out);
+        case TAG_ARRAY_BUFFER:
+            return ReadArrayBuffer(env, reader, depth, out);
+        default:
+            LOG_ERROR("unknown tag %{public}d", tag);
+            return napi_invalid_arg;
+    }
+}
+
+napi_status JSSerializer::ReadString(napi_env env, Reader &reader, napi_value &out)
+{
+    uint64_t length = 0;
+    const uint8_t *data = nullptr;
+    LOG_ERROR_RETURN(reader.ReadVarint(length) && reader.ReadBytes(length, data), "truncated string!",
+        napi_invalid_arg);
+    return napi_create_string_utf8(env, reinterpret_cast<const char *>(data), length, &out);
+}
+
+napi_status JSSerializer::ReadArray(napi_env env, Reader &reader, uint32_t depth, napi_value &out)
+{
+    uint64_t length = 0;
+    LOG_ERROR_RETURN(reader.ReadVarint(length) && length <= UINT32_MAX, "bad array length!", napi_invalid_arg);
+    napi_status status = napi_create_array_with_length(env, length, &out);
+    LOG_ERROR_RETURN(status == napi_ok, "napi_create_array_with_length failed!", status);
+    for (uint32_t i = 0; i < length; i++) {
+        napi_value element = nullptr;
+        status = ReadValue(env, reader, depth + 1, element);
+        if (status != napi_ok) {
+            return status;
+        }
+        status = napi_set_element(env, out, i, element);
+        LOG_ERROR_RETURN(status == napi_ok, "napi_set_element failed!", status);
+    }
+    return napi_ok;
+}
+
+napi_status JSSerializer::ReadObject(napi_env env, Reader &reader, uint32_t depth, napi_value &out)
+{
+    uint64_t count = 0;
+    LOG_ERROR_RETURN(reader.ReadVarint(count), "bad field count!", napi_invalid_arg);
+    napi_status status = napi_create_object(env, &out);
+    LOG_ERROR_RETURN(status == napi_ok, "napi_create_object failed!", status);
+    for (uint64_t i = 0; i < count; i++) {
+        napi_value key = nullptr;
+        napi_value value = nullptr;
+        status = ReadKey(env, reader, key);
+        if (status != napi_ok) {
+            return status;
+        }
+        status = ReadValue(env, reader, depth + 1, value);
+        if (status != napi_ok) {
+            return status;
+        }
+        status = napi_set_property(env, out, key, value);
+        LOG_ERROR_RETURN(status == napi_ok, "napi_set_property failed!", status);
+    }
+    return napi_ok;
+}
+
+napi_status JSSerializer::ReadKey(napi_env env, Reader &reader, napi_value &out)
+{
+    uint64_t value = 0;
+    LOG_ERROR_RETURN(reader.ReadVarint(value), "truncated field name!", napi_invalid_arg);
+    if ((value & 1) != 0) {
+        uint64_t index = value >> 1;
+        LOG_ERROR_RETURN(index < reader.keys.size(), "bad field name reference!", napi_invalid_arg);
+        out = reader.keys[index];
+        return napi_ok;
+    }
+    const uint8_t *data = nullptr;
+    size_t length = value >> 1;
+    LOG_ERROR_RETURN(reader.ReadBytes(length, data), "truncated field name!", napi_invalid_arg);
+    napi_status status = napi_create_string_utf8(env, reinterpret_cast<const char *>(data), length, &out);
+    LOG_ERROR_RETURN(status == napi_ok, "create field name failed!", status);
+    reader.keys.push_back(out);
+    return napi_ok;
+}
+
+napi_status JSSerializer::ReadTypedArray(napi_env env, Reader &reader, uint32_t depth, napi_value &out)
+{
+    uint8_t type = 0;
+    uint64_t length = 0;
+    LOG_ERROR_RETURN(reader.ReadByte(type) && reader.ReadVarint(length), "truncated typed array!", napi_invalid_arg);
+    size_t elementSize = ElementSize(static_cast<napi_typedarray_type>(type));
+    LOG_ERROR_RETURN(elementSize != 0 && length <= SIZE_MAX / elementSize, "bad typed array!", napi_invalid_arg);
+    const uint8_t *data = nullptr;
+    size_t size = length * elementSize;
+    LOG_ERROR_RETURN(reader.ReadBytes(size, data), "truncated typed array!", napi_invalid_arg);
+    // a view needs its elements aligned, only bytes can be viewed wherever they landed in the value
+    bool aligned = reinterpret_cast<uintptr_t>(data) % elementSize == 0;
+    napi_value arrayBuffer = nullptr;
+    napi_status status = ReadPayload(env, reader, depth == 0 && aligned, data, size, arrayBuffer);
+    if (status != napi_ok) {
+        return status;
+    }
+    return napi_create_typedarray(env, static_cast<napi_typedarray_type>(type), length, arrayBuffer, 0, &out);
+}
+
+napi_status JSSerializer::ReadArrayBuffer(napi_env env, Reader &reader, uint32_t depth, napi_value &out)
+{
+    uint64_t size = 0;
+    const uint8_t *data = nullptr;
+    LOG_ERROR_RETURN(reader.ReadVarint(size) && reader.ReadBytes(size, data), "truncated array buffer!",
+        napi_invalid_arg);
+    return ReadPayload(env, reader, depth == 0, data, size, out);
+}
+
+napi_status JSSerializer::ReadPayload(
+    napi_env env, Reader &reader, bool topLevel, const uint8_t *data, size_t size, napi_value &out)
+{
+    // nothing else in the value refers to the bytes of the top-level value, hand it all over
+    if (topLevel && reader.owner != nullptr) {
+        return JSUtil::CreateArrayBuffer(env, std::move(*reader.owner), data, size, out);
+    }
+    void *buffer = nullptr;
+    napi_status status = napi_create_arraybuffer(env, size, &buffer, &out);
+    LOG_ERROR_RETURN(status == napi_ok, "create array buffer failed!", status);
+    if (size > 0 && memcpy_s(buffer, size, data, size) != EOK) {
+        LOG_ERROR("memcpy_s not EOK");
+        return napi_invalid_arg;
+    }
+    return napi_ok;
+}
+
+bool JSSerializer::Reader::ReadByte(uint8_t &value)
+{
+    if (offset_ >= size_) {
+        return false;
+    }
+    value = data_[offset_++];
+    return true;
+}
+
+bool JSSerializer::Reader::ReadVarint(uint64_t &value)
+{
+    value = 0;
+    for (uint32_t i = 0; i < VARINT_MAX_BYTES; i++) {
+        uint8_t byte = 0;
+        if (!ReadByte(byte)) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(byte & VARINT_MASK) << (i * VARINT_SHIFT);
+        if ((byte & VARINT_MORE) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JSSerializer::Reader::ReadBytes(size_t size, const uint8_t *&value)
+{
+    if (size > size_ - offset_) {
+        return false;
+    }
+    value = data_ + offset_;
+    offset_ += size;
+    return true;
+}
+} // namespace OHOS::ObjectStore
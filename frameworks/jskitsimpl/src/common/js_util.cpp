@@ -20,8 +20,9 @@
 #include "logger.h"
 
 namespace OHOS::ObjectStore {
-constexpr int32_t STR_MAX_LENGTH = 4096;
+constexpr size_t STR_STACK_LENGTH = 256;
 constexpr size_t STR_TAIL_LENGTH = 1;
+constexpr size_t UTF8_CHAR_MAX_LENGTH = 4;
 
 /* napi_value <-> bool */
 napi_status JSUtil::GetValue(napi_env env, napi_value in, bool &out)
@@ -52,25 +53,31 @@ napi_status JSUtil::SetValue(napi_env env, const double &in, napi_value &out)
 /* napi_value <-> std::string */
 napi_status JSUtil::GetValue(napi_env env, napi_value in, std::string &out)
 {
-    size_t maxLen = STR_MAX_LENGTH;
-    napi_status status = napi_get_value_string_utf8(env, in, NULL, 0, &maxLen);
-    if (maxLen <= 0) {
+    // keys and most values fit on the stack and cost a single napi call
+    char buf[STR_STACK_LENGTH];
+    size_t len = 0;
+    napi_status status = napi_get_value_string_utf8(env, in, buf, sizeof(buf), &len);
+    if (status != napi_ok) {
         GET_AND_THROW_LAST_ERROR(env);
         return status;
     }
-    char *buf = new (std::nothrow) char[maxLen + STR_TAIL_LENGTH];
-    if (buf != nullptr) {
-        size_t len = 0;
-        status = napi_get_value_string_utf8(env, in, buf, maxLen + STR_TAIL_LENGTH, &len);
-        if (status != napi_ok) {
-            GET_AND_THROW_LAST_ERROR(env);
-        }
-        buf[len] = 0;
-        out = std::string(buf);
-        delete[] buf;
-    } else {
-        status = napi_generic_failure;
+    // napi stops before a character that does not fit, so only a buffer with room for one more is complete
+    if (len + UTF8_CHAR_MAX_LENGTH + STR_TAIL_LENGTH <= sizeof(buf)) {
+        out.assign(buf, len);
+        return status;
+    }
+    status = napi_get_value_string_utf8(env, in, nullptr, 0, &len);
+    if (status != napi_ok) {
+        GET_AND_THROW_LAST_ERROR(env);
+        return status;
+    }
+    // write straight into the destination, the terminating zero lands in the slot std::string keeps for it
+    out.resize(len);
+    status = napi_get_value_string_utf8(env, in, out.data(), len + STR_TAIL_LENGTH, &len);
+    if (status != napi_ok) {
+        GET_AND_THROW_LAST_ERROR(env);
     }
+    out.resize(len);
     return status;
 }
 
@@ -155,4 +162,35 @@ napi_status JSUtil::SetValue(napi_env env, const std::vector<uint8_t> &in, napi_
     LOG_ERROR_RETURN((status == napi_ok), "napi_value <- std::vector<uint8_t> invalid value", status);
     return status;
 }
+
+napi_status JSUtil::CreateArrayBuffer(
+    napi_env env, std::vector<uint8_t> &&owner, const uint8_t *data, size_t size, napi_value &out)
+{
+    LOG_ERROR_RETURN(size == 0 || (data >= owner.data() && data + size <= owner.data() + owner.size()),
+        "data out of owner!", napi_invalid_arg);
+    if (size > 0) {
+        // moving a vector keeps its buffer, so data stays valid until the ArrayBuffer is collected
+        auto holder = new (std::nothrow) std::vector<uint8_t>(std::move(owner));
+        LOG_ERROR_RETURN(holder != nullptr, "new holder failed!", napi_generic_failure);
+        napi_status status = napi_create_external_arraybuffer(
+            env, const_cast<uint8_t *>(data), size,
+            [](napi_env, void *, void *hint) { delete static_cast<std::vector<uint8_t> *>(hint); }, holder,
+            &out);
+        if (status == napi_ok) {
+            return status;
+        }
+        // engines that keep ArrayBuffers in their own heap refuse external memory, copy it there
+        LOG_DEBUG("external array buffer refused %{public}d, copy %{public}zu bytes", status, size);
+        owner = std::move(*holder);
+        delete holder;
+    }
+    void *buffer = nullptr;
+    napi_status status = napi_create_arraybuffer(env, size, &buffer, &out);
+    LOG_ERROR_RETURN(status == napi_ok, "create array buffer failed!", status);
+    if (size > 0 && memcpy_s(buffer, size, data, size) != EOK) {
+        LOG_ERROR("memcpy_s not EOK");
+        return napi_invalid_arg;
+    }
+    return status;
+}
 } // namespace OHOS::ObjectStore
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "lifecycle_queue.h"
+
+#include <cinttypes>
+
+#include "logger.h"
+
+namespace OHOS::ObjectStore {
+LifecycleQueue &LifecycleQueue::GetInstance()
+{
+    static LifecycleQueue instance;
+    return instance;
+}
+
+uint64_t LifecycleQueue::Push(Task task)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+    return pushed_++;
+}
+
+void LifecycleQueue::RunUntil(uint64_t ticket)
+{
+    // one runner at a time keeps the order, the others wait here until their task is done
+    std::lock_guard<std::mutex> runLock(runMutex_);
+    while (true) {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (done_ > ticket || tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_++;
+    }
+}
+
+void LifecycleQueue::Defer(Task task)
+{
+    uint64_t ticket = Push(std::move(task));
+    if (!background_.Post([this, ticket]() { RunUntil(ticket); })) {
+        LOG_WARN("background stopped, run %{public}" PRIu64 " in place", ticket);
+        RunUntil(ticket);
+    }
+}
+
+size_t LifecycleQueue::Size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+} // namespace OHOS::ObjectStore
@@ -14,16 +14,45 @@
  */
 #include "uv_queue.h"
 
+#include <cinttypes>
+#include <thread>
+#include <vector>
+
 #include "logger.h"
 
 namespace OHOS::ObjectStore {
+namespace {
+constexpr uint64_t REPORT_INTERVAL = 1024; // log the delivery statistics every so many notifications
+std::atomic<uint64_t> g_pending { 0 };
+} // namespace
+
 UvQueue::UvQueue(napi_env env) : env_(env)
 {
     napi_get_uv_event_loop(env, &loop_);
+    async_ = new (std::nothrow) uv_async_t;
+    if (async_ == nullptr || loop_ == nullptr || uv_async_init(loop_, async_, OnAsync) != 0) {
+        LOG_ERROR("init uv async failed");
+        delete async_;
+        async_ = nullptr;
+        return;
+    }
+    async_->data = this;
 }
 
 UvQueue::~UvQueue()
 {
+    closing_.store(true);
+    // producers that already passed the closing check still push, wait for them
+    while (inflight_.load() != 0) {
+        std::this_thread::yield();
+    }
+    Drain(nullptr);
+    if (async_ != nullptr) {
+        async_->data = nullptr;
+        uv_close(reinterpret_cast<uv_handle_t *>(async_),
+            [](uv_handle_t *handle) { delete reinterpret_cast<uv_async_t *>(handle); });
+        async_ = nullptr;
+    }
     LOG_DEBUG("no memory leak for queue-callback");
 }
 
@@ -33,39 +62,121 @@ void UvQueue::CallFunction(Process process, void *argv)
         LOG_ERROR("nullptr");
         return;
     }
-    uv_work_t *work = new (std::nothrow) uv_work_t;
-    if (work == nullptr) {
-        LOG_ERROR("no memory for uv_work_t");
+    inflight_.fetch_add(1);
+    if (closing_.load() || async_ == nullptr) {
+        inflight_.fetch_sub(1);
+        std::list<void *> args = { argv };
+        process(nullptr, args);
+        return;
+    }
+    Node *node = new (std::nothrow) Node;
+    if (node == nullptr) {
+        inflight_.fetch_sub(1);
+        LOG_ERROR("no memory for node");
+        std::list<void *> args = { argv };
+        process(nullptr, args);
         return;
     }
-    work->data = this;
-    {
-        std::unique_lock<std::shared_mutex> cacheLock(mutex_);
-        if (args_.count(process) != 0) {
-            std::list<void *> newData = args_.at(process);
-            newData.push_back(argv);
-            args_.insert_or_assign(process, newData);
-        } else {
-            std::list<void *> data;
-            data.push_back(argv);
-            args_.insert_or_assign(process, data);
+    node->process = process;
+    node->argv = argv;
+    node->enqueueTime = std::chrono::steady_clock::now();
+    g_pending.fetch_add(1, std::memory_order_relaxed);
+    Push(node);
+    uv_async_send(async_);
+    inflight_.fetch_sub(1);
+}
+
+HistogramSnapshot UvQueue::GetLatency() const
+{
+    return latency_.Snapshot();
+}
+
+uint64_t UvQueue::GetPendingCount()
+{
+    return g_pending.load(std::memory_order_relaxed);
+}
+
+void UvQueue::Push(Node *node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+UvQueue::Node *UvQueue::Pop()
+{
+    Node *tail = tail_;
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+        if (next == nullptr) {
+            return nullptr;
         }
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+        tail_ = next;
+        return tail;
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+        // a producer is between exchange and link, its uv_async_send wakes us again
+        return nullptr;
     }
+    Push(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        tail_ = next;
+        return tail;
+    }
+    return nullptr;
+}
 
-    uv_queue_work(
-        loop_, work, [](uv_work_t *work) {},
-        [](uv_work_t *work, int uvstatus) {
-            auto queue = static_cast<UvQueue *>(work->data);
-            {
-                std::unique_lock<std::shared_mutex> cacheLock(queue->mutex_);
-                for (auto &item : queue->args_) {
-                    item.first(queue->env_, item.second);
-                }
-                queue->args_.clear();
-            }
+void UvQueue::OnAsync(uv_async_t *async)
+{
+    auto queue = static_cast<UvQueue *>(async->data);
+    if (queue == nullptr) {
+        return;
+    }
+    queue->Drain(queue->env_);
+}
 
-            delete work;
-            work = nullptr;
-        });
+void UvQueue::Drain(napi_env env)
+{
+    // group by process in first seen order, so each process handles its whole batch at once
+    std::vector<std::pair<Process, std::list<void *>>> batches;
+    auto now = std::chrono::steady_clock::now();
+    uint64_t count = 0;
+    for (Node *node = Pop(); node != nullptr; node = Pop()) {
+        auto it = batches.begin();
+        while (it != batches.end() && it->first != node->process) {
+            ++it;
+        }
+        if (it == batches.end()) {
+            batches.emplace_back(node->process, std::list<void *>());
+            it = batches.end() - 1;
+        }
+        it->second.push_back(node->argv);
+        if (node->enqueueTime > now) {
+            // pushed while draining
+            now = std::chrono::steady_clock::now();
+        }
+        latency_.Record(std::chrono::duration_cast<std::chrono::microseconds>(now - node->enqueueTime).count());
+        delete node;
+        count++;
+    }
+    for (auto &batch : batches) {
+        batch.first(env, batch.second);
+    }
+    g_pending.fetch_sub(count, std::memory_order_relaxed);
+    if (count == 0 || env == nullptr) {
+        return;
+    }
+    wakeups_++;
+    uint64_t total = notifications_.fetch_add(count) + count;
+    if (total / REPORT_INTERVAL != (total - count) / REPORT_INTERVAL) {
+        LOG_INFO("notifications:%{public}" PRIu64 ", wakeups:%{public}" PRIu64 ", latency us %{public}s", total,
+            wakeups_, latency_.Snapshot().ToString().c_str());
+    }
 }
 } // namespace OHOS::ObjectStore
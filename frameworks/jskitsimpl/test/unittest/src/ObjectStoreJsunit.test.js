@@ -587,6 +587,180 @@ describe('objectStoreTest', function () {
         console.log(TAG + "************* testComplex001 end *************");
     })
 
+    /**
+     * @tc.name: testComplex002
+     * @tc.desc: nested objects, arrays and binary values round trip through the session
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testComplex002', 0, function (done) {
+        console.log(TAG + "************* testComplex002 start *************");
+        var note_object = distributedObject.createDistributedObject({ documentList: undefined, thumbnail: undefined });
+        note_object.setSessionId("session16");
+        expect(note_object.__sessionId).assertEqual("session16");
+        var documentList = [];
+        for (var i = 0; i < 1024; i++) {
+            documentList.push({ title: "note" + i, content: "x".repeat(1000), createTime: 1650000000000 + i,
+                isShared: i % 2 == 0 });
+        }
+        note_object.documentList = documentList;
+        note_object.setSessionId("");
+        note_object.setSessionId("session16");
+        var result = note_object.documentList;
+        expect(result.length).assertEqual(documentList.length);
+        expect(result[1023].title).assertEqual("note1023");
+        expect(result[1023].createTime).assertEqual(1650000001023);
+        expect(result[1022].isShared).assertEqual(true);
+        note_object.thumbnail = new Uint8Array([1, 2, 3]);
+        expect(note_object.thumbnail instanceof Uint8Array).assertTrue();
+        expect(note_object.thumbnail[2]).assertEqual(3);
+        note_object.setSessionId("");
+        done()
+        console.log(TAG + "************* testComplex002 end *************");
+    })
+
+    /**
+     * @tc.name: testComplex003
+     * @tc.desc: large binary and typed array values round trip without losing their content
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testComplex003', 0, function (done) {
+        console.log(TAG + "************* testComplex003 start *************");
+        var blob_object = distributedObject.createDistributedObject({ image: undefined, samples: undefined });
+        blob_object.setSessionId("session20");
+        expect(blob_object.__sessionId).assertEqual("session20");
+        // 2MB image, 1MB of doubles
+        var image = new Uint8Array(2 * 1024 * 1024);
+        for (var i = 0; i < image.length; i += 1024) {
+            image[i] = i % 251;
+        }
+        var samples = new Float64Array(128 * 1024);
+        samples[1] = -1.25;
+        samples[samples.length - 1] = 0.5;
+        blob_object.image = image;
+        blob_object.samples = samples;
+        blob_object.setSessionId("");
+        blob_object.setSessionId("session20");
+        var result = blob_object.image;
+        expect(result instanceof Uint8Array).assertTrue();
+        expect(result.length).assertEqual(image.length);
+        expect(result[1024 * 100]).assertEqual(image[1024 * 100]);
+        // other typed arrays keep their type only while every peer decodes the binary encoding
+        expect(blob_object.samples[1]).assertEqual(-1.25);
+        expect(blob_object.samples[samples.length - 1]).assertEqual(0.5);
+        blob_object.setSessionId("");
+        done()
+        console.log(TAG + "************* testComplex003 end *************");
+    })
+
+    /**
+     * @tc.name: testNestedPath001
+     * @tc.desc: editing one element of a large list rewrites only that element and reads back consistently
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testNestedPath001', 0, function (done) {
+        console.log(TAG + "************* testNestedPath001 start *************");
+        var note_object = distributedObject.createDistributedObject({ documentList: undefined });
+        note_object.setSessionId("session17");
+        expect(note_object.__sessionId).assertEqual("session17");
+        var documentList = [];
+        for (var i = 0; i < 1000; i++) {
+            documentList.push({ title: "note" + i, content: "x".repeat(1000) });
+        }
+        note_object.documentList = documentList;
+        var list = note_object.documentList;
+        list[3].title = "note3!";
+        note_object.documentList = list;
+        note_object.setSessionId("");
+        note_object.setSessionId("session17");
+        list = note_object.documentList;
+        expect(list.length).assertEqual(1000);
+        expect(list[3].title).assertEqual("note3!");
+        expect(list[4].title).assertEqual("note4");
+        note_object.setSessionId("");
+        done()
+        console.log(TAG + "************* testNestedPath001 end *************");
+    })
+
+    /**
+     * @tc.name: testManyFields001
+     * @tc.desc: an object with 100 fields joins and leaves a session with its values intact
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testManyFields001', 0, function (done) {
+        console.log(TAG + "************* testManyFields001 start *************");
+        var fields = {};
+        for (var i = 0; i < 100; i++) {
+            fields["field" + i] = i % 2 == 0 ? "value" + i : i;
+        }
+        var g_object = distributedObject.createDistributedObject(fields);
+        g_object.setSessionId("session18");
+        expect(g_object.__sessionId).assertEqual("session18");
+        g_object.field99 = 100;
+        g_object.setSessionId("");
+        expect(g_object.field98).assertEqual("value98");
+        expect(g_object.field99).assertEqual(100);
+        done()
+        console.log(TAG + "************* testManyFields001 end *************");
+    })
+
+    /**
+     * @tc.name: testLongKey001
+     * @tc.desc: keys longer than 64 bytes and multibyte keys are stored and read back without truncation
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testLongKey001', 0, function (done) {
+        console.log(TAG + "************* testLongKey001 start *************");
+        var longKey = "k".repeat(300);
+        var wideKey = "\u540d\u5b57".repeat(100);
+        var fields = { name: "Amy" };
+        fields[longKey] = "long";
+        fields[wideKey] = 1;
+        var g_object = distributedObject.createDistributedObject(fields);
+        g_object.setSessionId("session19");
+        expect(g_object.__sessionId).assertEqual("session19");
+        g_object[longKey] = "changed";
+        g_object[wideKey] = 2;
+        expect(g_object[longKey]).assertEqual("changed");
+        expect(g_object[wideKey]).assertEqual(2);
+        g_object.setSessionId("");
+        expect(g_object[longKey]).assertEqual("changed");
+        expect(g_object[wideKey]).assertEqual(2);
+        done()
+        console.log(TAG + "************* testLongKey001 end *************");
+    })
+
+    /**
+     * @tc.name: testAsyncSession001
+     * @tc.desc: join and leave a session with a callback, storage is opened and closed off the JS thread
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testAsyncSession001', 0, function (done) {
+        console.log(TAG + "************* testAsyncSession001 start *************");
+        var g_object = distributedObject.createDistributedObject({ name: "Amy", age: 18 });
+        g_object.setSessionId("session21", function (err, joined) {
+            expect(err).assertEqual(undefined);
+            expect(joined).assertEqual(true);
+            expect(g_object.__sessionId).assertEqual("session21");
+            expect(g_object.name).assertEqual("Tom");
+            g_object.setSessionId("", function (err, result) {
+                expect(err).assertEqual(undefined);
+                expect(result).assertEqual(false);
+                expect(g_object.__sessionId).assertEqual(undefined);
+                expect(g_object.name).assertEqual("Tom");
+                done()
+                console.log(TAG + "************* testAsyncSession001 end *************");
+            });
+        });
+        // written while the session is opening, joins with the object
+        g_object.name = "Tom";
+    })
+
     /**
      * @tc.name: testMaxSize001
      * @tc.desc: object can get/set data under 4MB size
@@ -680,6 +854,253 @@ describe('objectStoreTest', function () {
         console.log(TAG + "************* testPerformance001 end *************");
     })
 
+    /**
+     * @tc.name: testPerformance002
+     * @tc.desc: repeated reads of an unchanged 1MB complex value are served from the cache, each read is a copy
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testPerformance002', 0, function (done) {
+        console.log(TAG + "************* testPerformance002 start *************");
+        var note_object = distributedObject.createDistributedObject({ documentList: undefined });
+        note_object.setSessionId("session15");
+        expect(note_object.__sessionId).assertEqual("session15");
+        var documentList = [];
+        // 1024 documents of 1KB each
+        for (var i = 0; i < 1024; i++) {
+            documentList.push({ title: "note" + i, content: "x".repeat(1000) });
+        }
+        note_object.documentList = documentList;
+        var firstRead = note_object.documentList;
+        expect(firstRead.length).assertEqual(documentList.length);
+        for (var i = 0; i < 1000; i++) {
+            expect(note_object.documentList[1023].title).assertEqual("note1023");
+        }
+        // editing what was read does not show through to the next read
+        firstRead.push({ title: "local" });
+        firstRead[0].title = "local";
+        expect(note_object.documentList === firstRead).assertEqual(false);
+        expect(note_object.documentList.length).assertEqual(documentList.length);
+        expect(note_object.documentList[0].title).assertEqual("note0");
+        note_object.documentList = [{ title: "changed" }];
+        expect(note_object.documentList.length).assertEqual(1);
+        note_object.setSessionId("");
+        done()
+        console.log(TAG + "************* testPerformance002 end *************");
+    })
+
+    /**
+     * @tc.name: testPerformance003
+     * @tc.desc: register and remove 1000 change listeners, registering one twice is ignored
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testPerformance003', 0, function (done) {
+        console.log(TAG + "************* testPerformance003 start *************");
+        var g_object = distributedObject.createDistributedObject({ name: "Amy", age: 18, isVis: false });
+        g_object.setSessionId("session22");
+        expect(g_object.__sessionId).assertEqual("session22");
+        var listenerCount = 1000;
+        var listeners = [];
+        for (var i = 0; i < listenerCount; i++) {
+            listeners.push(function (sessionId, changeData) {
+                console.info(TAG + "listener " + sessionId + " " + changeData);
+            });
+        }
+        for (var i = 0; i < listenerCount; i++) {
+            g_object.on("change", listeners[i]);
+        }
+        // registering the same listener again is ignored
+        g_object.on("change", listeners[0]);
+        g_object.name = "jack1";
+        expect(g_object.name).assertEqual("jack1");
+        for (var i = 0; i < listenerCount; i++) {
+            g_object.off("change", listeners[i]);
+        }
+        g_object.setSessionId("");
+        done()
+        console.log(TAG + "************* testPerformance003 end *************");
+    })
+
+    /**
+     * @tc.name: testGetStatistics001
+     * @tc.desc: store statistics count the puts, gets and sessions of this process
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testGetStatistics001', 0, function (done) {
+        console.log(TAG + "************* testGetStatistics001 start *************");
+        var before = distributedObject.getStatistics();
+        expect(before != undefined && before.put != undefined && before.peers != undefined).assertTrue();
+        var g_object = distributedObject.createDistributedObject({ name: "Amy", age: 18, isVis: false });
+        g_object.setSessionId("session23");
+        expect(g_object.__sessionId).assertEqual("session23");
+        g_object.name = "jack1";
+        expect(g_object.name).assertEqual("jack1");
+        var after = distributedObject.getStatistics();
+        console.log(TAG + "statistics " + JSON.stringify(after));
+        expect(after.put.count > before.put.count).assertTrue();
+        expect(after.get.count >= before.get.count).assertTrue();
+        expect(after.create.count).assertEqual(before.create.count + 1);
+        expect(after.liveSessions).assertEqual(before.liveSessions + 1);
+        expect(after.put.p99 >= after.put.p50 && after.put.max >= after.put.p50).assertTrue();
+        g_object.setSessionId("");
+        var left = distributedObject.getStatistics();
+        expect(left.liveSessions).assertEqual(before.liveSessions);
+        expect(left.destroy.count).assertEqual(before.destroy.count + 1);
+        // the store was opened before the session could be created
+        expect(left.init != undefined && left.init.open > 0).assertTrue();
+        expect(left.init.open >= left.init.storeManager).assertTrue();
+        done()
+        console.log(TAG + "************* testGetStatistics001 end *************");
+    })
+
+    /**
+     * @tc.name: testTrace001
+     * @tc.desc: a traced put shows up in the exported timeline with its commit
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testTrace001', 0, function (done) {
+        console.log(TAG + "************* testTrace001 start *************");
+        distributedObject.setTraceEnabled(true);
+        var g_object = distributedObject.createDistributedObject({ name: "Amy", age: 18, isVis: false });
+        g_object.setSessionId("session24");
+        expect(g_object.__sessionId).assertEqual("session24");
+        g_object.name = "jack1";
+        expect(g_object.name).assertEqual("jack1");
+        var trace = JSON.parse(distributedObject.exportTrace());
+        var names = trace.traceEvents.map(function (event) {
+            return event.name;
+        });
+        console.log(TAG + "trace " + names.length + " events");
+        expect(names.indexOf("put") >= 0).assertTrue();
+        expect(names.indexOf("commit") >= 0).assertTrue();
+        distributedObject.setTraceEnabled(false);
+        g_object.setSessionId("");
+        done()
+        console.log(TAG + "************* testTrace001 end *************");
+    })
+
+    /**
+     * @tc.name: testDurable001
+     * @tc.desc: a durable session opened again keeps the values written before, not the initial ones
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testDurable001', 0, function (done) {
+        console.log(TAG + "************* testDurable001 start *************");
+        var g_object = distributedObject.createDistributedObject({ name: "Amy", age: 18, isVis: false },
+            { durable: true });
+        g_object.setSessionId("session25");
+        expect(g_object.__sessionId).assertEqual("session25");
+        g_object.name = "jack1";
+        g_object.age = 19;
+        g_object.setSessionId("");
+        var g_object2 = distributedObject.createDistributedObject({ name: "Amy", age: 18, isVis: false },
+            { durable: true });
+        g_object2.setSessionId("session25");
+        console.log(TAG + "restored " + g_object2.name + " " + g_object2.age);
+        expect(g_object2.name).assertEqual("jack1");
+        expect(g_object2.age).assertEqual(19);
+        expect(g_object2.isVis).assertEqual(false);
+        g_object2.setSessionId("");
+        done()
+        console.log(TAG + "************* testDurable001 end *************");
+    })
+
+    /**
+     * @tc.name: testMemoryBudget001
+     * @tc.desc: the bytes and fields of a session are counted, the budget and a memory session over it
+     *          show in the statistics
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testMemoryBudget001', 0, function (done) {
+        console.log(TAG + "************* testMemoryBudget001 start *************");
+        distributedObject.setMemoryBudget(1024 * 1024);
+        var g_object = distributedObject.createDistributedObject({ name: "Amy", age: 18, isVis: false });
+        g_object.setSessionId("session26");
+        expect(g_object.__sessionId).assertEqual("session26");
+        g_object.name = "jack1";
+        var statistics = distributedObject.getStatistics();
+        console.log(TAG + "memory " + JSON.stringify(statistics.sessions) + " " + statistics.residentBytes);
+        expect(statistics.memoryBudget).assertEqual(1024 * 1024);
+        expect(statistics.sessions["session26"] != undefined).assertTrue();
+        expect(statistics.sessions["session26"].bytes > 0).assertTrue();
+        expect(statistics.sessions["session26"].fields > 0).assertTrue();
+        expect(statistics.sessions["session26"].resident).assertEqual(true);
+        expect(statistics.residentBytes >= statistics.sessions["session26"].bytes).assertTrue();
+        expect(statistics.budgetOverrun).assertEqual(Math.max(0, statistics.residentBytes - 1024 * 1024));
+        // a memory session can not be evicted, it stays resident over the budget
+        var overrun = distributedObject.setMemoryBudget(1);
+        expect(overrun >= statistics.sessions["session26"].bytes - 1).assertTrue();
+        statistics = distributedObject.getStatistics();
+        expect(statistics.sessions["session26"].resident).assertEqual(true);
+        expect(statistics.budgetOverrun).assertEqual(overrun);
+        expect(distributedObject.setMemoryBudget(0)).assertEqual(0);
+        g_object.setSessionId("");
+        done()
+        console.log(TAG + "************* testMemoryBudget001 end *************");
+    })
+
+    /**
+     * @tc.name: testChunking001
+     * @tc.desc: a large binary value reads back the same, also after a small edit, chunked or not
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testChunking001', 0, function (done) {
+        console.log(TAG + "************* testChunking001 start *************");
+        var g_object = distributedObject.createDistributedObject({ name: "Amy", data: undefined });
+        g_object.setSessionId("session27");
+        expect(g_object.__sessionId).assertEqual("session27");
+        var data = new Uint8Array(512 * 1024);
+        for (var i = 0; i < data.length; i++) {
+            data[i] = (i * 7919) % 251;
+        }
+        g_object.data = data;
+        var stored = new Uint8Array(g_object.data);
+        expect(stored.length).assertEqual(data.length);
+        expect(stored.every((value, index) => value == data[index])).assertTrue();
+        data[data.length / 2] = 255;
+        g_object.data = data;
+        stored = new Uint8Array(g_object.data);
+        expect(stored.length).assertEqual(data.length);
+        expect(stored[data.length / 2]).assertEqual(255);
+        expect(stored.every((value, index) => value == data[index])).assertTrue();
+        g_object.setSessionId("");
+        done()
+        console.log(TAG + "************* testChunking001 end *************");
+    })
+
+    /**
+     * @tc.name: testSuppress001
+     * @tc.desc: putting the value a field holds already is skipped and counted, a different value is not
+     * @tc.type: FUNC
+     * @tc.require: I4H3M8
+     */
+    it('testSuppress001', 0, function (done) {
+        console.log(TAG + "************* testSuppress001 start *************");
+        var g_object = distributedObject.createDistributedObject({ name: "Amy", data: undefined });
+        g_object.setSessionId("session28");
+        expect(g_object.__sessionId).assertEqual("session28");
+        g_object.data = new Uint8Array([1, 2, 3, 4]);
+        var before = distributedObject.getStatistics();
+        g_object.data = new Uint8Array([1, 2, 3, 4]);
+        var after = distributedObject.getStatistics();
+        console.log(TAG + "suppressed " + before.suppressedWrites + " " + after.suppressedWrites);
+        expect(after.suppressedWrites).assertEqual(before.suppressedWrites + 1);
+        expect(after.sessions["session28"].suppressedWrites >= 1).assertTrue();
+        g_object.data = new Uint8Array([1, 2, 3, 5]);
+        var changed = distributedObject.getStatistics();
+        expect(changed.suppressedWrites).assertEqual(after.suppressedWrites);
+        expect(new Uint8Array(g_object.data)[3]).assertEqual(5);
+        g_object.setSessionId("");
+        done()
+        console.log(TAG + "************* testSuppress001 end *************");
+    })
+
     console.log(TAG + "*************Unit Test End*************");
 })
 
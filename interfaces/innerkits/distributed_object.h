@@ -18,8 +18,11 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <variant>
 #include <vector>
 
+#include "objectstore_errors.h"
+
 namespace OHOS::ObjectStore {
 enum Type : uint8_t {
     TYPE_STRING = 0,
@@ -27,6 +30,15 @@ enum Type : uint8_t {
     TYPE_DOUBLE,
     TYPE_COMPLEX,
 };
+// alternatives are in Type order, index() of a value is its Type
+using FieldValue = std::variant<std::string, bool, double, std::vector<uint8_t>>;
+// how this device keeps the data of a session
+struct ObjectOptions {
+    // on disk, a restarted process reads its last state back and syncs only what changed since;
+    // puts are written behind in batches, the newest few milliseconds are lost with a crash
+    bool durable = false;
+    std::string dataDir;  // of durable stores, empty for the default of the bundle
+};
 class DistributedObject {
 public:
     virtual ~DistributedObject(){};
@@ -40,6 +52,78 @@ public:
     virtual uint32_t GetComplex(const std::string &key, std::vector<uint8_t> &value) = 0;
     virtual uint32_t GetType(const std::string &key, Type &type) = 0;
     virtual std::string &GetSessionId() = 0;
+    // the methods below came after the first release, they are not pure so that an implementation
+    // built against the older header keeps its vtable layout
+    virtual uint32_t PutBatch(const std::map<std::string, FieldValue> &fields)
+    {
+        for (auto &[key, value] : fields) {
+            uint32_t status = PutField(key, value);
+            if (status != SUCCESS) {
+                return status;
+            }
+        }
+        return SUCCESS;
+    }
+    // the fields and the deletes of removed in one write, peers see all of it or none
+    virtual uint32_t PutBatch(
+        const std::map<std::string, FieldValue> &fields, const std::vector<std::string> &removed)
+    {
+        return removed.empty() ? PutBatch(fields) : ERR_NOT_SUPPORT;
+    }
+    virtual uint32_t GetAll(std::map<std::string, FieldValue> &)
+    {
+        return ERR_NOT_SUPPORT;
+    }
+    // the fields whose key starts with prefix, the others are neither decoded nor assembled
+    virtual uint32_t GetAll(const std::string &prefix, std::map<std::string, FieldValue> &fields)
+    {
+        uint32_t status = GetAll(fields);
+        for (auto it = fields.begin(); status == SUCCESS && it != fields.end();) {
+            it = it->first.compare(0, prefix.size(), prefix) == 0 ? std::next(it) : fields.erase(it);
+        }
+        return status;
+    }
+
+    // stores head followed by size bytes at tail, tail is only read until the call returns
+    virtual uint32_t PutComplex(
+        const std::string &key, const std::vector<uint8_t> &head, const uint8_t *tail, size_t size)
+    {
+        std::vector<uint8_t> value(head);
+        value.insert(value.end(), tail, tail + size);
+        return PutComplex(key, value);
+    }
+    // value receives the stored record as is, the complex value starts at offset
+    virtual uint32_t GetComplex(const std::string &key, std::vector<uint8_t> &value, size_t &offset)
+    {
+        offset = 0;
+        return GetComplex(key, value);
+    }
+    // the stored form of a field, the type byte and the encoded value; Put<T> and Get<T> of
+    // field_codec.h encode and decode it at compile time
+    virtual uint32_t PutRecord(const std::string &, const std::vector<uint8_t> &)
+    {
+        return ERR_NOT_SUPPORT;
+    }
+    // a complex value stored as chunks comes back whole
+    virtual uint32_t GetRecord(const std::string &, std::vector<uint8_t> &)
+    {
+        return ERR_NOT_SUPPORT;
+    }
+
+private:
+    uint32_t PutField(const std::string &key, const FieldValue &value)
+    {
+        switch (value.index()) {
+            case TYPE_STRING:
+                return PutString(key, std::get<TYPE_STRING>(value));
+            case TYPE_BOOLEAN:
+                return PutBoolean(key, std::get<TYPE_BOOLEAN>(value));
+            case TYPE_DOUBLE:
+                return PutDouble(key, std::get<TYPE_DOUBLE>(value));
+            default:
+                return PutComplex(key, std::get<TYPE_COMPLEX>(value));
+        }
+    }
 };
 
 class ObjectWatcher {
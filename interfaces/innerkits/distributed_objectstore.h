@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "distributed_object.h"
+#include "objectstore_statistics.h"
 
 namespace OHOS::ObjectStore {
 class StatusNotifier {
@@ -39,6 +40,22 @@ public:
     virtual uint32_t SetStatusNotifier(std::shared_ptr<StatusNotifier> notifier) = 0;
     virtual void TriggerSync();
     virtual void TriggerRestore(std::function<void()> notifier);
+    // lock free snapshot of the counters of this process, cheap enough to poll
+    virtual ObjectStoreStatistics GetStatistics() = 0;
+    // traces writes from the local put to the remote change notification, every device has to enable it
+    virtual void SetTraceEnabled(bool enabled) = 0;
+    // the events recorded on this device as chrome trace event json, merge the exports of all devices
+    virtual std::string ExportTrace() = 0;
+    // after the calls above so that their slots stay where older builds expect them; a store that
+    // can not keep a session on disk refuses durable options
+    virtual DistributedObject *CreateObject(const std::string &sessionId, const ObjectOptions &options)
+    {
+        return options.durable ? nullptr : CreateObject(sessionId);
+    }
+    // above this many bytes the idle durable sessions nobody watches are closed until their next use; memory
+    // sessions and sessions in use can not be closed and stay resident past it. Returns the bytes still
+    // resident over the budget, also in the budgetOverrun statistics; 0 is no limit
+    virtual uint64_t SetMemoryBudget(uint64_t bytes) = 0;
 };
 } // namespace OHOS::ObjectStore
 
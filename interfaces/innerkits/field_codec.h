@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIELD_CODEC_H
+#define FIELD_CODEC_H
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "distributed_object.h"
+#include "objectstore_errors.h"
+
+namespace OHOS::ObjectStore {
+// Typed access to fields resolved at compile time: Put<T> and Get<T> encode with FieldCodec<T>
+// and move the record through PutRecord and GetRecord, no per type virtual call and no switch.
+// A record is the type byte followed by the payload, the same bytes PutDouble and the others write.
+// A type is supported by specialising FieldCodec with:
+//   static constexpr Type TYPE;  the type byte, what peers and the JS layer decode the payload as
+//   static size_t Size(const T &value);  bytes Encode appends, to allocate the record once
+//   static bool Encode(const T &value, std::vector<uint8_t> &record);  appends the payload
+//   static bool Decode(const uint8_t *data, size_t size, T &value);  the payload, false if it does not fit
+// Types without a codec do not compile.
+template <typename T>
+struct FieldCodec;
+
+template <>
+struct FieldCodec<std::string> {
+    static constexpr Type TYPE = TYPE_STRING;
+    static size_t Size(const std::string &value)
+    {
+        return value.size();
+    }
+    static bool Encode(const std::string &value, std::vector<uint8_t> &record)
+    {
+        record.insert(record.end(), value.begin(), value.end());
+        return true;
+    }
+    static bool Decode(const uint8_t *data, size_t size, std::string &value)
+    {
+        value.assign(reinterpret_cast<const char *>(data), size);
+        return true;
+    }
+};
+
+template <>
+struct FieldCodec<bool> {
+    static constexpr Type TYPE = TYPE_BOOLEAN;
+    static size_t Size(bool)
+    {
+        return sizeof(uint8_t);
+    }
+    static bool Encode(bool value, std::vector<uint8_t> &record)
+    {
+        record.push_back(value ? 1 : 0);
+        return true;
+    }
+    static bool Decode(const uint8_t *data, size_t size, bool &value)
+    {
+        if (size < sizeof(uint8_t)) {
+            return false;
+        }
+        value = data[0] != 0;
+        return true;
+    }
+};
+
+// the bits of the double, most significant byte first
+template <>
+struct FieldCodec<double> {
+    static constexpr Type TYPE = TYPE_DOUBLE;
+    static size_t Size(double)
+    {
+        return sizeof(uint64_t);
+    }
+    static bool Encode(double value, std::vector<uint8_t> &record)
+    {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            record.push_back(static_cast<uint8_t>(bits >> shift));
+        }
+        return true;
+    }
+    static bool Decode(const uint8_t *data, size_t size, double &value)
+    {
+        if (size < sizeof(uint64_t)) {
+            return false;
+        }
+        uint64_t bits = 0;
+        for (size_t i = 0; i < sizeof(bits); i++) {
+            bits = (bits << 8) | data[i];
+        }
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+};
+
+template <>
+struct FieldCodec<std::vector<uint8_t>> {
+    static constexpr Type TYPE = TYPE_COMPLEX;
+    static size_t Size(const std::vector<uint8_t> &value)
+    {
+        return value.size();
+    }
+    static bool Encode(const std::vector<uint8_t> &value, std::vector<uint8_t> &record)
+    {
+        record.insert(record.end(), value.begin(), value.end());
+        return true;
+    }
+    static bool Decode(const uint8_t *data, size_t size, std::vector<uint8_t> &value)
+    {
+        value.assign(data, data + size);
+        return true;
+    }
+};
+
+// stored as a double so that JS reads a number, only the integers a double holds exactly
+template <>
+struct FieldCodec<int64_t> {
+    static constexpr Type TYPE = TYPE_DOUBLE;
+    static constexpr int64_t MAX_EXACT = int64_t(1) << 53;
+    static size_t Size(int64_t)
+    {
+        return sizeof(uint64_t);
+    }
+    static bool Encode(int64_t value, std::vector<uint8_t> &record)
+    {
+        if (value > MAX_EXACT || value < -MAX_EXACT) {
+            return false;
+        }
+        return FieldCodec<double>::Encode(static_cast<double>(value), record);
+    }
+    static bool Decode(const uint8_t *data, size_t size, int64_t &value)
+    {
+        double number = 0;
+        if (!FieldCodec<double>::Decode(data, size, number) || std::trunc(number) != number ||
+            std::fabs(number) > static_cast<double>(MAX_EXACT)) {
+            return false;
+        }
+        value = static_cast<int64_t>(number);
+        return true;
+    }
+};
+
+// type byte and payload of value appended to record
+template <typename T>
+bool EncodeField(const T &value, std::vector<uint8_t> &record)
+{
+    record.reserve(record.size() + sizeof(Type) + FieldCodec<T>::Size(value));
+    record.push_back(FieldCodec<T>::TYPE);
+    return FieldCodec<T>::Encode(value, record);
+}
+
+template <typename T>
+uint32_t DecodeField(const std::vector<uint8_t> &record, T &value)
+{
+    if (record.empty() || record[0] != FieldCodec<T>::TYPE) {
+        return ERR_DATA_LEN;
+    }
+    if (!FieldCodec<T>::Decode(record.data() + sizeof(Type), record.size() - sizeof(Type), value)) {
+        return ERR_DATA_LEN;
+    }
+    return SUCCESS;
+}
+
+template <typename T>
+uint32_t Put(DistributedObject &object, const std::string &key, const T &value)
+{
+    std::vector<uint8_t> record;
+    if (!EncodeField(value, record)) {
+        return ERR_DATA_LEN;
+    }
+    return object.PutRecord(key, record);
+}
+
+// the complex value of key starts at offset in value, read in place without moving a large payload;
+// ERR_DATA_LEN if the field holds another type
+inline uint32_t Get(DistributedObject &object, const std::string &key, std::vector<uint8_t> &value, size_t &offset)
+{
+    uint32_t status = object.GetComplex(key, value, offset);
+    if (status != SUCCESS) {
+        return status;
+    }
+    // an assembled chunked value comes without its type byte
+    if (offset > 0 && value[0] != FieldCodec<std::vector<uint8_t>>::TYPE) {
+        return ERR_DATA_LEN;
+    }
+    return SUCCESS;
+}
+
+// ERR_DATA_LEN if the field holds another type or a value T cannot take
+template <typename T>
+uint32_t Get(DistributedObject &object, const std::string &key, T &value)
+{
+    if constexpr (std::is_same_v<T, std::vector<uint8_t>>) {
+        size_t offset = 0;
+        uint32_t status = Get(object, key, value, offset);
+        if (status == SUCCESS && offset > 0) {
+            value.erase(value.begin(), value.begin() + offset);
+        }
+        return status;
+    } else {
+        std::vector<uint8_t> record;
+        uint32_t status = object.GetRecord(key, record);
+        if (status != SUCCESS) {
+            return status;
+        }
+        return DecodeField(record, value);
+    }
+}
+} // namespace OHOS::ObjectStore
+#endif // FIELD_CODEC_H
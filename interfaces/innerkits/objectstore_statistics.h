@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OBJECTSTORE_STATISTICS_H
+#define OBJECTSTORE_STATISTICS_H
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace OHOS::ObjectStore {
+// latency summary in microseconds, percentiles are the upper bound of their log2 bucket
+struct LatencyStatistics {
+    uint64_t count = 0;
+    uint64_t average = 0;
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+};
+
+struct PeerStatistics {
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    LatencyStatistics sync;  // from starting a sync until the peer answered it
+};
+
+// microseconds spent in each phase of opening the store, 0 until the phase is done
+struct InitStatistics {
+    uint64_t processLabel = 0;    // setting the process label of DistributedDB
+    uint64_t communicator = 0;    // creating the communicator and the transport below it
+    uint64_t storeManager = 0;    // creating the store manager
+    uint64_t open = 0;            // the whole background open, from the first GetInstance
+    uint64_t nodeRegister = 0;    // until softbus accepted the device state callback, retries included
+    uint64_t readyWait = 0;       // operations blocked on the open, summed
+};
+
+// what a session keeps in the database, key and value bytes without the overhead of the database
+struct SessionStatistics {
+    uint64_t bytes = 0;
+    uint64_t fields = 0;
+    uint64_t suppressedWrites = 0;  // puts skipped as the field held the value already
+    bool resident = true;  // false once evicted, it is opened again on its next use
+};
+
+// counters since the process started
+struct ObjectStoreStatistics {
+    LatencyStatistics put;
+    LatencyStatistics get;
+    LatencyStatistics create;
+    LatencyStatistics destroy;
+    LatencyStatistics sessionOpenWait;   // a send waiting for its transport session to open
+    std::map<std::string, PeerStatistics> peers;  // by network id
+    uint64_t pendingNotifications = 0;   // change notifications not delivered to the watchers yet
+    uint64_t liveSessions = 0;
+    InitStatistics init;
+    std::map<std::string, SessionStatistics> sessions;  // by session id
+    uint64_t residentBytes = 0;          // bytes of the sessions not evicted
+    uint64_t memoryBudget = 0;           // 0 is no limit
+    uint64_t budgetOverrun = 0;          // resident bytes over the budget that no eviction could release
+    uint64_t evictions = 0;
+    uint64_t reloads = 0;                // evicted sessions opened again
+    uint64_t suppressedWrites = 0;       // puts of unchanged values, neither committed nor synced
+};
+} // namespace OHOS::ObjectStore
+#endif // OBJECTSTORE_STATISTICS_H
@@ -17,10 +17,22 @@ const distributedObject = requireInternal("data.distributedDataObject");
 const SESSION_ID = "__sessionId";
 const COMPLEX_TYPE = "[COMPLEX]";
 const STRING_TYPE = "[STRING]";
+const ARRAY_TYPE = "[ARRAY]";
+const OBJECT_TYPE = "[OBJECT]";
+const PATH_SEPARATOR = "/";
+const CHANGE_TYPE = "change";
+const CACHE_INVALIDATOR = "__cacheInvalidator";
+const READ_ALL = "__readAll";
+// PeerCapabilities::PATH_FIELDS, every online peer reads values stored path by path
+const PATH_FIELDS = 1 << 1;
+// PeerCapabilities::BINARY_COMPLEX, every online peer decodes typed arrays in the native encoding
+const BINARY_COMPLEX = 1 << 0;
 
 class Distributed {
-    constructor(obj) {
+    constructor(obj, options) {
         this.__proxy = obj;
+        // durable sessions keep their data on this device across restarts of the application
+        this.__durable = options != undefined && options.durable === true;
         Object.keys(obj).forEach(key => {
             Object.defineProperty(this, key, {
                 enumerable: true,
@@ -47,7 +59,13 @@ class Distributed {
         console.info("constructor success ");
     }
 
-    setSessionId(sessionId) {
+    setSessionId(sessionId, callback) {
+        if (typeof callback == "function") {
+            this.setSessionIdAsync(sessionId).then(result => callback(undefined, result), error => callback(error));
+            return;
+        }
+        // a pending asynchronous join is overtaken
+        this.__pending = undefined;
         if (sessionId == null || sessionId == "") {
             leaveSession(this.__proxy);
             return false;
@@ -57,7 +75,7 @@ class Distributed {
             return true;
         }
         leaveSession(this.__proxy);
-        let object = joinSession(this.__proxy, this.__objectId, sessionId);
+        let object = joinSession(this.__proxy, this.__objectId, sessionId, this.__durable);
         if (object != null) {
             this.__proxy = object;
             return true;
@@ -65,6 +83,42 @@ class Distributed {
         return false;
     }
 
+    // same as setSessionId, but storage is opened and closed off the JS thread
+    setSessionIdAsync(sessionId) {
+        if (this.__pending != undefined && this.__pending.sessionId == sessionId) {
+            return this.__pending.promise;
+        }
+        this.__pending = undefined;
+        if (this.__proxy[SESSION_ID] == sessionId && sessionId != null && sessionId != "") {
+            console.info("same session has joined " + sessionId);
+            return Promise.resolve(true);
+        }
+        let left = leaveSessionAsync(this.__proxy);
+        if (sessionId == null || sessionId == "") {
+            return left.then(() => false);
+        }
+        // the native side runs the close and the open in the order they were asked for
+        let pending = { sessionId: sessionId };
+        this.__pending = pending;
+        pending.promise = distributedObject.createObject(sessionId, this.__objectId, this.__durable).then(object => {
+            if (this.__pending !== pending) {
+                console.warn("join " + sessionId + " overtaken");
+                return distributedObject.destroyObject(object).then(() => false);
+            }
+            this.__pending = undefined;
+            // values written while the session was opening are picked up here
+            this.__proxy = attachSession(this.__proxy, object, sessionId, this.__durable);
+            return true;
+        }, error => {
+            console.error("create fail " + error);
+            if (this.__pending === pending) {
+                this.__pending = undefined;
+            }
+            return false;
+        });
+        return pending.promise;
+    }
+
     on(type, callback) {
         onWatch(type, this.__proxy, callback);
         distributedObject.recordCallback(type, this.__objectId, callback);
@@ -77,33 +131,398 @@ class Distributed {
 
     __proxy;
     __objectId;
+    __pending;
+    __durable;
 }
 
 function randomNum() {
     return Math.random().toString(10).slice(-8);
 }
 
-function newDistributed(obj) {
+// latency in microseconds of put, get, create, destroy and session open waits, bytes and sync
+// latency per peer network id, pending notifications and live sessions of this process, the
+// microseconds each phase of opening the store took in init, the bytes, fields and suppressed puts
+// per session with the resident total, the memory budget and the resident bytes over it, evictions,
+// reloads and suppressed puts
+function getStatistics() {
+    return distributedObject.getStatistics();
+}
+
+function setTraceEnabled(enabled) {
+    distributedObject.setTraceEnabled(enabled);
+}
+
+function exportTrace() {
+    return distributedObject.exportTrace();
+}
+
+// idle durable sessions without watchers are closed over this many bytes, memory sessions and sessions in
+// use stay; returns the bytes still resident over it, 0 when it holds; a budget of 0 turns it off
+function setMemoryBudget(bytes) {
+    return distributedObject.setMemoryBudget(bytes);
+}
+
+function newDistributed(obj, options) {
     console.info("start newDistributed");
     if (obj == null) {
         console.error("object is null");
         return null;
     }
-    return new Distributed(obj);
+    return new Distributed(obj, options);
+}
+
+// Plain arrays and objects are stored path by path: the container itself holds its shape
+// ("[ARRAY]<length>" or "[OBJECT]<keys>") and every element lives under <path>/<name>, so an
+// edit deep inside a large value rewrites, syncs and reports only the paths it touched. Only
+// while every online peer reads that form; otherwise, and with no peer online, a value is one
+// "[COMPLEX]<json>" field under its key as older releases write it.
+function isFlattened(value) {
+    if (typeof value != "object" || value == null) {
+        return false;
+    }
+    let prototype = Object.getPrototypeOf(value);
+    return Array.isArray(value) || prototype == Object.prototype || prototype == null;
+}
+
+// keys are escaped like the names below them, a key holding "/" never lands on a path of another key
+function escapeName(name) {
+    return String(name).replace(/%/g, "%25").replace(/\//g, "%2F");
+}
+
+function childPath(path, name) {
+    return path + PATH_SEPARATOR + escapeName(name);
+}
+
+function childName(segment) {
+    return segment.replace(/%2F/g, "/").replace(/%25/g, "%");
+}
+
+function isBinary(value) {
+    return (ArrayBuffer.isView(value) && !(value instanceof DataView)) || value instanceof ArrayBuffer;
+}
+
+// typed arrays and ArrayBuffers are handed to the native encoding when every online peer decodes
+// it, before that only a Uint8Array, whose raw bytes every release reads back as one; any other
+// object is JSON, which encodes faster than the native form
+function encodeValue(value, binary) {
+    if (typeof value == "string") {
+        return STRING_TYPE + value;
+    }
+    if (value === null || value === undefined || typeof value == "function" || typeof value == "symbol") {
+        return COMPLEX_TYPE + "null";
+    }
+    if (typeof value != "object") {
+        return value;
+    }
+    if (isBinary(value) && (binary || (value instanceof Uint8Array && value.length > 0))) {
+        return value;
+    }
+    return COMPLEX_TYPE + JSON.stringify(value);
+}
+
+// the cache keeps its own value, a caller editing what it read must not change the next read
+function cloneValue(value) {
+    if (Array.isArray(value)) {
+        return value.map(cloneValue);
+    }
+    if (isFlattened(value)) {
+        let result = {};
+        Object.keys(value).forEach(key => result[key] = cloneValue(value[key]));
+        return result;
+    }
+    if (ArrayBuffer.isView(value) && !(value instanceof DataView)) {
+        return value.slice();
+    }
+    if (value instanceof ArrayBuffer) {
+        return value.slice(0);
+    }
+    return value;
+}
+
+function decodeValue(value) {
+    if (typeof value == "string") {
+        if (value.startsWith(STRING_TYPE)) {
+            return value.substr(STRING_TYPE.length);
+        } else if (value.startsWith(COMPLEX_TYPE)) {
+            return JSON.parse(value.substr(COMPLEX_TYPE.length));
+        } else {
+            console.error("error type " + value);
+        }
+    }
+    return value;
+}
+
+// the paths of key and what each holds, one field under the key itself unless paths is set
+function flattenKey(key, value, paths, binary) {
+    let leaves = new Map();
+    if (!paths) {
+        leaves.set(key, encodeValue(value, binary));
+    } else {
+        flatten(value, escapeName(key), leaves, binary);
+    }
+    return leaves;
+}
+
+function flatten(value, path, leaves, binary) {
+    if (Array.isArray(value)) {
+        leaves.set(path, ARRAY_TYPE + value.length);
+        value.forEach((item, index) => flatten(item, childPath(path, index), leaves, binary));
+    } else if (isFlattened(value)) {
+        let keys = Object.keys(value).filter(key => value[key] !== undefined && typeof value[key] != "function");
+        leaves.set(path, OBJECT_TYPE + JSON.stringify(keys));
+        keys.forEach(key => flatten(value[key], childPath(path, key), leaves, binary));
+    } else {
+        leaves.set(path, encodeValue(value, binary));
+    }
+}
+
+// where a peer that does not read paths keeps key, undefined when that is a path below another of keys
+function legacyPath(key, keys) {
+    let owner = childName(key.split(PATH_SEPARATOR)[0]);
+    return owner != key && keys.includes(owner) ? undefined : key;
+}
+
+// the stored paths of key in values, for a key this device has not read or written yet
+function pathsOf(key, keys, values) {
+    let root = escapeName(key);
+    let legacy = legacyPath(key, keys);
+    let paths = new Map();
+    Object.keys(values).forEach(path => {
+        if (path == legacy || path == root || path.startsWith(root + PATH_SEPARATOR)) {
+            paths.set(path, values[path]);
+        }
+    });
+    return paths;
+}
+
+function readShape(raw) {
+    if (typeof raw == "string" && raw.startsWith(ARRAY_TYPE)) {
+        return { length: parseInt(raw.substr(ARRAY_TYPE.length)) };
+    }
+    if (typeof raw == "string" && raw.startsWith(OBJECT_TYPE)) {
+        return { keys: JSON.parse(raw.substr(OBJECT_TYPE.length)) };
+    }
+    return null;
 }
 
-function joinSession(obj, objectId, sessionId) {
+function readPath(get, path, stored, raw = get(path)) {
+    stored.set(path, raw);
+    let shape = readShape(raw);
+    if (shape == null) {
+        return decodeValue(raw);
+    }
+    if (shape.keys == undefined) {
+        let result = new Array(shape.length);
+        for (let i = 0; i < shape.length; i++) {
+            result[i] = readPath(get, childPath(path, i), stored);
+        }
+        return result;
+    }
+    let result = {};
+    shape.keys.forEach(key => result[key] = readPath(get, childPath(path, key), stored));
+    return result;
+}
+
+// a nested value is read back from one snapshot of the whole object instead of path by path;
+// stored receives the paths of key that were read
+function readValue(object, key, keys, stored, values = undefined) {
+    let get = path => values != undefined ? values[path] : object.get(path);
+    let path = escapeName(key);
+    let raw = get(path);
+    if (raw == undefined && path != key && legacyPath(key, keys) != undefined) {
+        // written in one piece by a peer that does not read paths
+        path = key;
+        raw = get(path);
+    }
+    if (readShape(raw) == null) {
+        stored.set(path, raw);
+        return decodeValue(raw);
+    }
+    if (values == undefined) {
+        // only the paths below the value are decoded, the rest of the object stays in the store
+        values = object.getAll(path + PATH_SEPARATOR);
+    }
+    return readPath(item => values[item], path, stored, raw);
+}
+
+// apply one changed path to the cached value of key it belongs to, reading as little as possible
+function refreshPath(object, key, path, cache, stored) {
+    let segments = path.split(PATH_SEPARATOR);
+    if (!cache.has(key) || !stored.has(key)) {
+        cache.delete(key);
+        return;
+    }
+    let parent = null;
+    let current = cache.get(key);
+    for (let i = 1; i < segments.length; i++) {
+        if (current == null || typeof current != "object") {
+            // the shape this path hangs off is unknown, read the value again next time
+            cache.delete(key);
+            return;
+        }
+        parent = current;
+        current = current[childName(segments[i])];
+    }
+    let get = item => object.get(item);
+    let paths = stored.get(key);
+    let raw = get(path);
+    let shape = readShape(raw);
+    let result;
+    if (shape != null && shape.keys == undefined && Array.isArray(current)) {
+        paths.set(path, raw);
+        for (let i = current.length; i < shape.length; i++) {
+            current[i] = readPath(get, childPath(path, i), paths);
+        }
+        current.length = shape.length;
+        result = current;
+    } else if (shape != null && shape.keys != undefined && isFlattened(current) && !Array.isArray(current)) {
+        paths.set(path, raw);
+        Object.keys(current).filter(name => !shape.keys.includes(name)).forEach(name => delete current[name]);
+        shape.keys.filter(name => !(name in current)).forEach(name => {
+            current[name] = readPath(get, childPath(path, name), paths);
+        });
+        result = current;
+    } else {
+        result = readPath(get, path, paths, raw);
+    }
+    if (parent == null) {
+        cache.set(key, result);
+    } else {
+        parent[childName(segments[segments.length - 1])] = result;
+    }
+}
+
+function joinSession(obj, objectId, sessionId, durable) {
     console.info("start joinSession " + sessionId);
     if (obj == null || sessionId == null || sessionId == "") {
         console.error("object is null");
         return null;
     }
 
-    let object = distributedObject.createObjectSync(sessionId, objectId);
+    let object = distributedObject.createObjectSync(sessionId, objectId, durable);
     if (object == null) {
         console.error("create fail");
         return null;
     }
+    return attachSession(obj, object, sessionId, durable);
+}
+
+// make the native object a proxy of the plain values in obj
+function attachSession(obj, object, sessionId, durable) {
+    let keys = Object.keys(obj);
+    // decoded values by key, patched when the native side reports paths under the key as changed
+    let cache = new Map();
+    // by key the raw values of its paths as last written or read, to put only what differs and
+    // to delete the paths a write leaves behind
+    let stored = new Map();
+    Object.defineProperty(object, CACHE_INVALIDATOR, {
+        value: function (sessionId, changeData) {
+            if (changeData == null || changeData == undefined) {
+                cache.clear();
+                stored.clear();
+                return;
+            }
+            // containers before their elements, so new elements have a parent to land in
+            let paths = changeData.slice().sort((a, b) => a.split(PATH_SEPARATOR).length -
+                b.split(PATH_SEPARATOR).length);
+            paths.forEach(path => {
+                let key = childName(path.split(PATH_SEPARATOR)[0]);
+                if (path != key && keys.includes(path)) {
+                    // a key holding "/" written in one piece, or a path below another key
+                    [path, key].forEach(item => {
+                        cache.delete(item);
+                        stored.delete(item);
+                    });
+                    return;
+                }
+                if (stored.has(key)) {
+                    stored.get(key).delete(path);
+                }
+                refreshPath(object, key, path, cache, stored);
+            });
+        },
+        configurable: true,
+    });
+    distributedObject.on(CHANGE_TYPE, object, object[CACHE_INVALIDATOR]);
+    // flatten the values, put every path that differs from the stored one and delete the paths
+    // the values no longer have, all in one batch
+    let write = function (record) {
+        let capabilities = distributedObject.getPeerCapabilities();
+        let paths = (capabilities & PATH_FIELDS) != 0;
+        let binary = (capabilities & BINARY_COMPLEX) != 0;
+        let values = undefined;
+        let written = new Map();
+        let changed = Object.create(null);
+        let removed = [];
+        let count = 0;
+        Object.keys(record).forEach(key => {
+            let leaves = flattenKey(key, record[key], paths, binary);
+            if (!stored.has(key)) {
+                values = values != undefined ? values : object.getAll();
+                stored.set(key, pathsOf(key, keys, values));
+            }
+            let previous = stored.get(key);
+            leaves.forEach((value, path) => {
+                if (previous.has(path) && previous.get(path) === value) {
+                    return;
+                }
+                changed[path] = value;
+                count++;
+            });
+            previous.forEach((value, path) => {
+                if (!leaves.has(path)) {
+                    removed.push(path);
+                }
+            });
+            written.set(key, leaves);
+        });
+        if (count > 0 || removed.length > 0) {
+            let ret = object.putAll(changed, removed);
+            if (ret !== 0) {
+                // nothing of the batch was stored, the next read goes to the store
+                console.error("put " + count + " paths failed " + ret);
+                Object.keys(record).forEach(key => cache.delete(key));
+                return;
+            }
+        }
+        written.forEach((leaves, key) => {
+            stored.set(key, leaves);
+            if ([...leaves.values()].some(value => typeof value == "object")) {
+                // decoded natively, let the next read see what was stored
+                cache.delete(key);
+                return;
+            }
+            // a copy decoded from what was stored, later edits of the caller's value do not show through
+            let root = leaves.has(escapeName(key)) ? escapeName(key) : key;
+            cache.set(key, readPath(path => leaves.get(path), root, new Map()));
+        });
+        console.info("put " + count + " paths, deleted " + removed.length);
+    };
+    Object.defineProperty(object, READ_ALL, {
+        value: function () {
+            let values = undefined;
+            let result = {};
+            Object.keys(obj).forEach(key => {
+                if (cache.has(key)) {
+                    result[key] = cloneValue(cache.get(key));
+                    return;
+                }
+                if (values == undefined) {
+                    values = object.getAll();
+                }
+                let paths = new Map();
+                result[key] = readValue(object, key, keys, paths, values);
+                stored.set(key, paths);
+                cache.set(key, result[key]);
+                result[key] = cloneValue(result[key]);
+            });
+            return result;
+        },
+        configurable: true,
+    });
+    let initial = {};
+    // a durable session reopened after a restart keeps what it stored, the initial values only fill gaps
+    let restored = durable ? object.getAll() : {};
     Object.keys(obj).forEach(key => {
         console.info("start define " + key);
         Object.defineProperty(object, key, {
@@ -111,40 +530,26 @@ function joinSession(obj, objectId, sessionId) {
             configurable: true,
             get: function () {
                 console.info("start get " + key);
-                let result = object.get(key);
-                console.info("get " + result);
-                if (typeof result == "string") {
-                    if (result.startsWith(STRING_TYPE)) {
-                        result = result.substr(STRING_TYPE.length);
-                    } else if (result.startsWith(COMPLEX_TYPE)) {
-                        result = JSON.parse(result.substr(COMPLEX_TYPE.length))
-                    } else {
-                        console.error("error type " + result);
-                    }
+                if (cache.has(key)) {
+                    return cloneValue(cache.get(key));
                 }
-                console.info("get " + result + " success");
-                return result;
+                let paths = new Map();
+                let result = readValue(object, key, keys, paths);
+                console.info("get " + key + " success");
+                stored.set(key, paths);
+                cache.set(key, result);
+                return cloneValue(result);
             },
             set: function (newValue) {
-                console.info("start set " + key + " " + newValue);
-                if (typeof newValue == "object") {
-                    let value = COMPLEX_TYPE + JSON.stringify(newValue);
-                    object.put(key, value);
-                    console.info("set " + key + " " + value);
-                } else if (typeof newValue == "string") {
-                    let value = STRING_TYPE + newValue;
-                    object.put(key, value);
-                    console.info("set " + key + " " + value);
-                } else {
-                    object.put(key, newValue);
-                    console.info("set " + key + " " + newValue);
-                }
+                console.info("start set " + key);
+                write({ [key]: newValue });
             }
         });
-        if (obj[key] != undefined) {
-            object[key] = obj[key];
+        if (obj[key] != undefined && restored[key] === undefined && restored[escapeName(key)] === undefined) {
+            initial[key] = obj[key];
         }
     });
+    write(initial);
 
     Object.defineProperty(object, SESSION_ID, {
         value: sessionId,
@@ -155,28 +560,60 @@ function joinSession(obj, objectId, sessionId) {
 
 function leaveSession(obj) {
     console.info("start leaveSession");
+    if (!detachSession(obj)) {
+        return;
+    }
+    // disconnect,delete object
+    distributedObject.destroyObjectSync(obj);
+    delete obj[SESSION_ID];
+}
+
+function leaveSessionAsync(obj) {
+    console.info("start leaveSessionAsync");
+    if (!detachSession(obj)) {
+        return Promise.resolve();
+    }
+    let destroyed = distributedObject.destroyObject(obj);
+    delete obj[SESSION_ID];
+    return destroyed;
+}
+
+// turn the proxied values back into plain ones, returns false when obj is not in a session
+function detachSession(obj) {
     if (obj == null || obj[SESSION_ID] == null || obj[SESSION_ID] == "") {
         console.warn("object is null");
-        return;
+        return false;
     }
+    let values = obj[READ_ALL] != undefined ? obj[READ_ALL]() : obj;
     Object.keys(obj).forEach(key => {
         Object.defineProperty(obj, key, {
-            value: obj[key],
+            value: values[key],
             configurable: true,
             writable: true,
             enumerable: true,
         });
     });
-    // disconnect,delete object
-    distributedObject.destroyObjectSync(obj);
-    delete obj[SESSION_ID];
+    return true;
 }
 
 function onWatch(type, obj, callback) {
     console.info("start on " + obj[SESSION_ID]);
     if (obj[SESSION_ID] != null && obj[SESSION_ID] != undefined && obj[SESSION_ID].length > 0) {
         distributedObject.on(type, obj, callback);
+        if (type == CHANGE_TYPE) {
+            watchCache(obj);
+        }
+    }
+}
+
+// handlers run newest first, keep the cache invalidator the newest so that
+// user callbacks never read a value the change has already replaced
+function watchCache(obj) {
+    if (obj[CACHE_INVALIDATOR] == undefined) {
+        return;
     }
+    distributedObject.off(CHANGE_TYPE, obj, obj[CACHE_INVALIDATOR]);
+    distributedObject.on(CHANGE_TYPE, obj, obj[CACHE_INVALIDATOR]);
 }
 
 function offWatch(type, obj, callback = undefined) {
@@ -186,6 +623,9 @@ function offWatch(type, obj, callback = undefined) {
             distributedObject.off(type, obj, callback);
         } else {
             distributedObject.off(type, obj);
+            if (type == CHANGE_TYPE) {
+                watchCache(obj);
+            }
         }
 
     }
@@ -193,5 +633,9 @@ function offWatch(type, obj, callback = undefined) {
 
 export default {
     createDistributedObject: newDistributed,
-    genSessionId: randomNum
+    genSessionId: randomNum,
+    getStatistics: getStatistics,
+    setTraceEnabled: setTraceEnabled,
+    exportTrace: exportTrace,
+    setMemoryBudget: setMemoryBudget
 }
\ No newline at end of file